@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An alternate language catalog is a parsed PO file together with an index
+ * of its messages. Catalogs are shared: every panel that opens the same
+ * file gets a reference to the same catalog, and a file is parsed only
+ * once even if it is requested again while it is being parsed.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-alternate-language-catalog.h"
+#include "gtr-debug.h"
+#include "gtr-header.h"
+#include "gtr-po.h"
+
+struct _GtrAlternateLangCatalog
+{
+  gint ref_count;
+
+  gchar *uri;
+  GFile *file;
+
+  GtrPo *po;
+  gchar *name;
+
+  /* (msgctxt, msgid) key -> GtrMsg of po */
+  GHashTable *index;
+
+  /* Tasks waiting for the file to be parsed, NULL once it is */
+  GList *pending;
+  guint loaded : 1;
+};
+
+/* uri -> GtrAlternateLangCatalog, not owned */
+G_LOCK_DEFINE_STATIC (catalogs);
+static GHashTable *catalogs = NULL;
+
+/* Same key as the one gettext uses for messages with a context */
+static gchar *
+message_key (GtrMsg *msg)
+{
+  const gchar *msgctxt;
+
+  msgctxt = gtr_msg_get_msgctxt (msg);
+  if (msgctxt == NULL)
+    return g_strdup (gtr_msg_get_msgid (msg));
+
+  return g_strconcat (msgctxt, "\004", gtr_msg_get_msgid (msg), NULL);
+}
+
+static void
+build_index (GtrAlternateLangCatalog *catalog)
+{
+  GList *l;
+
+  catalog->index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, NULL);
+
+  for (l = gtr_po_get_messages (catalog->po); l != NULL; l = g_list_next (l))
+    {
+      gchar *key = message_key (l->data);
+
+      /* Keep the first message if a key is repeated */
+      if (!g_hash_table_contains (catalog->index, key))
+        g_hash_table_insert (catalog->index, key, l->data);
+      else
+        g_free (key);
+    }
+}
+
+static void
+parse_thread (GTask        *task,
+              gpointer      source_object,
+              gpointer      task_data,
+              GCancellable *cancellable)
+{
+  GtrAlternateLangCatalog *catalog = task_data;
+  GtrHeader *header;
+  GError *error = NULL;
+  GtrPo *po;
+
+  po = gtr_po_new ();
+
+  /* gtr_po_parse() drops the po when it fails */
+  if (!gtr_po_parse (po, catalog->file, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  /* Messages recovered by gettext are still usable */
+  if (error != NULL)
+    {
+      DEBUG_PRINT ("%s: %s", catalog->uri, error->message);
+      g_error_free (error);
+    }
+
+  catalog->po = po;
+  build_index (catalog);
+
+  header = gtr_po_get_header (po);
+  catalog->name = gtr_header_get_language (header);
+  if (catalog->name == NULL || *catalog->name == '\0')
+    {
+      g_free (catalog->name);
+      catalog->name = g_file_get_basename (catalog->file);
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+parse_ready_cb (GObject      *source_object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  GtrAlternateLangCatalog *catalog = user_data;
+  GError *error = NULL;
+  GList *pending, *l;
+
+  g_task_propagate_boolean (G_TASK (result), &error);
+
+  pending = catalog->pending;
+  catalog->pending = NULL;
+
+  if (error != NULL)
+    {
+      /* Let the next request try again */
+      G_LOCK (catalogs);
+      if (g_hash_table_lookup (catalogs, catalog->uri) == catalog)
+        g_hash_table_remove (catalogs, catalog->uri);
+      G_UNLOCK (catalogs);
+    }
+  else
+    catalog->loaded = TRUE;
+
+  for (l = pending; l != NULL; l = g_list_next (l))
+    {
+      GTask *task = l->data;
+
+      if (error != NULL)
+        g_task_return_error (task, g_error_copy (error));
+      else
+        g_task_return_pointer (task,
+                               gtr_alternate_lang_catalog_ref (catalog),
+                               (GDestroyNotify) gtr_alternate_lang_catalog_unref);
+    }
+
+  g_list_free_full (pending, g_object_unref);
+  g_clear_error (&error);
+  gtr_alternate_lang_catalog_unref (catalog);
+}
+
+/**
+ * gtr_alternate_lang_catalog_load_async:
+ * @file: the PO file
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called once the catalog can be used
+ * @user_data: data for @callback
+ *
+ * Gets the catalog of @file, parsing it on a worker thread unless another
+ * panel already opened it.
+ */
+void
+gtr_alternate_lang_catalog_load_async (GFile               *file,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  GtrAlternateLangCatalog *catalog;
+  GTask *task;
+  gchar *uri;
+
+  g_return_if_fail (G_IS_FILE (file));
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_alternate_lang_catalog_load_async);
+
+  uri = g_file_get_uri (file);
+
+  G_LOCK (catalogs);
+
+  if (catalogs == NULL)
+    catalogs = g_hash_table_new (g_str_hash, g_str_equal);
+
+  catalog = g_hash_table_lookup (catalogs, uri);
+  if (catalog != NULL)
+    catalog->ref_count++;
+
+  G_UNLOCK (catalogs);
+
+  if (catalog != NULL)
+    {
+      g_free (uri);
+
+      if (catalog->loaded)
+        {
+          g_task_return_pointer (task, catalog,
+                                 (GDestroyNotify) gtr_alternate_lang_catalog_unref);
+          g_object_unref (task);
+        }
+      else
+        {
+          /* Still being parsed, the parse task keeps it alive */
+          catalog->pending = g_list_append (catalog->pending, task);
+          gtr_alternate_lang_catalog_unref (catalog);
+        }
+
+      return;
+    }
+
+  catalog = g_slice_new0 (GtrAlternateLangCatalog);
+  catalog->ref_count = 1;
+  catalog->uri = uri;
+  catalog->file = g_object_ref (file);
+  catalog->pending = g_list_append (NULL, task);
+
+  G_LOCK (catalogs);
+  g_hash_table_insert (catalogs, catalog->uri, catalog);
+  G_UNLOCK (catalogs);
+
+  /* The parse task owns the first reference until parse_ready_cb() */
+  task = g_task_new (NULL, NULL, parse_ready_cb, catalog);
+  g_task_set_task_data (task, catalog, NULL);
+  g_task_run_in_thread (task, parse_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gtr_alternate_lang_catalog_load_finish:
+ * @result: a #GAsyncResult
+ * @error: a #GError
+ *
+ * Returns: (transfer full): the catalog, or %NULL if the file could not be
+ * parsed.
+ */
+GtrAlternateLangCatalog *
+gtr_alternate_lang_catalog_load_finish (GAsyncResult  *result,
+                                        GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+GtrAlternateLangCatalog *
+gtr_alternate_lang_catalog_ref (GtrAlternateLangCatalog *catalog)
+{
+  g_return_val_if_fail (catalog != NULL, NULL);
+
+  G_LOCK (catalogs);
+  catalog->ref_count++;
+  G_UNLOCK (catalogs);
+
+  return catalog;
+}
+
+void
+gtr_alternate_lang_catalog_unref (GtrAlternateLangCatalog *catalog)
+{
+  gboolean last;
+
+  g_return_if_fail (catalog != NULL);
+
+  /* The table is checked under the same lock, so a catalog can't be
+   * found again once it is being freed */
+  G_LOCK (catalogs);
+  last = --catalog->ref_count == 0;
+  if (last && g_hash_table_lookup (catalogs, catalog->uri) == catalog)
+    g_hash_table_remove (catalogs, catalog->uri);
+  G_UNLOCK (catalogs);
+
+  if (!last)
+    return;
+
+  if (catalog->index != NULL)
+    g_hash_table_destroy (catalog->index);
+  g_clear_object (&catalog->po);
+  g_object_unref (catalog->file);
+  g_free (catalog->name);
+  g_free (catalog->uri);
+  g_slice_free (GtrAlternateLangCatalog, catalog);
+}
+
+/**
+ * gtr_alternate_lang_catalog_get_name:
+ * @catalog: a loaded catalog
+ *
+ * Returns: the language of the catalog, or its file name if the header
+ * doesn't tell.
+ */
+const gchar *
+gtr_alternate_lang_catalog_get_name (GtrAlternateLangCatalog *catalog)
+{
+  g_return_val_if_fail (catalog != NULL, NULL);
+
+  return catalog->name;
+}
+
+/**
+ * gtr_alternate_lang_catalog_lookup:
+ * @catalog: a loaded catalog
+ * @msg: a message of the edited file
+ *
+ * Returns: (transfer none): the message of @catalog with the same context
+ * and msgid as @msg, or %NULL.
+ */
+GtrMsg *
+gtr_alternate_lang_catalog_lookup (GtrAlternateLangCatalog *catalog,
+                                   GtrMsg                  *msg)
+{
+  GtrMsg *found;
+  gchar *key;
+
+  g_return_val_if_fail (catalog != NULL, NULL);
+  g_return_val_if_fail (GTR_IS_MSG (msg), NULL);
+
+  if (catalog->index == NULL)
+    return NULL;
+
+  key = message_key (msg);
+  found = g_hash_table_lookup (catalog->index, key);
+  g_free (key);
+
+  return found;
+}
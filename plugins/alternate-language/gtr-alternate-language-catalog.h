@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ALTERNATE_LANG_CATALOG_H__
+#define __ALTERNATE_LANG_CATALOG_H__
+
+#include <gio/gio.h>
+#include "gtr-msg.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GtrAlternateLangCatalog GtrAlternateLangCatalog;
+
+void                     gtr_alternate_lang_catalog_load_async  (GFile                    *file,
+                                                                 GCancellable             *cancellable,
+                                                                 GAsyncReadyCallback       callback,
+                                                                 gpointer                  user_data);
+
+GtrAlternateLangCatalog *gtr_alternate_lang_catalog_load_finish (GAsyncResult             *result,
+                                                                 GError                  **error);
+
+GtrAlternateLangCatalog *gtr_alternate_lang_catalog_ref         (GtrAlternateLangCatalog  *catalog);
+
+void                     gtr_alternate_lang_catalog_unref       (GtrAlternateLangCatalog  *catalog);
+
+const gchar             *gtr_alternate_lang_catalog_get_name    (GtrAlternateLangCatalog  *catalog);
+
+GtrMsg                  *gtr_alternate_lang_catalog_lookup      (GtrAlternateLangCatalog  *catalog,
+                                                                 GtrMsg                   *msg);
+
+G_END_DECLS
+#endif /* __ALTERNATE_LANG_CATALOG_H__ */
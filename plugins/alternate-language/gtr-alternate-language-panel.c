@@ -20,6 +20,7 @@
 #endif
 
 #include "gtr-alternate-language-panel.h"
+#include "gtr-alternate-language-catalog.h"
 #include "gtr-file-dialogs.h"
 #include "gtr-msg.h"
 #include "gtr-po.h"
@@ -47,118 +48,265 @@ G_DEFINE_DYNAMIC_TYPE (GtrAlternateLangPanel, gtr_alternate_lang_panel, GTK_TYPE
 struct _GtrAlternateLangPanelPrivate
 {
   GtkWidget *open_button;
-  GtkWidget *close_button;
-  GtkWidget *copy_button;
-  GtkWidget *textview;
-
-  GtkWidget *status;
+  GtkWidget *placeholder;
+  GtkWidget *rows_box;
 
-  GtrPo *po;
   GtrTab *tab;
 
+  /* One AlternateLangRow per opened catalog */
+  GList *rows;
+
   gulong showed_message_id;
+};
+
+typedef struct
+{
+  GtrAlternateLangPanel *panel;
+  GtrAlternateLangCatalog *catalog;
+  GCancellable *cancellable;
+
+  GtkWidget *box;
+  GtkWidget *label;
+  GtkWidget *status;
+  GtkWidget *textview;
 
   guint text_found : 1;
-};
+} AlternateLangRow;
+
+static void showed_message_cb (GtrTab                *tab,
+                               GtrMsg                *msg,
+                               GtrAlternateLangPanel *panel);
 
 static void
-gtr_alternate_lang_panel_set_text (GtrAlternateLangPanel *panel,
-                                   const gchar           *text)
+row_set_text (AlternateLangRow *row,
+              const gchar      *text)
 {
   GtkTextBuffer *buf;
 
-  buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (panel->priv->textview));
+  buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (row->textview));
 
   gtk_text_buffer_set_text (buf, text, -1);
 }
 
 static void
-showed_message_cb (GtrTab * tab, GtrMsg * msg, GtrAlternateLangPanel * panel)
+row_show_message (AlternateLangRow *row,
+                  GtrMsg           *msg)
 {
-  GList *messages;
-  GList *l;
-  const gchar *msgid;
-  gchar *msgid_collate;
-  const gchar *string;
-  gchar *string_collate;
-  GtrMsgStatus status;
+  GtrMsg *found;
 
-  g_return_if_fail (GTR_IS_MSG (msg));
-
-  msgid = gtr_msg_get_msgid (msg);
-  msgid_collate = g_utf8_collate_key (msgid, -1);
-  messages = gtr_po_get_messages (panel->priv->po);
-  l = messages;
+  found = gtr_alternate_lang_catalog_lookup (row->catalog, msg);
 
-  do
+  if (found != NULL)
     {
-      string = gtr_msg_get_msgid (l->data);
-      string_collate = g_utf8_collate_key (string, -1);
-      if (strcmp (string_collate, msgid_collate) == 0)
+      row_set_text (row, gtr_msg_get_msgstr (found));
+      switch (gtr_msg_get_status (found))
         {
-          gtr_alternate_lang_panel_set_text (panel,
-                                             gtr_msg_get_msgstr (l->data));
-          status = gtr_msg_get_status (GTR_MSG (l->data));
-          switch (status)
-            {
-            case GTR_MSG_STATUS_TRANSLATED:
-              gtk_image_clear (GTK_IMAGE (panel->priv->status));
-              break;
-            case GTR_MSG_STATUS_FUZZY:
-              gtk_image_set_from_stock (GTK_IMAGE (panel->priv->status),
-                                        FUZZY_ICON,
-                                        GTK_ICON_SIZE_SMALL_TOOLBAR);
-              break;
-            default:
-              break;
-            }
-
-          g_free (string_collate);
-          g_free (msgid_collate);
-          panel->priv->text_found = TRUE;
-          return;
+        case GTR_MSG_STATUS_TRANSLATED:
+          gtk_image_clear (GTK_IMAGE (row->status));
+          break;
+        case GTR_MSG_STATUS_FUZZY:
+          gtk_image_set_from_stock (GTK_IMAGE (row->status),
+                                    FUZZY_ICON,
+                                    GTK_ICON_SIZE_SMALL_TOOLBAR);
+          break;
+        default:
+          break;
         }
-      g_free (string_collate);
+
+      row->text_found = TRUE;
+      return;
     }
-  while ((l = g_list_next (l)));
 
-  g_free (msgid_collate);
-  gtr_alternate_lang_panel_set_text (panel, _("Message not found"));
-  panel->priv->text_found = FALSE;
+  row_set_text (row, _("Message not found"));
+  row->text_found = FALSE;
 
   /* If we are here the status is untranslated */
-  gtk_image_set_from_stock (GTK_IMAGE (panel->priv->status),
+  gtk_image_set_from_stock (GTK_IMAGE (row->status),
                             UNTRANSLATED_ICON, GTK_ICON_SIZE_SMALL_TOOLBAR);
 }
 
 static void
-open_file (GtkWidget *dialog, GtrAlternateLangPanel *panel)
+row_show_current_message (AlternateLangRow *row)
 {
-  GFile *file;
-  gchar *po_file;
-  GtrMsg *current;
   GtrPo *current_po;
   GList *l;
+
+  current_po = gtr_tab_get_po (row->panel->priv->tab);
+  l = gtr_po_get_current_message (current_po);
+  if (l != NULL)
+    row_show_message (row, GTR_MSG (l->data));
+}
+
+static void
+row_free (AlternateLangRow *row)
+{
+  /* A pending load won't call back into a freed row */
+  g_cancellable_cancel (row->cancellable);
+  g_object_unref (row->cancellable);
+
+  if (row->catalog != NULL)
+    gtr_alternate_lang_catalog_unref (row->catalog);
+
+  g_slice_free (AlternateLangRow, row);
+}
+
+static void
+remove_row (AlternateLangRow *row)
+{
+  GtrAlternateLangPanel *panel = row->panel;
+
+  panel->priv->rows = g_list_remove (panel->priv->rows, row);
+  gtk_widget_destroy (row->box);
+  row_free (row);
+
+  if (panel->priv->rows != NULL)
+    return;
+
+  gtk_widget_show (panel->priv->placeholder);
+
+  if (panel->priv->showed_message_id)
+    {
+      g_signal_handler_disconnect (panel->priv->tab,
+                                   panel->priv->showed_message_id);
+      panel->priv->showed_message_id = 0;
+    }
+}
+
+static void
+close_button_clicked_cb (GtkWidget        *close_button,
+                         AlternateLangRow *row)
+{
+  remove_row (row);
+}
+
+static void
+copy_button_clicked_cb (GtkWidget        *copy_button,
+                        AlternateLangRow *row)
+{
+  GtkTextBuffer *panel_buf, *buf;
+  GtkTextIter start, end;
+  GtrView *view;
+  gchar *text;
+
+  if (!row->text_found)
+    return;
+
+  panel_buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (row->textview));
+  gtk_text_buffer_get_bounds (panel_buf, &start, &end);
+
+  text = gtk_text_buffer_get_text (panel_buf, &start, &end, FALSE);
+
+  view = gtr_tab_get_active_view (row->panel->priv->tab);
+  buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+  gtk_text_buffer_begin_user_action (buf);
+  gtk_text_buffer_set_text (buf, text, -1);
+  gtk_text_buffer_end_user_action (buf);
+
+  g_free (text);
+}
+
+static AlternateLangRow *
+add_row (GtrAlternateLangPanel *panel,
+         GFile                 *file)
+{
+  AlternateLangRow *row;
+  GtkWidget *hbox;
+  GtkWidget *button;
+  GtkWidget *scroll;
+  gchar *name;
+
+  row = g_slice_new0 (AlternateLangRow);
+  row->panel = panel;
+  row->cancellable = g_cancellable_new ();
+
+  row->box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 3);
+  gtk_widget_show (row->box);
+
+  /* Header: language, status and buttons */
+  hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_widget_show (hbox);
+  gtk_box_pack_start (GTK_BOX (row->box), hbox, FALSE, TRUE, 0);
+
+  name = g_file_get_basename (file);
+  row->label = gtk_label_new (name);
+  g_free (name);
+  gtk_misc_set_alignment (GTK_MISC (row->label), 0.0, 0.5);
+  gtk_label_set_ellipsize (GTK_LABEL (row->label), PANGO_ELLIPSIZE_END);
+  gtk_widget_show (row->label);
+  gtk_box_pack_start (GTK_BOX (hbox), row->label, TRUE, TRUE, 0);
+
+  row->status = gtk_image_new ();
+  gtk_widget_show (row->status);
+  gtk_box_pack_start (GTK_BOX (hbox), row->status, FALSE, FALSE, 0);
+
+  button = gtr_gtk_button_new_with_stock_icon (_("Co_py"), GTK_STOCK_COPY);
+  g_signal_connect (button, "clicked",
+                    G_CALLBACK (copy_button_clicked_cb), row);
+  gtk_widget_show (button);
+  gtk_box_pack_start (GTK_BOX (hbox), button, FALSE, FALSE, 0);
+
+  button = gtr_gtk_button_new_with_stock_icon (_("_Close"), GTK_STOCK_CLOSE);
+  g_signal_connect (button, "clicked",
+                    G_CALLBACK (close_button_clicked_cb), row);
+  gtk_widget_show (button);
+  gtk_box_pack_start (GTK_BOX (hbox), button, FALSE, FALSE, 0);
+
+  /* Text view */
+  scroll = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scroll),
+                                       GTK_SHADOW_IN);
+  gtk_widget_show (scroll);
+  gtk_box_pack_start (GTK_BOX (row->box), scroll, TRUE, TRUE, 0);
+
+  row->textview = gtr_view_new ();
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (row->textview),
+                               GTK_WRAP_WORD);
+  gtk_text_view_set_editable (GTK_TEXT_VIEW (row->textview), FALSE);
+  row_set_text (row, _("Loading…"));
+  gtk_widget_set_sensitive (row->textview, FALSE);
+  gtk_widget_show (row->textview);
+  gtk_container_add (GTK_CONTAINER (scroll), row->textview);
+
+  gtk_box_pack_start (GTK_BOX (panel->priv->rows_box), row->box,
+                      TRUE, TRUE, 0);
+  gtk_widget_hide (panel->priv->placeholder);
+
+  panel->priv->rows = g_list_append (panel->priv->rows, row);
+
+  return row;
+}
+
+static void
+load_ready_cb (GObject      *source_object,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  AlternateLangRow *row = user_data;
+  GtrAlternateLangPanel *panel;
+  GtrAlternateLangCatalog *catalog;
   GError *error = NULL;
 
-  po_file = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
-  file = g_file_new_for_path (po_file);
-  g_free (po_file);
+  catalog = gtr_alternate_lang_catalog_load_finish (result, &error);
 
-  if (panel->priv->po != NULL)
-    g_object_unref (panel->priv->po);
-  panel->priv->po = gtr_po_new ();
-  gtr_po_parse (panel->priv->po, file, &error);
+  /* The row was closed, and freed, while the file was being parsed */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      return;
+    }
 
-  g_object_unref (file);
+  panel = row->panel;
 
   if (error != NULL)
     {
+      GtkWidget *toplevel;
       GtkWidget *erdialog;
-      /*
-       * FIXME: We have to get the window
-       */
-      erdialog = gtk_message_dialog_new (NULL,
+
+      remove_row (row);
+
+      toplevel = gtk_widget_get_toplevel (GTK_WIDGET (panel));
+      erdialog = gtk_message_dialog_new (gtk_widget_is_toplevel (toplevel) ?
+                                         GTK_WINDOW (toplevel) : NULL,
                                          GTK_DIALOG_DESTROY_WITH_PARENT,
                                          GTK_MESSAGE_ERROR,
                                          GTK_BUTTONS_CLOSE,
@@ -169,16 +317,54 @@ open_file (GtkWidget *dialog, GtrAlternateLangPanel *panel)
       return;
     }
 
-  panel->priv->showed_message_id =
-    g_signal_connect (panel->priv->tab, "showed-message",
-                      G_CALLBACK (showed_message_cb), panel);
+  row->catalog = catalog;
+  gtk_label_set_text (GTK_LABEL (row->label),
+                      gtr_alternate_lang_catalog_get_name (catalog));
+  gtk_widget_set_sensitive (row->textview, TRUE);
 
-  current_po = gtr_tab_get_po (panel->priv->tab);
-  l = gtr_po_get_current_message (current_po);
-  current = GTR_MSG (l->data);
+  if (panel->priv->showed_message_id == 0)
+    panel->priv->showed_message_id =
+      g_signal_connect (panel->priv->tab, "showed-message",
+                        G_CALLBACK (showed_message_cb), panel);
+
+  row_show_current_message (row);
+}
+
+static void
+showed_message_cb (GtrTab * tab, GtrMsg * msg, GtrAlternateLangPanel * panel)
+{
+  GList *l;
 
-  showed_message_cb (panel->priv->tab, current, panel);
-  gtk_widget_set_sensitive (panel->priv->textview, TRUE);
+  g_return_if_fail (GTR_IS_MSG (msg));
+
+  for (l = panel->priv->rows; l != NULL; l = g_list_next (l))
+    {
+      AlternateLangRow *row = l->data;
+
+      /* Still loading */
+      if (row->catalog != NULL)
+        row_show_message (row, msg);
+    }
+}
+
+static void
+open_file (GtkWidget *dialog, GtrAlternateLangPanel *panel)
+{
+  AlternateLangRow *row;
+  GFile *file;
+  gchar *po_file;
+
+  po_file = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
+  file = g_file_new_for_path (po_file);
+  g_free (po_file);
+
+  /* The file is parsed on a worker thread, or shared with the other tabs
+   * that already opened it */
+  row = add_row (panel, file);
+  gtr_alternate_lang_catalog_load_async (file, row->cancellable,
+                                         load_ready_cb, row);
+
+  g_object_unref (file);
 
   gtk_widget_destroy (dialog);
 }
@@ -244,70 +430,20 @@ open_button_clicked_cb (GtkWidget * open_button,
   gtr_file_chooser_analyse ((gpointer) dialog, panel);
 }
 
-static void
-close_button_clicked_cb (GtkWidget             *close_button,
-                         GtrAlternateLangPanel *panel)
-{
-  if (panel->priv->po != NULL)
-    {
-      gtk_image_clear (GTK_IMAGE (panel->priv->status));
-      gtr_alternate_lang_panel_set_text (panel, _("File closed"));
-
-      gtk_widget_set_sensitive (panel->priv->textview, FALSE);
-
-      g_object_unref (panel->priv->po);
-      panel->priv->po = NULL;
-      panel->priv->text_found = FALSE;
-    }
-
-  if (panel->priv->showed_message_id)
-    {
-      g_signal_handler_disconnect (panel->priv->tab,
-                                   panel->priv->showed_message_id);
-      panel->priv->showed_message_id = 0;
-    }
-}
-
-static void
-copy_button_clicked_cb (GtkWidget             *copy_button,
-                        GtrAlternateLangPanel *panel)
-{
-  GtkTextBuffer *panel_buf, *buf;
-  GtkTextIter start, end;
-  GtrView *view;
-  gchar *text;
-
-  if (!panel->priv->text_found)
-    return;
-
-  panel_buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (panel->priv->textview));
-  gtk_text_buffer_get_bounds (panel_buf, &start, &end);
-
-  text = gtk_text_buffer_get_text (panel_buf, &start, &end, FALSE);
-
-  view = gtr_tab_get_active_view (panel->priv->tab);
-  buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
-  gtk_text_buffer_begin_user_action (buf);
-  gtk_text_buffer_set_text (buf, text, -1);
-  gtk_text_buffer_end_user_action (buf);
-
-  g_free (text);
-}
-
 static void
 gtr_alternate_lang_panel_init (GtrAlternateLangPanel * panel)
 {
   GtkWidget *hbox;
   GtkWidget *buttonbox;
-  GtkWidget *scroll;
 
   panel->priv = GTR_ALTERNATE_LANG_PANEL_GET_PRIVATE (panel);
 
   panel->priv->showed_message_id = 0;
-  panel->priv->po = NULL;
+  panel->priv->rows = NULL;
 
   gtk_orientable_set_orientation (GTK_ORIENTABLE (panel),
                                   GTK_ORIENTATION_VERTICAL);
+  gtk_box_set_spacing (GTK_BOX (panel), 6);
 
   /* Hbox */
   hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
@@ -325,52 +461,21 @@ gtr_alternate_lang_panel_init (GtrAlternateLangPanel * panel)
                     "clicked", G_CALLBACK (open_button_clicked_cb), panel);
   gtk_widget_show (panel->priv->open_button);
 
-  panel->priv->close_button = gtr_gtk_button_new_with_stock_icon (_("_Close"),
-                                                                  GTK_STOCK_CLOSE);
-  g_signal_connect (panel->priv->close_button,
-                    "clicked", G_CALLBACK (close_button_clicked_cb), panel);
-  gtk_widget_show (panel->priv->close_button);
-
-  panel->priv->copy_button = gtr_gtk_button_new_with_stock_icon (_("Co_py"),
-                                                                 GTK_STOCK_COPY);
-  g_signal_connect (panel->priv->copy_button,
-                    "clicked", G_CALLBACK (copy_button_clicked_cb), panel);
-  gtk_widget_show (panel->priv->copy_button);
-
   gtk_box_pack_start (GTK_BOX (buttonbox),
                       panel->priv->open_button, TRUE, TRUE, 0);
-  gtk_box_pack_start (GTK_BOX (buttonbox),
-                      panel->priv->close_button, TRUE, TRUE, 0);
-  gtk_box_pack_start (GTK_BOX (buttonbox),
-                      panel->priv->copy_button, TRUE, TRUE, 0);
 
   gtk_box_pack_start (GTK_BOX (hbox), buttonbox, FALSE, TRUE, 0);
 
-  /* Status image */
-  panel->priv->status = gtk_image_new ();
-  gtk_widget_show (panel->priv->status);
-
-  gtk_box_pack_start (GTK_BOX (hbox), panel->priv->status, FALSE, FALSE, 0);
-
-  /* Text view */
-  scroll = gtk_scrolled_window_new (NULL, NULL);
-  gtk_widget_show (scroll);
-
-  panel->priv->textview = gtr_view_new ();
-  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (panel->priv->textview),
-                               GTK_WRAP_WORD);
-  gtk_text_view_set_editable (GTK_TEXT_VIEW (panel->priv->textview), FALSE);
-  gtr_alternate_lang_panel_set_text (panel, _("There isn’t any file loaded"));
-  gtk_widget_set_sensitive (panel->priv->textview, FALSE);
-  gtk_widget_show (panel->priv->textview);
-
-  gtk_container_add (GTK_CONTAINER (scroll), panel->priv->textview);
-
-  gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scroll),
-                                       GTK_SHADOW_IN);
-
-  gtk_box_pack_start (GTK_BOX (panel), scroll, TRUE, TRUE, 0);
+  /* Shown while no file is opened */
+  panel->priv->placeholder = gtk_label_new (_("There isn’t any file loaded"));
+  gtk_widget_show (panel->priv->placeholder);
+  gtk_box_pack_start (GTK_BOX (panel), panel->priv->placeholder,
+                      FALSE, FALSE, 0);
 
+  /* One row per opened file */
+  panel->priv->rows_box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 12);
+  gtk_widget_show (panel->priv->rows_box);
+  gtk_box_pack_start (GTK_BOX (panel), panel->priv->rows_box, TRUE, TRUE, 0);
 }
 
 static void
@@ -387,7 +492,9 @@ gtr_alternate_lang_panel_dispose (GObject *object)
       panel->priv->showed_message_id = 0;
     }
 
-  g_clear_object (&panel->priv->po);
+  /* The row widgets go away with the panel */
+  g_list_free_full (panel->priv->rows, (GDestroyNotify) row_free);
+  panel->priv->rows = NULL;
 
   G_OBJECT_CLASS (gtr_alternate_lang_panel_parent_class)->dispose (object);
 }
@@ -23,6 +23,8 @@
 #include "gtr-insert-params-plugin.h"
 #include "gtr-msg.h"
 #include "gtr-notebook.h"
+#include "gtr-po.h"
+#include "gtr-tab.h"
 #include "gtr-window.h"
 #include "gtr-window-activatable.h"
 
@@ -53,9 +55,11 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (GtrInsertParamsPlugin,
                                 G_IMPLEMENT_INTERFACE_DYNAMIC (GTR_TYPE_WINDOW_ACTIVATABLE,
                                                                gtr_window_activatable_iface_init))
 
-static GSList *tags = NULL;
+#define CACHE_KEY "GtrInsertParamsPluginCache"
+
+static gchar **tags = NULL;
 static gint tag_position;
-static GSList *params = NULL;
+static gchar **params = NULL;
 static gint param_position;
 
 static const gchar param_regex[] =
@@ -69,28 +73,202 @@ static const gchar param_regex[] =
 static const gchar tags_regex[] =
   "<[-0-9a-zA-Z=.:;_#?%()'\"/ ]+>";
 
+/* Params and tags of a message, in order and without duplicates */
+typedef struct
+{
+  gchar **params;
+  gchar **tags;
+} MsgItems;
+
+typedef struct
+{
+  GPtrArray *messages;
+  GPtrArray *msgids;
+} ExtractData;
+
+static void
+msg_items_free (MsgItems *items)
+{
+  g_strfreev (items->params);
+  g_strfreev (items->tags);
+  g_slice_free (MsgItems, items);
+}
+
+static void
+extract_data_free (ExtractData *data)
+{
+  g_ptr_array_unref (data->messages);
+  g_ptr_array_unref (data->msgids);
+  g_slice_free (ExtractData, data);
+}
+
+/* Compiled once, GRegex can be shared between threads */
+static GRegex *
+get_regex (const gchar *pattern,
+           gsize       *regex)
+{
+  if (g_once_init_enter (regex))
+    g_once_init_leave (regex,
+                       (gsize) g_regex_new (pattern, G_REGEX_OPTIMIZE, 0, NULL));
+
+  return (GRegex *) *regex;
+}
+
+static gchar **
+extract_matches (GRegex      *regex,
+                 const gchar *text,
+                 gboolean     unique)
+{
+  GMatchInfo *match_info;
+  GHashTable *seen = NULL;
+  GPtrArray *matches;
+
+  matches = g_ptr_array_new ();
+  if (unique)
+    seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  g_regex_match (regex, text, 0, &match_info);
+  while (g_match_info_matches (match_info))
+    {
+      gchar *word = g_match_info_fetch (match_info, 0);
+
+      if (seen == NULL || g_hash_table_add (seen, word))
+        g_ptr_array_add (matches, word);
+      else
+        g_free (word);
+
+      g_match_info_next (match_info, NULL);
+    }
+  g_match_info_free (match_info);
+
+  if (seen != NULL)
+    g_hash_table_destroy (seen);
+
+  g_ptr_array_add (matches, NULL);
+
+  return (gchar **) g_ptr_array_free (matches, FALSE);
+}
+
+/* Also meant for the translations, e.g. to check that they keep the
+ * params of the original */
+static MsgItems *
+extract_items (const gchar *text)
+{
+  static gsize params_regex_once = 0;
+  static gsize tags_regex_once = 0;
+  MsgItems *items;
+
+  items = g_slice_new (MsgItems);
+  items->params = extract_matches (get_regex (param_regex, &params_regex_once),
+                                   text, TRUE);
+  items->tags = extract_matches (get_regex (tags_regex, &tags_regex_once),
+                                 text, FALSE);
+
+  return items;
+}
+
+static void
+extract_thread (GTask        *task,
+                gpointer      source_object,
+                gpointer      task_data,
+                GCancellable *cancellable)
+{
+  ExtractData *data = task_data;
+  GHashTable *cache;
+  guint i;
+
+  cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                 g_object_unref,
+                                 (GDestroyNotify) msg_items_free);
+
+  for (i = 0; i < data->messages->len; i++)
+    {
+      if (g_task_return_error_if_cancelled (task))
+        {
+          g_hash_table_unref (cache);
+          return;
+        }
+
+      g_hash_table_insert (cache,
+                           g_object_ref (g_ptr_array_index (data->messages, i)),
+                           extract_items (g_ptr_array_index (data->msgids, i)));
+    }
+
+  g_task_return_pointer (task, cache, (GDestroyNotify) g_hash_table_unref);
+}
+
+static void
+extract_ready_cb (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GHashTable *cache;
+
+  cache = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (cache != NULL)
+    g_object_set_data_full (source_object, CACHE_KEY, cache,
+                            (GDestroyNotify) g_hash_table_unref);
+}
+
+/* Extracts the params and tags of every message of the tab on a worker
+ * thread, so showing a message only has to look them up */
 static void
-process_item (GtrWindow * window, GSList * items, gint * item_position)
+extract_tab_items (GtrTab *tab)
+{
+  ExtractData *data;
+  GCancellable *cancellable;
+  GTask *task;
+  GtrPo *po;
+  GList *l;
+
+  po = gtr_tab_get_po (tab);
+  if (po == NULL)
+    return;
+
+  /* The msgids live in the po, which is freed when the tab is closed,
+   * so the worker gets copies */
+  data = g_slice_new (ExtractData);
+  data->messages = g_ptr_array_new_with_free_func (g_object_unref);
+  data->msgids = g_ptr_array_new_with_free_func (g_free);
+
+  for (l = gtr_po_get_messages (po); l != NULL; l = g_list_next (l))
+    {
+      g_ptr_array_add (data->messages, g_object_ref (l->data));
+      g_ptr_array_add (data->msgids, g_strdup (gtr_msg_get_msgid (l->data)));
+    }
+
+  /* No need to go on once the tab is closed */
+  cancellable = g_cancellable_new ();
+  g_signal_connect_object (tab, "destroy",
+                           G_CALLBACK (g_cancellable_cancel), cancellable,
+                           G_CONNECT_SWAPPED);
+
+  task = g_task_new (tab, cancellable, extract_ready_cb, NULL);
+  g_task_set_task_data (task, data, (GDestroyNotify) extract_data_free);
+  g_task_run_in_thread (task, extract_thread);
+  g_object_unref (task);
+  g_object_unref (cancellable);
+}
+
+static void
+process_item (GtrWindow * window, gchar ** items, gint * item_position)
 {
   GtrView *view;
   GtkTextBuffer *buffer;
-  GSList *item;
 
-  if (items == NULL)
+  if (items == NULL || items[0] == NULL)
     return;
 
-  if (*item_position >= g_slist_length (items))
+  if (*item_position >= g_strv_length (items))
     *item_position = 0;
 
-  item = g_slist_nth (items, *item_position);
-
   view = gtr_window_get_active_view (window);
 
   buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
 
   gtk_text_buffer_begin_user_action (buffer);
   gtk_text_buffer_insert_at_cursor (buffer,
-                                    (const gchar *) item->data,
+                                    items[*item_position],
                                     -1);
   gtk_text_buffer_end_user_action (buffer);
 
@@ -185,10 +363,8 @@ gtr_insert_params_plugin_dispose (GObject *object)
 static void
 gtr_insert_params_plugin_finalize (GObject *object)
 {
-  g_slist_free_full (params, g_free);
-  params = NULL;
-  g_slist_free_full (tags, g_free);
-  tags = NULL;
+  g_clear_pointer (&params, g_strfreev);
+  g_clear_pointer (&tags, g_strfreev);
 
   G_OBJECT_CLASS (gtr_insert_params_plugin_parent_class)->finalize (object);
 }
@@ -254,13 +430,13 @@ on_menuitem_activated (GtkMenuItem * item, GtrWindow * window)
 }
 
 static void
-parse_item_list (GtrWindow * window, GSList * items, const char * name)
+parse_item_list (GtrWindow * window, gchar ** items, const char * name)
 {
   GtkUIManager *manager;
   GtkWidget *insert_items, *next_item;
   GtkWidget *menuitem;
   GtkWidget *menu;
-  GSList *i = items;
+  gchar **i;
   gchar *insert_items_string;
   gchar *next_item_string;
 
@@ -277,7 +453,7 @@ parse_item_list (GtrWindow * window, GSList * items, const char * name)
   g_free (insert_items_string);
   g_free (next_item_string);
 
-  if (items == NULL)
+  if (items == NULL || items[0] == NULL)
     {
       gtk_menu_item_set_submenu (GTK_MENU_ITEM (insert_items), NULL);
       gtk_widget_set_sensitive (insert_items, FALSE);
@@ -289,9 +465,9 @@ parse_item_list (GtrWindow * window, GSList * items, const char * name)
   gtk_widget_set_sensitive (next_item, TRUE);
 
   menu = gtk_menu_new ();
-  do
+  for (i = items; *i != NULL; i++)
     {
-      menuitem = gtk_menu_item_new_with_label ((const gchar *) i->data);
+      menuitem = gtk_menu_item_new_with_label (*i);
       gtk_widget_show (menuitem);
 
       g_signal_connect (menuitem, "activate",
@@ -299,7 +475,6 @@ parse_item_list (GtrWindow * window, GSList * items, const char * name)
 
       gtk_menu_shell_append (GTK_MENU_SHELL (menu), menuitem);
     }
-  while ((i = g_slist_next (i)));
 
   gtk_menu_item_set_submenu (GTK_MENU_ITEM (insert_items), menu);
 }
@@ -319,16 +494,11 @@ parse_tag_list (GtrWindow * window)
 static void
 showed_message_cb (GtrTab * tab, GtrMsg * msg, GtrWindow * window)
 {
-  const gchar *msgid;
-  GRegex *regex;
-  GMatchInfo *match_info;
-  gchar *word;
-  gint i;
+  GHashTable *cache;
+  MsgItems *items;
 
-  g_slist_free_full (params, g_free);
-  params = NULL;
-  g_slist_free_full (tags, g_free);
-  tags = NULL;
+  g_clear_pointer (&params, g_strfreev);
+  g_clear_pointer (&tags, g_strfreev);
 
   /*
    * If we show another message we have to restart the index
@@ -337,60 +507,22 @@ showed_message_cb (GtrTab * tab, GtrMsg * msg, GtrWindow * window)
   param_position = 0;
   tag_position = 0;
 
-  msgid = gtr_msg_get_msgid (msg);
+  cache = g_object_get_data (G_OBJECT (tab), CACHE_KEY);
+  items = cache != NULL ? g_hash_table_lookup (cache, msg) : NULL;
 
-  /*
-   * Regular expression for params
-   */
-  regex = g_regex_new (param_regex, 0, 0, NULL);
-  g_regex_match (regex, msgid, 0, &match_info);
-  while (g_match_info_matches (match_info))
+  if (items != NULL)
     {
-      gchar *word_collate;
-
-      word = g_match_info_fetch (match_info, 0);
-      word_collate = g_utf8_collate_key (word, -1);
-      for (i = 0; i < g_slist_length (params); i++)
-        {
-          gchar *param_collate;
-          gchar *param = g_slist_nth_data (params, i);
-
-          param_collate = g_utf8_collate_key (param, -1);
-          if (strcmp (param_collate, word_collate) == 0)
-            {
-              g_free (word);
-              word = NULL;
-            }
-          g_free (param_collate);
-        }
-      g_free (word_collate);
-
-      if (word != NULL)
-        params = g_slist_prepend (params, word);
-      g_match_info_next (match_info, NULL);
+      params = g_strdupv (items->params);
+      tags = g_strdupv (items->tags);
     }
-  params = g_slist_reverse (params);
-
-  g_match_info_free (match_info);
-  g_regex_unref (regex);
-
-  /*
-   * Regular expression for tags
-   */
-  regex = g_regex_new (tags_regex, 0, 0, NULL);
-  g_regex_match (regex, msgid, 0, &match_info);
-  while (g_match_info_matches (match_info))
+  else
     {
-      gchar *word;
-
-      word = g_match_info_fetch (match_info, 0);
-      tags = g_slist_prepend (tags, word);
-      g_match_info_next (match_info, NULL);
+      /* The cache is still being built */
+      items = extract_items (gtr_msg_get_msgid (msg));
+      params = g_steal_pointer (&items->params);
+      tags = g_steal_pointer (&items->tags);
+      msg_items_free (items);
     }
-  tags = g_slist_reverse (tags);
-
-  g_match_info_free (match_info);
-  g_regex_unref (regex);
 
   parse_param_list (window);
   parse_tag_list (window);
@@ -402,6 +534,8 @@ page_added_cb (GtkNotebook * notebook,
 {
   g_signal_connect (child, "showed-message",
                     G_CALLBACK (showed_message_cb), window);
+
+  extract_tab_items (GTR_TAB (child));
 }
 
 static void
@@ -450,6 +584,8 @@ gtr_insert_params_plugin_activate (GtrWindowActivatable *activatable)
     {
       g_signal_connect (tabs->data, "showed-message",
                         G_CALLBACK (showed_message_cb), priv->window);
+
+      extract_tab_items (GTR_TAB (tabs->data));
     }
   while ((tabs = g_list_next (tabs)));
 }
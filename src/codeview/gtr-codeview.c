@@ -24,6 +24,8 @@
 #include "gtr-codeview.h"
 #include "gtr-context.h"
 #include "gtr-dirs.h"
+#include "gtr-source-cache.h"
+#include "gtr-source-index.h"
 #include "gtr-utils.h"
 #include "gtr-viewer.h"
 #include "gtr-window.h"
@@ -33,7 +35,6 @@
 #include <gtk/gtk.h>
 #include <string.h>
 #include <gio/gio.h>
-#include <ctype.h>
 
 typedef struct
 {
@@ -54,6 +55,8 @@ enum
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtrCodeView, gtr_code_view, G_TYPE_OBJECT)
 
+#define SOURCE_INDEX_KEY "GtrCodeViewSourceIndex"
+
 static void
 insert_link (GtkTextBuffer *buffer,
              GtkTextIter   *iter,
@@ -110,39 +113,17 @@ real_path (const gchar *path)
 static int
 get_line_for_text (const gchar *path, const gchar *msgid)
 {
-  gchar *content, *str_found, *i, *escaped;
-  int result;
-
-  content = NULL;
-  result = 1;
-  escaped = g_markup_escape_text (msgid, -1);
+  GtrSourceFile *file;
+  int result = 0;
 
-  if (!g_file_get_contents (path, &content, NULL, NULL))
-    goto out;
-
-  i = content;
-  while ((str_found = g_strstr_len (i, -1, escaped)))
+  file = gtr_source_cache_get (path, NULL);
+  if (file != NULL)
     {
-      gchar c;
-
-      i = str_found + strlen (escaped);
-      c = *i;
-      if (!isalpha (c) &&
-          !isalpha (*(str_found - 1)) && !(c == ':') && !(c == '_'))
-        break;
+      result = gtr_source_file_find_msgid (file, msgid);
+      gtr_source_file_unref (file);
     }
-  if (!str_found)
-    goto out;
 
-  for (i = content; i < str_found; i++)
-    if (*i == '\n')
-      result++;
-
-out:
-  g_free (content);
-  g_free (escaped);
-
-  return result;
+  return result > 0 ? result : 1;
 }
 
 static void
@@ -154,6 +135,7 @@ follow_if_link (GtrCodeView *codeview, GtkWidget *text_view, GtkTextIter *iter)
   gchar *fullpath;
   gchar *dirname;
   GFile *location, *parent;
+  GtrSourceIndex *index;
   GtrCodeViewPrivate *priv = gtr_code_view_get_instance_private (codeview);
 
   tab = gtr_window_get_active_tab (priv->window);
@@ -161,6 +143,7 @@ follow_if_link (GtrCodeView *codeview, GtkWidget *text_view, GtkTextIter *iter)
   if (!tab)
     return;
   po = gtr_tab_get_po (tab);
+  index = g_object_get_data (G_OBJECT (tab), SOURCE_INDEX_KEY);
 
   location = gtr_po_get_location (po);
   parent = g_file_get_parent (location);
@@ -187,7 +170,9 @@ follow_if_link (GtrCodeView *codeview, GtkWidget *text_view, GtkTextIter *iter)
           fullpath = real_path (path);
           g_free (path);
 
-          line = get_line_for_text (fullpath, msgid);
+          if (index == NULL ||
+              !gtr_source_index_lookup (index, fullpath, msgid, &line))
+            line = get_line_for_text (fullpath, msgid);
         }
 
       show_source (codeview, fullpath, line);
@@ -451,6 +436,11 @@ page_added_cb (GtkNotebook *notebook,
 
   g_return_if_fail (GTK_IS_TEXT_VIEW (view));
 
+  /* Lines of the references to UI files, found in the background */
+  g_object_set_data_full (G_OBJECT (child), SOURCE_INDEX_KEY,
+                          gtr_source_index_new (gtr_tab_get_po (GTR_TAB (child))),
+                          g_object_unref);
+
   g_signal_connect_after (child, "showed-message",
                           G_CALLBACK (showed_message_cb), codeview);
   g_signal_connect (child, "message-edition-finished",
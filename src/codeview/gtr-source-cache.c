@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Cache of the source files referenced by the messages. Files are mapped
+ * in memory and the offsets of their lines are computed once, so following
+ * a reference doesn't read nor scan the file again. An entry is dropped
+ * when the modification time or the size of the file changes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-source-cache.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+/* Files kept mapped once nobody uses them anymore */
+#define MAX_FILES 16
+
+struct _GtrSourceFile
+{
+  gint ref_count;
+
+  gchar *path;
+  GMappedFile *mapped;
+
+  /* To know if the file changed since it was mapped */
+  gint64 mtime;
+  goffset size;
+
+  /* Offset of the first byte of every line */
+  GArray *lines;
+
+  guint64 last_used;
+};
+
+G_LOCK_DEFINE_STATIC (cache);
+static GHashTable *cache = NULL;
+static guint64 use_counter = 0;
+
+static void
+compute_lines (GtrSourceFile *file)
+{
+  const gchar *contents, *p, *end;
+  gsize length;
+  gsize offset = 0;
+
+  contents = gtr_source_file_get_contents (file, &length);
+  end = contents + length;
+
+  file->lines = g_array_new (FALSE, FALSE, sizeof (gsize));
+  g_array_append_val (file->lines, offset);
+
+  for (p = contents; p < end; p++)
+    {
+      p = memchr (p, '\n', end - p);
+      if (p == NULL)
+        break;
+
+      offset = p - contents + 1;
+      g_array_append_val (file->lines, offset);
+    }
+}
+
+static GtrSourceFile *
+source_file_new (const gchar  *path,
+                 GStatBuf     *buf,
+                 GError      **error)
+{
+  GtrSourceFile *file;
+  GMappedFile *mapped;
+
+  mapped = g_mapped_file_new (path, FALSE, error);
+  if (mapped == NULL)
+    return NULL;
+
+  file = g_slice_new0 (GtrSourceFile);
+  file->ref_count = 1;
+  file->path = g_strdup (path);
+  file->mapped = mapped;
+  file->mtime = buf->st_mtime;
+  file->size = buf->st_size;
+
+  compute_lines (file);
+
+  return file;
+}
+
+static void
+evict_unused (void)
+{
+  GHashTableIter iter;
+  GtrSourceFile *file, *oldest;
+
+  while (g_hash_table_size (cache) > MAX_FILES)
+    {
+      oldest = NULL;
+
+      g_hash_table_iter_init (&iter, cache);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &file))
+        {
+          if (oldest == NULL || file->last_used < oldest->last_used)
+            oldest = file;
+        }
+
+      g_hash_table_remove (cache, oldest->path);
+    }
+}
+
+/**
+ * gtr_source_cache_get:
+ * @path: the path of a source file
+ * @error: a #GError
+ *
+ * Gets @path from the cache, mapping it again if it changed on disk.
+ *
+ * Returns: (transfer full): the file, or %NULL if it can't be read.
+ */
+GtrSourceFile *
+gtr_source_cache_get (const gchar  *path,
+                      GError      **error)
+{
+  GtrSourceFile *file;
+  GStatBuf buf;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  if (g_stat (path, &buf) != 0)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+                   "%s: %s", path, g_strerror (errsv));
+      return NULL;
+    }
+
+  G_LOCK (cache);
+
+  if (cache == NULL)
+    cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                   (GDestroyNotify) gtr_source_file_unref);
+
+  file = g_hash_table_lookup (cache, path);
+  if (file != NULL &&
+      (file->mtime != (gint64) buf.st_mtime || file->size != buf.st_size))
+    {
+      /* Whoever still uses the old mapping keeps it */
+      g_hash_table_remove (cache, path);
+      file = NULL;
+    }
+
+  if (file == NULL)
+    {
+      file = source_file_new (path, &buf, error);
+      if (file == NULL)
+        {
+          G_UNLOCK (cache);
+          return NULL;
+        }
+
+      g_hash_table_insert (cache, file->path, file);
+      file->last_used = ++use_counter;
+      evict_unused ();
+    }
+  else
+    file->last_used = ++use_counter;
+
+  g_atomic_int_inc (&file->ref_count);
+
+  G_UNLOCK (cache);
+
+  return file;
+}
+
+GtrSourceFile *
+gtr_source_file_ref (GtrSourceFile *file)
+{
+  g_return_val_if_fail (file != NULL, NULL);
+
+  g_atomic_int_inc (&file->ref_count);
+
+  return file;
+}
+
+void
+gtr_source_file_unref (GtrSourceFile *file)
+{
+  g_return_if_fail (file != NULL);
+
+  if (!g_atomic_int_dec_and_test (&file->ref_count))
+    return;
+
+  g_mapped_file_unref (file->mapped);
+  g_array_free (file->lines, TRUE);
+  g_free (file->path);
+  g_slice_free (GtrSourceFile, file);
+}
+
+/**
+ * gtr_source_file_get_contents:
+ * @file: a #GtrSourceFile
+ * @length: (out): the length of the contents
+ *
+ * Returns: the contents of @file. They are not nul-terminated.
+ */
+const gchar *
+gtr_source_file_get_contents (GtrSourceFile *file,
+                              gsize         *length)
+{
+  const gchar *contents;
+
+  g_return_val_if_fail (file != NULL, NULL);
+
+  /* Empty files are mapped to NULL */
+  contents = g_mapped_file_get_contents (file->mapped);
+  *length = contents != NULL ? g_mapped_file_get_length (file->mapped) : 0;
+
+  return contents != NULL ? contents : "";
+}
+
+guint
+gtr_source_file_get_n_lines (GtrSourceFile *file)
+{
+  g_return_val_if_fail (file != NULL, 0);
+
+  return file->lines->len;
+}
+
+/**
+ * gtr_source_file_get_line_at_offset:
+ * @file: a #GtrSourceFile
+ * @offset: a byte offset in the contents of @file
+ *
+ * Returns: the line, starting at 1, that contains @offset.
+ */
+guint
+gtr_source_file_get_line_at_offset (GtrSourceFile *file,
+                                    gsize          offset)
+{
+  guint low, high;
+
+  g_return_val_if_fail (file != NULL, 1);
+
+  /* Last line starting at or before offset */
+  low = 0;
+  high = file->lines->len;
+  while (high - low > 1)
+    {
+      guint middle = low + (high - low) / 2;
+
+      if (g_array_index (file->lines, gsize, middle) <= offset)
+        low = middle;
+      else
+        high = middle;
+    }
+
+  return low + 1;
+}
+
+/**
+ * gtr_source_file_find_msgid:
+ * @file: a #GtrSourceFile
+ * @msgid: a message id
+ *
+ * Looks for the markup-escaped @msgid, as it is written in the UI files
+ * that intltool extracts to fake .h files, skipping matches that are part
+ * of a longer word.
+ *
+ * Returns: the line, starting at 1, of the first match or 0.
+ */
+guint
+gtr_source_file_find_msgid (GtrSourceFile *file,
+                            const gchar   *msgid)
+{
+  const gchar *content, *end, *str_found, *i;
+  gchar *escaped;
+  gsize length, escaped_len;
+  guint result = 0;
+
+  g_return_val_if_fail (file != NULL, 0);
+  g_return_val_if_fail (msgid != NULL, 0);
+
+  escaped = g_markup_escape_text (msgid, -1);
+  escaped_len = strlen (escaped);
+  content = gtr_source_file_get_contents (file, &length);
+  end = content + length;
+
+  /* The mapped contents are not nul-terminated */
+  i = content;
+  while ((str_found = g_strstr_len (i, end - i, escaped)))
+    {
+      gchar c;
+
+      i = str_found + escaped_len;
+      c = i < end ? *i : '\0';
+      if (!isalpha (c) &&
+          (str_found == content || !isalpha (*(str_found - 1))) &&
+          !(c == ':') && !(c == '_'))
+        break;
+    }
+
+  if (str_found)
+    result = gtr_source_file_get_line_at_offset (file, str_found - content);
+
+  g_free (escaped);
+
+  return result;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtrSourceFile GtrSourceFile;
+
+GtrSourceFile  *gtr_source_cache_get                (const gchar    *path,
+                                                     GError        **error);
+
+GtrSourceFile  *gtr_source_file_ref                 (GtrSourceFile  *file);
+
+void            gtr_source_file_unref               (GtrSourceFile  *file);
+
+const gchar    *gtr_source_file_get_contents        (GtrSourceFile  *file,
+                                                     gsize          *length);
+
+guint           gtr_source_file_get_n_lines         (GtrSourceFile  *file);
+
+guint           gtr_source_file_get_line_at_offset  (GtrSourceFile  *file,
+                                                     gsize           offset);
+
+guint           gtr_source_file_find_msgid          (GtrSourceFile  *file,
+                                                     const gchar    *msgid);
+
+G_END_DECLS
@@ -0,0 +1,526 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Index of the lines of the messages referenced through fake .h files.
+ *
+ * intltool extracts the strings of UI files as if they came from a
+ * "file.ui.h" that doesn't exist, so the line in the reference is
+ * meaningless and the code view has to look for the msgid in the real
+ * file. When a PO file is opened, the references are copied and both
+ * telling the fake headers from the real ones and searching the UI files
+ * happen on a pool of worker threads. The results are kept here, so
+ * following a reference needs no scanning. Every indexed file is monitored
+ * and searched again when it changes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-source-index.h"
+#include "gtr-source-cache.h"
+#include "gtr-msg.h"
+
+#include <gio/gio.h>
+#include <string.h>
+
+#define MAX_THREADS 4
+
+typedef struct
+{
+  GtrSourceIndex *index;
+  gchar *path;
+
+  /* Messages referencing the file, used as a set */
+  GHashTable *msgids;
+
+  /* msgid -> line, NULL until the file is indexed */
+  GHashTable *lines;
+
+  /* Results of an outdated search are dropped */
+  guint generation;
+
+  GFileMonitor *monitor;
+} IndexedFile;
+
+typedef struct
+{
+  /* Full path of the referenced .h file */
+  gchar *header;
+  gchar *msgid;
+} Reference;
+
+/*
+ * Either searches the msgids in the file at path, or, when references is
+ * set, finds the fake headers among them and queues their files.
+ */
+typedef struct
+{
+  gchar *path;
+  gchar **msgids;
+  guint generation;
+
+  GPtrArray *references;
+} IndexJob;
+
+typedef struct
+{
+  /* Protects files and the lines of every IndexedFile */
+  GMutex lock;
+
+  /* real path -> IndexedFile */
+  GHashTable *files;
+
+  GThreadPool *pool;
+
+  /* Set on dispose, no more jobs are queued */
+  gboolean disposed;
+} GtrSourceIndexPrivate;
+
+struct _GtrSourceIndex
+{
+  GObject parent_instance;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtrSourceIndex, gtr_source_index, G_TYPE_OBJECT)
+
+static void
+indexed_file_free (IndexedFile *file)
+{
+  if (file->monitor != NULL)
+    {
+      g_file_monitor_cancel (file->monitor);
+      g_object_unref (file->monitor);
+    }
+
+  g_hash_table_destroy (file->msgids);
+  if (file->lines != NULL)
+    g_hash_table_destroy (file->lines);
+  g_free (file->path);
+  g_slice_free (IndexedFile, file);
+}
+
+static void
+reference_free (Reference *reference)
+{
+  g_free (reference->header);
+  g_free (reference->msgid);
+  g_slice_free (Reference, reference);
+}
+
+static void
+index_job_free (IndexJob *job)
+{
+  g_free (job->path);
+  g_strfreev (job->msgids);
+  if (job->references != NULL)
+    g_ptr_array_unref (job->references);
+  g_slice_free (IndexJob, job);
+}
+
+static void collect_references (GtrSourceIndex *index,
+                                GPtrArray      *references);
+
+static void
+index_thread (gpointer data,
+              gpointer user_data)
+{
+  GtrSourceIndex *index = user_data;
+  GtrSourceIndexPrivate *priv = gtr_source_index_get_instance_private (index);
+  IndexJob *job = data;
+  GtrSourceFile *source;
+  IndexedFile *file;
+  GHashTable *lines;
+  gchar **msgid;
+  gboolean disposed;
+
+  g_mutex_lock (&priv->lock);
+  disposed = priv->disposed;
+  g_mutex_unlock (&priv->lock);
+
+  if (disposed)
+    {
+      index_job_free (job);
+      return;
+    }
+
+  if (job->references != NULL)
+    {
+      collect_references (index, job->references);
+      index_job_free (job);
+      return;
+    }
+
+  lines = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* A missing file gives an empty index, like a missing match gives
+   * the first line */
+  source = gtr_source_cache_get (job->path, NULL);
+  if (source != NULL)
+    {
+      for (msgid = job->msgids; *msgid != NULL; msgid++)
+        {
+          guint line = gtr_source_file_find_msgid (source, *msgid);
+
+          if (line > 0)
+            g_hash_table_insert (lines, g_strdup (*msgid),
+                                 GUINT_TO_POINTER (line));
+        }
+
+      gtr_source_file_unref (source);
+    }
+
+  g_mutex_lock (&priv->lock);
+
+  file = g_hash_table_lookup (priv->files, job->path);
+  if (file != NULL && file->generation == job->generation)
+    {
+      if (file->lines != NULL)
+        g_hash_table_destroy (file->lines);
+      file->lines = lines;
+      lines = NULL;
+    }
+
+  g_mutex_unlock (&priv->lock);
+
+  if (lines != NULL)
+    g_hash_table_destroy (lines);
+  index_job_free (job);
+}
+
+/* Must be called with the lock held */
+static void
+queue_file (GtrSourceIndex *index,
+            IndexedFile    *file)
+{
+  GtrSourceIndexPrivate *priv = gtr_source_index_get_instance_private (index);
+  GHashTableIter iter;
+  IndexJob *job;
+  gpointer msgid;
+  guint i = 0;
+
+  if (priv->disposed)
+    return;
+
+  job = g_slice_new0 (IndexJob);
+  job->path = g_strdup (file->path);
+  job->generation = ++file->generation;
+  job->msgids = g_new (gchar *, g_hash_table_size (file->msgids) + 1);
+
+  g_hash_table_iter_init (&iter, file->msgids);
+  while (g_hash_table_iter_next (&iter, &msgid, NULL))
+    job->msgids[i++] = g_strdup (msgid);
+  job->msgids[i] = NULL;
+
+  g_thread_pool_push (priv->pool, job, NULL);
+}
+
+static void
+file_changed_cb (GFileMonitor      *monitor,
+                 GFile             *changed,
+                 GFile             *other_file,
+                 GFileMonitorEvent  event_type,
+                 IndexedFile       *file)
+{
+  GtrSourceIndexPrivate *priv = gtr_source_index_get_instance_private (file->index);
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_DELETED:
+      break;
+    default:
+      return;
+    }
+
+  /* Until it is searched again, the code view scans the file */
+  g_mutex_lock (&priv->lock);
+  g_clear_pointer (&file->lines, g_hash_table_destroy);
+  queue_file (file->index, file);
+  g_mutex_unlock (&priv->lock);
+}
+
+static void
+monitor_file (IndexedFile *file)
+{
+  GFile *location;
+
+  /* Created from a worker, the monitor still reports to the main context */
+  location = g_file_new_for_path (file->path);
+  file->monitor = g_file_monitor_file (location, G_FILE_MONITOR_NONE,
+                                       NULL, NULL);
+  g_object_unref (location);
+
+  if (file->monitor != NULL)
+    g_signal_connect (file->monitor, "changed",
+                      G_CALLBACK (file_changed_cb), file);
+}
+
+/* Runs on the pool, as it checks every referenced header on disk */
+static void
+collect_references (GtrSourceIndex *index,
+                    GPtrArray      *references)
+{
+  GtrSourceIndexPrivate *priv = gtr_source_index_get_instance_private (index);
+  GHashTable *real_headers;
+  GHashTable *files;
+  GHashTableIter iter;
+  gpointer path, msgids;
+  guint i;
+
+  /* Headers that exist are real references, no need to look for them */
+  real_headers = g_hash_table_new (g_str_hash, g_str_equal);
+
+  /* path -> set of msgids */
+  files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                 (GDestroyNotify) g_hash_table_destroy);
+
+  for (i = 0; i < references->len; i++)
+    {
+      Reference *reference = g_ptr_array_index (references, i);
+      GHashTable *file_msgids;
+      gchar *file_path;
+
+      if (g_hash_table_contains (real_headers, reference->header))
+        continue;
+
+      file_path = g_strndup (reference->header,
+                             strlen (reference->header) - 2);
+
+      file_msgids = g_hash_table_lookup (files, file_path);
+      if (file_msgids == NULL)
+        {
+          if (g_file_test (reference->header, G_FILE_TEST_EXISTS))
+            {
+              g_hash_table_add (real_headers, reference->header);
+              g_free (file_path);
+              continue;
+            }
+
+          file_msgids = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, NULL);
+          g_hash_table_insert (files, file_path, file_msgids);
+        }
+      else
+        g_free (file_path);
+
+      if (!g_hash_table_contains (file_msgids, reference->msgid))
+        g_hash_table_add (file_msgids, g_strdup (reference->msgid));
+    }
+
+  g_hash_table_destroy (real_headers);
+
+  g_mutex_lock (&priv->lock);
+
+  g_hash_table_iter_init (&iter, files);
+  while (g_hash_table_iter_next (&iter, &path, &msgids))
+    {
+      IndexedFile *file;
+
+      if (priv->disposed || g_hash_table_contains (priv->files, path))
+        continue;
+
+      file = g_slice_new0 (IndexedFile);
+      file->index = index;
+      file->path = path;
+      file->msgids = msgids;
+      g_hash_table_iter_steal (&iter);
+      g_hash_table_insert (priv->files, file->path, file);
+
+      monitor_file (file);
+      queue_file (index, file);
+    }
+
+  g_mutex_unlock (&priv->lock);
+
+  g_hash_table_destroy (files);
+}
+
+static void
+gtr_source_index_dispose (GObject *object)
+{
+  GtrSourceIndexPrivate *priv = gtr_source_index_get_instance_private (GTR_SOURCE_INDEX (object));
+
+  g_mutex_lock (&priv->lock);
+  priv->disposed = TRUE;
+  g_mutex_unlock (&priv->lock);
+
+  /* Drop the queued searches and wait for the running ones */
+  if (priv->pool != NULL)
+    {
+#if GLIB_CHECK_VERSION (2, 70, 0)
+      g_thread_pool_free (priv->pool, TRUE, TRUE);
+#else
+      /* Without a destroy notify, the queued jobs are run, and skipped */
+      g_thread_pool_free (priv->pool, FALSE, TRUE);
+#endif
+      priv->pool = NULL;
+    }
+
+  g_clear_pointer (&priv->files, g_hash_table_destroy);
+
+  G_OBJECT_CLASS (gtr_source_index_parent_class)->dispose (object);
+}
+
+static void
+gtr_source_index_finalize (GObject *object)
+{
+  GtrSourceIndexPrivate *priv = gtr_source_index_get_instance_private (GTR_SOURCE_INDEX (object));
+
+  g_mutex_clear (&priv->lock);
+
+  G_OBJECT_CLASS (gtr_source_index_parent_class)->finalize (object);
+}
+
+static void
+gtr_source_index_class_init (GtrSourceIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gtr_source_index_dispose;
+  object_class->finalize = gtr_source_index_finalize;
+}
+
+static void
+gtr_source_index_init (GtrSourceIndex *self)
+{
+  GtrSourceIndexPrivate *priv = gtr_source_index_get_instance_private (self);
+
+  g_mutex_init (&priv->lock);
+  priv->files = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                       (GDestroyNotify) indexed_file_free);
+#if GLIB_CHECK_VERSION (2, 70, 0)
+  /* The jobs dropped on dispose are freed */
+  priv->pool = g_thread_pool_new_full (index_thread, self,
+                                       (GDestroyNotify) index_job_free,
+                                       MIN (g_get_num_processors (), MAX_THREADS),
+                                       FALSE, NULL);
+#else
+  priv->pool = g_thread_pool_new (index_thread, self,
+                                  MIN (g_get_num_processors (), MAX_THREADS),
+                                  FALSE, NULL);
+#endif
+}
+
+/**
+ * gtr_source_index_new:
+ * @po: a parsed #GtrPo
+ *
+ * Starts indexing in the background the files that the messages of @po
+ * reference through fake .h files.
+ *
+ * Returns: (transfer full): a new #GtrSourceIndex.
+ */
+GtrSourceIndex *
+gtr_source_index_new (GtrPo *po)
+{
+  GtrSourceIndex *index;
+  GtrSourceIndexPrivate *priv;
+  IndexJob *job;
+  GFile *location, *parent;
+  gchar *dirname;
+  GList *l;
+
+  g_return_val_if_fail (GTR_IS_PO (po), NULL);
+
+  index = g_object_new (GTR_TYPE_SOURCE_INDEX, NULL);
+  priv = gtr_source_index_get_instance_private (index);
+
+  location = gtr_po_get_location (po);
+  parent = g_file_get_parent (location);
+  g_object_unref (location);
+
+  dirname = g_file_get_path (parent);
+  g_object_unref (parent);
+
+  /* The messages belong to the UI thread, the references to .h files are
+   * copied for the pool, which looks for them on disk */
+  job = g_slice_new0 (IndexJob);
+  job->references = g_ptr_array_new_with_free_func ((GDestroyNotify) reference_free);
+
+  for (l = gtr_po_get_messages (po); l != NULL; l = g_list_next (l))
+    {
+      const gchar *filename;
+      gint i = 0;
+
+      while ((filename = gtr_msg_get_filename (l->data, i++)) != NULL)
+        {
+          Reference *reference;
+
+          if (!g_str_has_suffix (filename, ".h"))
+            continue;
+
+          reference = g_slice_new (Reference);
+          reference->header = g_build_filename (dirname, filename, NULL);
+          reference->msgid = g_strdup (gtr_msg_get_msgid (l->data));
+          g_ptr_array_add (job->references, reference);
+        }
+    }
+
+  g_free (dirname);
+
+  if (job->references->len > 0)
+    g_thread_pool_push (priv->pool, job, NULL);
+  else
+    index_job_free (job);
+
+  return index;
+}
+
+/**
+ * gtr_source_index_lookup:
+ * @index: a #GtrSourceIndex
+ * @path: the real path of a file referenced through a fake .h file
+ * @msgid: the msgid of the message
+ * @line: (out): where to store the line
+ *
+ * Returns: %TRUE if @path was already indexed and @line was set, which is
+ * the first line if @msgid wasn't found.
+ */
+gboolean
+gtr_source_index_lookup (GtrSourceIndex *index,
+                         const gchar    *path,
+                         const gchar    *msgid,
+                         gint           *line)
+{
+  GtrSourceIndexPrivate *priv;
+  IndexedFile *file;
+  gboolean indexed = FALSE;
+
+  g_return_val_if_fail (GTR_IS_SOURCE_INDEX (index), FALSE);
+  g_return_val_if_fail (path != NULL && msgid != NULL, FALSE);
+
+  priv = gtr_source_index_get_instance_private (index);
+
+  g_mutex_lock (&priv->lock);
+
+  file = g_hash_table_lookup (priv->files, path);
+  if (file != NULL && file->lines != NULL)
+    {
+      guint found = GPOINTER_TO_UINT (g_hash_table_lookup (file->lines, msgid));
+
+      *line = found > 0 ? found : 1;
+      indexed = TRUE;
+    }
+
+  g_mutex_unlock (&priv->lock);
+
+  return indexed;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <glib-object.h>
+#include "gtr-po.h"
+
+G_BEGIN_DECLS
+
+#define GTR_TYPE_SOURCE_INDEX (gtr_source_index_get_type())
+
+G_DECLARE_FINAL_TYPE (GtrSourceIndex, gtr_source_index, GTR, SOURCE_INDEX, GObject)
+
+GtrSourceIndex *gtr_source_index_new     (GtrPo          *po);
+
+gboolean        gtr_source_index_lookup  (GtrSourceIndex *index,
+                                          const gchar    *path,
+                                          const gchar    *msgid,
+                                          gint           *line);
+
+G_END_DECLS
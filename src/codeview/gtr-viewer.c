@@ -33,11 +33,20 @@
 #include <string.h>
 #include <gtksourceview/gtksource.h>
 
+/* Files bigger than this are shown before being highlighted */
+#define HIGHLIGHT_MAX_SIZE (512 * 1024)
+
 typedef struct
 {
   GtkWidget *main_box;
   GtkWidget *view;
   GtkWidget *filename_label;
+  GtkWidget *progress_bar;
+
+  /* Load in progress */
+  GCancellable *cancellable;
+
+  guint highlight_id;
 } GtrViewerPrivate;
 
 struct _GtrViewer
@@ -91,6 +100,7 @@ gtr_viewer_init (GtrViewer *dlg)
   g_object_ref (priv->main_box);
   sw = GTK_WIDGET (gtk_builder_get_object (builder, "scrolledwindow"));
   priv->filename_label = GTK_WIDGET (gtk_builder_get_object (builder, "filename_label"));
+  priv->progress_bar = GTK_WIDGET (gtk_builder_get_object (builder, "progress_bar"));
   g_object_unref (builder);
 
   gtk_box_pack_start (content_area, priv->main_box, TRUE, TRUE, 0);
@@ -113,6 +123,26 @@ gtr_viewer_init (GtrViewer *dlg)
                                          TRUE);
 }
 
+static void
+gtr_viewer_dispose (GObject *object)
+{
+  GtrViewerPrivate *priv = gtr_viewer_get_instance_private (GTR_VIEWER (object));
+
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      g_clear_object (&priv->cancellable);
+    }
+
+  if (priv->highlight_id != 0)
+    {
+      g_source_remove (priv->highlight_id);
+      priv->highlight_id = 0;
+    }
+
+  G_OBJECT_CLASS (gtr_viewer_parent_class)->dispose (object);
+}
+
 static void
 gtr_viewer_finalize (GObject *object)
 {
@@ -124,11 +154,32 @@ gtr_viewer_class_init (GtrViewerClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+  object_class->dispose = gtr_viewer_dispose;
   object_class->finalize = gtr_viewer_finalize;
 }
 
 /***************** File loading *****************/
 
+typedef struct
+{
+  GtrViewer *viewer;
+  GCancellable *cancellable;
+  GtkSourceFileLoader *loader;
+  gchar *filename;
+  gint line;
+  gboolean defer_highlight;
+} LoadData;
+
+static void
+load_data_free (LoadData *data)
+{
+  g_object_unref (data->viewer);
+  g_object_unref (data->cancellable);
+  g_object_unref (data->loader);
+  g_free (data->filename);
+  g_slice_free (LoadData, data);
+}
+
 static void
 error_dialog (GtkWindow *parent, const gchar *msg, ...)
 {
@@ -150,50 +201,6 @@ error_dialog (GtkWindow *parent, const gchar *msg, ...)
   gtk_widget_destroy (dialog);
 }
 
-static gboolean
-gtk_source_buffer_load_file (GtkSourceBuffer *source_buffer,
-                             const gchar     *filename,
-                             GError         **error)
-{
-  GtkTextIter iter;
-  gchar *buffer;
-  GError *error_here = NULL;
-
-  g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (source_buffer), FALSE);
-  g_return_val_if_fail (filename != NULL, FALSE);
-
-  if (!g_file_get_contents (filename, &buffer, NULL, &error_here))
-    {
-      error_dialog (NULL, "%s\nFile %s", error_here->message, filename);
-      g_propagate_error (error, error_here);
-      return FALSE;
-    }
-
-  gtk_source_buffer_begin_not_undoable_action (source_buffer);
-  gtk_text_buffer_set_text (GTK_TEXT_BUFFER (source_buffer), buffer, -1);
-  gtk_source_buffer_end_not_undoable_action (source_buffer);
-  gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (source_buffer), FALSE);
-
-  /* move cursor to the beginning */
-  gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (source_buffer), &iter);
-  gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (source_buffer), &iter);
-
-  {
-    GtkTextIter start, end;
-    char *text;
-    gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (source_buffer), &start,
-                                &end);
-    text =
-      gtk_text_buffer_get_text (GTK_TEXT_BUFFER (source_buffer), &start, &end,
-                                TRUE);
-    g_assert (!strcmp (text, buffer));
-    g_free (text);
-  }
-
-  g_free (buffer);
-  return TRUE;
-}
-
 static void
 remove_all_marks (GtkSourceBuffer *buffer)
 {
@@ -204,63 +211,6 @@ remove_all_marks (GtkSourceBuffer *buffer)
   gtk_source_buffer_remove_source_marks (buffer, &s, &e, NULL);
 }
 
-/* Note this is wrong for several reasons, e.g. g_pattern_match is broken
- * for glob matching. */
-static GtkSourceLanguage *
-get_language_for_filename (const gchar *filename)
-{
-  const gchar *const *languages;
-  gchar *filename_utf8;
-  GtkSourceLanguageManager *manager;
-
-  filename_utf8 = g_filename_to_utf8 (filename, -1, NULL, NULL, NULL);
-  g_return_val_if_fail (filename_utf8 != NULL, NULL);
-
-  manager = gtk_source_language_manager_get_default ();
-  languages = gtk_source_language_manager_get_language_ids (manager);
-
-  while (*languages != NULL)
-    {
-      GtkSourceLanguage *lang;
-      gchar **globs, **p;
-
-      lang = gtk_source_language_manager_get_language (manager, *languages);
-      g_return_val_if_fail (GTK_SOURCE_IS_LANGUAGE (lang), NULL);
-      ++languages;
-
-      globs = gtk_source_language_get_globs (lang);
-      if (globs == NULL)
-        continue;
-
-      for (p = globs; *p != NULL; p++)
-        {
-          if (g_pattern_match_simple (*p, filename_utf8))
-            {
-              g_strfreev (globs);
-              g_free (filename_utf8);
-
-              return lang;
-            }
-        }
-
-      g_strfreev (globs);
-    }
-
-  g_free (filename_utf8);
-  return NULL;
-}
-
-static GtkSourceLanguage *
-get_language_for_file (const gchar *filename)
-{
-  GtkSourceLanguage *language = NULL;
-
-  if (!language)
-    language = get_language_for_filename (filename);
-
-  return language;
-}
-
 static GtkSourceLanguage *
 get_language_by_id (const gchar *id)
 {
@@ -300,101 +250,185 @@ get_language (GtkTextBuffer *buffer, const gchar *filename)
     }
 
   if (!language)
-    language = get_language_for_file (filename);
+    language = gtk_source_language_manager_guess_language (gtk_source_language_manager_get_default (),
+                                                           filename, NULL);
 
   g_free (text);
   return language;
 }
 
-static gboolean
-open_file (GtkSourceBuffer *buffer, const gchar *filename)
+static void
+jump_to_line (GtkTextView *view, gint line)
 {
-  GtkSourceLanguage *language = NULL;
-  gchar *freeme = NULL;
-  gboolean success = FALSE;
-  GFile *file;
-  gchar *path;
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  gint line_count;
 
-  file = g_file_new_for_path (filename);
-  path = g_file_get_path (file);
-  g_object_unref (file);
+  buffer = gtk_text_view_get_buffer (view);
 
-  remove_all_marks (buffer);
+  line_count = gtk_text_buffer_get_line_count (buffer);
 
-  success = gtk_source_buffer_load_file (buffer, path, NULL);
+  if (line >= line_count)
+    gtk_text_buffer_get_end_iter (buffer, &iter);
+  else
+    gtk_text_buffer_get_iter_at_line (buffer, &iter, line - 1);
 
-  if (!success)
-    goto out;
+  gtk_text_buffer_place_cursor (buffer, &iter);
 
-  language = get_language (GTK_TEXT_BUFFER (buffer), filename);
+  gtk_text_view_scroll_to_mark (view,
+                                gtk_text_buffer_get_insert (buffer),
+                                0.25, FALSE, 0.0, 0.0);
+}
 
-  if (language == NULL)
-    g_print ("No language found for file `%s'\n", filename);
+static gboolean
+highlight_cb (GtrViewer *viewer)
+{
+  GtrViewerPrivate *priv = gtr_viewer_get_instance_private (viewer);
+  GtkSourceBuffer *buffer;
 
-  gtk_source_buffer_set_language (buffer, language);
-  g_object_set_data_full (G_OBJECT (buffer),
-                          "filename", g_strdup (filename),
-                          (GDestroyNotify) g_free);
+  buffer = GTK_SOURCE_BUFFER (gtk_text_view_get_buffer (GTK_TEXT_VIEW (priv->view)));
+  gtk_source_buffer_set_highlight_syntax (buffer, TRUE);
 
-  if (language != NULL)
-    {
-      gchar **styles;
+  priv->highlight_id = 0;
 
-      styles = gtk_source_language_get_style_ids (language);
+  return G_SOURCE_REMOVE;
+}
 
-      if (styles == NULL)
-        g_print ("No styles in language '%s'\n",
-                 gtk_source_language_get_name (language));
-      else
-        {
-          gchar **ids;
-          g_print ("Styles in in language '%s':\n",
-                   gtk_source_language_get_name (language));
+static void
+load_progress_cb (goffset  current_num_bytes,
+                  goffset  total_num_bytes,
+                  gpointer user_data)
+{
+  LoadData *data = user_data;
+  GtrViewerPrivate *priv;
 
-          ids = styles;
+  if (g_cancellable_is_cancelled (data->cancellable) || total_num_bytes <= 0)
+    return;
 
-          while (*ids != NULL)
-            {
-              const gchar *name;
+  priv = gtr_viewer_get_instance_private (data->viewer);
 
-              name = gtk_source_language_get_style_name (language, *ids);
+  gtk_widget_show (priv->progress_bar);
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->progress_bar),
+                                 (gdouble) current_num_bytes / total_num_bytes);
+}
 
-              g_print ("- %s (name: '%s')\n", *ids, name);
+static void
+load_ready_cb (GObject      *source_object,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  LoadData *data = user_data;
+  GtrViewerPrivate *priv;
+  GtkSourceBuffer *buffer;
+  GtkSourceLanguage *language;
+  GError *error = NULL;
 
-              ++ids;
-            }
+  gtk_source_file_loader_load_finish (GTK_SOURCE_FILE_LOADER (source_object),
+                                      result, &error);
 
-          g_strfreev (styles);
-        }
+  /* Another file was requested or the viewer was closed */
+  if (g_cancellable_is_cancelled (data->cancellable))
+    {
+      g_clear_error (&error);
+      load_data_free (data);
+      return;
+    }
+
+  priv = gtr_viewer_get_instance_private (data->viewer);
+  g_clear_object (&priv->cancellable);
+  gtk_widget_hide (priv->progress_bar);
 
-      g_print ("\n");
+  if (error != NULL)
+    {
+      error_dialog (GTK_WINDOW (data->viewer), "%s\nFile %s",
+                    error->message, data->filename);
+      g_error_free (error);
+      load_data_free (data);
+      return;
     }
-out:
-  g_free (freeme);
-  return success;
+
+  buffer = GTK_SOURCE_BUFFER (gtk_text_view_get_buffer (GTK_TEXT_VIEW (priv->view)));
+
+  language = get_language (GTK_TEXT_BUFFER (buffer), data->filename);
+  gtk_source_buffer_set_language (buffer, language);
+  g_object_set_data_full (G_OBJECT (buffer),
+                          "filename", g_strdup (data->filename),
+                          (GDestroyNotify) g_free);
+
+  jump_to_line (GTK_TEXT_VIEW (priv->view), data->line);
+
+  /* Big files are shown first, and highlighted once the window is idle */
+  if (data->defer_highlight)
+    priv->highlight_id = g_idle_add_full (G_PRIORITY_LOW,
+                                          (GSourceFunc) highlight_cb,
+                                          data->viewer, NULL);
+  else
+    gtk_source_buffer_set_highlight_syntax (buffer, TRUE);
+
+  load_data_free (data);
 }
 
 static void
-jump_to_line (GtkTextView *view, gint line)
+load_file (GtrViewer *viewer, const gchar *filename, gint line)
 {
-  GtkTextBuffer *buffer;
-  GtkTextIter iter;
-  gint line_count;
+  GtrViewerPrivate *priv = gtr_viewer_get_instance_private (viewer);
+  GtkSourceBuffer *buffer;
+  GtkSourceFile *source_file;
+  GFileInfo *info;
+  LoadData *data;
+  GFile *file;
 
-  buffer = gtk_text_view_get_buffer (view);
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      g_clear_object (&priv->cancellable);
+    }
 
-  line_count = gtk_text_buffer_get_line_count (buffer);
+  if (priv->highlight_id != 0)
+    {
+      g_source_remove (priv->highlight_id);
+      priv->highlight_id = 0;
+    }
 
-  if (line >= line_count)
-    gtk_text_buffer_get_end_iter (buffer, &iter);
-  else
-    gtk_text_buffer_get_iter_at_line (buffer, &iter, line - 1);
+  buffer = GTK_SOURCE_BUFFER (gtk_text_view_get_buffer (GTK_TEXT_VIEW (priv->view)));
+  remove_all_marks (buffer);
 
-  gtk_text_buffer_place_cursor (buffer, &iter);
+  /* Highlighting while the text is inserted chunk by chunk is wasted */
+  gtk_source_buffer_set_highlight_syntax (buffer, FALSE);
 
-  gtk_text_view_scroll_to_mark (view,
-                                gtk_text_buffer_get_insert (buffer),
-                                0.25, FALSE, 0.0, 0.0);
+  file = g_file_new_for_path (filename);
+  source_file = gtk_source_file_new ();
+  gtk_source_file_set_location (source_file, file);
+
+  data = g_slice_new0 (LoadData);
+  data->viewer = g_object_ref (viewer);
+  data->cancellable = g_cancellable_new ();
+  data->loader = gtk_source_file_loader_new (buffer, source_file);
+  data->filename = g_strdup (filename);
+  data->line = line;
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (info != NULL)
+    {
+      data->defer_highlight = g_file_info_get_size (info) > HIGHLIGHT_MAX_SIZE;
+      g_object_unref (info);
+    }
+
+  priv->cancellable = g_object_ref (data->cancellable);
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->progress_bar), 0.0);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (priv->progress_bar),
+                             _("Loading file…"));
+
+  gtk_source_file_loader_load_async (data->loader,
+                                     G_PRIORITY_DEFAULT,
+                                     data->cancellable,
+                                     load_progress_cb, data, NULL,
+                                     load_ready_cb, data);
+
+  g_object_unref (source_file);
+  g_object_unref (file);
 }
 
 void
@@ -402,33 +436,31 @@ gtr_show_viewer (GtrWindow *window, const gchar *path, gint line)
 {
   static GtrViewer *dlg = NULL;
   GtrViewerPrivate *priv;
+  gchar *basename;
+  gchar *label;
 
   g_return_if_fail (GTR_IS_WINDOW (window));
 
   if (dlg == NULL)
     {
-      GtkSourceBuffer *buffer;
-      gchar *label;
-
       dlg = g_object_new (GTR_TYPE_VIEWER, NULL);
-      priv = gtr_viewer_get_instance_private (dlg);
-
-      buffer =
-        GTK_SOURCE_BUFFER (gtk_text_view_get_buffer
-                           (GTK_TEXT_VIEW (priv->view)));
-
-      open_file (buffer, path);
-      jump_to_line (GTK_TEXT_VIEW (priv->view), line);
-
-      label = g_strdup_printf ("<b>%s</b>", g_path_get_basename (path));
-      gtk_label_set_markup (GTK_LABEL (priv->filename_label), label);
-      g_free (label);
 
       g_signal_connect (dlg,
                         "destroy", G_CALLBACK (gtk_widget_destroyed), &dlg);
       gtk_widget_show (GTK_WIDGET (dlg));
     }
 
+  priv = gtr_viewer_get_instance_private (dlg);
+
+  /* The file is loaded in the background, the dialog shows up at once */
+  load_file (dlg, path, line);
+
+  basename = g_path_get_basename (path);
+  label = g_markup_printf_escaped ("<b>%s</b>", basename);
+  gtk_label_set_markup (GTK_LABEL (priv->filename_label), label);
+  g_free (label);
+  g_free (basename);
+
   if (GTK_WINDOW (window) != gtk_window_get_transient_for (GTK_WINDOW (dlg)))
     {
       gtk_window_set_transient_for (GTK_WINDOW (dlg), GTK_WINDOW (window));
@@ -455,6 +455,17 @@ build_tm_activated (GSimpleAction *action,
   gtr_window_show_tm_dialog (w);
 }
 
+static void
+pretranslate_activated (GSimpleAction *action,
+                        GVariant      *parameter,
+                        gpointer       user_data)
+{
+  GtrApplication *app = GTR_APPLICATION (user_data);
+  GtrApplicationPrivate *priv = gtr_application_get_instance_private (app);
+  GtrWindow *w = GTR_WINDOW (priv->active_window);
+  gtr_window_pretranslate (w);
+}
+
 static void
 tm_activated (GSimpleAction *action,
               GVariant      *parameter,
@@ -526,6 +537,7 @@ static GActionEntry app_entries[] = {
   { "sort_by_translated_desc", sort_by_activated, NULL, "6", NULL },
 
   { "build_tm", build_tm_activated, NULL, NULL, NULL },
+  { "pretranslate", pretranslate_activated, NULL, NULL, NULL },
   { "tm_1", tm_activated, NULL, NULL, NULL },
   { "tm_2", tm_activated, NULL, NULL, NULL },
   { "tm_3", tm_activated, NULL, NULL, NULL },
@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * gtranslator-cli processes PO files with the same engine as the editor,
+ * without starting the user interface, so it can run on servers and in
+ * CI. The files are processed on a pool of threads and the reports are
+ * printed in the order of the command line. The exit status is 1 if any
+ * file failed.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-dirs.h"
+#include "gtr-header.h"
+#include "gtr-msg.h"
+#include "gtr-po.h"
+#include "gtr-profile-manager.h"
+#include "gtr-translation-memory.h"
+#include "gtr-translation-memory-partitions.h"
+
+#include <locale.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <gio/gio.h>
+
+typedef enum
+{
+  COMMAND_STATS,
+  COMMAND_CHECK,
+  COMMAND_PRETRANSLATE,
+  COMMAND_NORMALIZE
+} Command;
+
+static const gchar *commands[] = {
+  "stats",
+  "check",
+  "pretranslate",
+  "normalize",
+  NULL
+};
+
+typedef struct
+{
+  gchar *path;
+
+  /* Report of the file, printed once all are done */
+  gchar *report;
+  gboolean failed;
+
+  gint translated;
+  gint fuzzy;
+  gint untranslated;
+} Job;
+
+static Command command;
+static gint n_jobs = 0;
+static gboolean use_tm = FALSE;
+static gint min_score = 100;
+
+static GtrTranslationMemoryPartitions *partitions = NULL;
+
+static GOptionEntry entries[] = {
+  { "jobs", 'j', 0, G_OPTION_ARG_INT, &n_jobs,
+    N_("Number of files processed at once (one per processor by default)"), "N" },
+  { "tm", 0, 0, G_OPTION_ARG_NONE, &use_tm,
+    N_("Pre-translate from the translation memory"), NULL },
+  { "min-score", 0, 0, G_OPTION_ARG_INT, &min_score,
+    N_("Minimum level of the matches used to pre-translate (100 by default)"), "LEVEL" },
+  { NULL }
+};
+
+static void
+free_match (gpointer data)
+{
+  GtrTranslationMemoryMatch *match = (GtrTranslationMemoryMatch *) data;
+
+  g_free (match->match);
+  g_slice_free (GtrTranslationMemoryMatch, match);
+}
+
+static void
+job_free (Job *job)
+{
+  g_free (job->path);
+  g_free (job->report);
+  g_slice_free (Job, job);
+}
+
+static void
+stats (Job   *job,
+       GtrPo *po)
+{
+  job->translated = gtr_po_get_translated_count (po);
+  job->fuzzy = gtr_po_get_fuzzy_count (po);
+  job->untranslated = gtr_po_get_untranslated_count (po);
+
+  job->report = g_strdup_printf (_("%s: %d translated, %d fuzzy, %d untranslated"),
+                                 job->path, job->translated, job->fuzzy,
+                                 job->untranslated);
+}
+
+static void
+check (Job   *job,
+       GtrPo *po)
+{
+  gchar *message;
+
+  /* Like msgfmt --check */
+  message = gtr_po_check_po_file (po);
+  if (message != NULL)
+    {
+      job->report = g_strdup_printf ("%s: %s", job->path, message);
+      job->failed = TRUE;
+      g_free (message);
+    }
+}
+
+static void
+save (Job   *job,
+      GtrPo *po)
+{
+  GError *error = NULL;
+
+  /* The header is updated and the messages rewrapped by the writer */
+  gtr_po_save_file (po, &error);
+  if (error != NULL)
+    {
+      job->report = g_strdup_printf ("%s: %s", job->path, error->message);
+      job->failed = TRUE;
+      g_error_free (error);
+    }
+}
+
+static void
+pretranslate (Job   *job,
+              GtrPo *po)
+{
+  GtrTranslationMemory *tm;
+  gchar *language;
+  guint n_untranslated = 0;
+  guint n_exact = 0;
+  guint n_fuzzy = 0;
+  GList *l;
+
+  language = gtr_header_get_language_code (gtr_po_get_header (po));
+  tm = gtr_translation_memory_partitions_get (partitions, language);
+  g_free (language);
+
+  for (l = gtr_po_get_messages (po); l != NULL; l = g_list_next (l))
+    {
+      GtrMsg *msg = GTR_MSG (l->data);
+      const gchar *msgid = gtr_msg_get_msgid (msg);
+      GtrTranslationMemoryMatch *best;
+      GList *matches;
+
+      /* The memory only holds singular messages */
+      if (gtr_msg_is_translated (msg) ||
+          gtr_msg_get_msgid_plural (msg) != NULL ||
+          msgid == NULL || *msgid == '\0')
+        continue;
+
+      n_untranslated++;
+
+      /* The matches are sorted by level */
+      matches = gtr_translation_memory_lookup (tm, msgid);
+      if (matches == NULL)
+        continue;
+
+      best = matches->data;
+      if (best->level >= min_score)
+        {
+          gtr_msg_set_msgstr (msg, best->match);
+          gtr_msg_set_fuzzy (msg, best->level < 100);
+
+          if (best->level < 100)
+            n_fuzzy++;
+          else
+            n_exact++;
+        }
+
+      g_list_free_full (matches, free_match);
+    }
+
+  if (n_exact + n_fuzzy > 0)
+    {
+      gtr_po_set_state (po, GTR_PO_STATE_MODIFIED);
+      save (job, po);
+      if (job->failed)
+        return;
+    }
+
+  job->report = g_strdup_printf (_("%s: %u of %u untranslated messages pre-translated, "
+                                   "%u of them fuzzy"),
+                                 job->path, n_exact + n_fuzzy, n_untranslated,
+                                 n_fuzzy);
+}
+
+static void
+process_file (gpointer data,
+              gpointer user_data)
+{
+  Job *job = data;
+  GFile *location;
+  GtrPo *po;
+  GError *error = NULL;
+
+  location = g_file_new_for_commandline_arg (job->path);
+  po = gtr_po_new ();
+
+  /* The po is freed when it can't be parsed */
+  if (!gtr_po_parse (po, location, &error))
+    {
+      job->report = g_strdup_printf ("%s: %s", job->path, error->message);
+      job->failed = TRUE;
+      g_error_free (error);
+      g_object_unref (location);
+      return;
+    }
+
+  /* Parsed, but gettext found errors */
+  if (error != NULL)
+    {
+      if (command == COMMAND_CHECK)
+        {
+          job->report = g_strdup_printf ("%s: %s", job->path, error->message);
+          job->failed = TRUE;
+        }
+      else
+        g_printerr (_("Warning: %s: %s\n"), job->path, error->message);
+
+      g_clear_error (&error);
+    }
+
+  switch (command)
+    {
+    case COMMAND_STATS:
+      stats (job, po);
+      break;
+    case COMMAND_CHECK:
+      if (!job->failed)
+        check (job, po);
+      break;
+    case COMMAND_PRETRANSLATE:
+      pretranslate (job, po);
+      break;
+    case COMMAND_NORMALIZE:
+      save (job, po);
+      break;
+    }
+
+  g_object_unref (po);
+  g_object_unref (location);
+}
+
+static gboolean
+has_schema (const gchar *schema_id)
+{
+  GSettingsSchemaSource *source;
+  GSettingsSchema *schema;
+
+  source = g_settings_schema_source_get_default ();
+  if (source == NULL)
+    return FALSE;
+
+  schema = g_settings_schema_source_lookup (source, schema_id, TRUE);
+  if (schema == NULL)
+    return FALSE;
+
+  g_settings_schema_unref (schema);
+
+  return TRUE;
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+  GOptionContext *context;
+  GtrProfileManager *prof_manager;
+  GThreadPool *pool;
+  GPtrArray *jobs;
+  GError *error = NULL;
+  gint translated = 0;
+  gint fuzzy = 0;
+  gint untranslated = 0;
+  gint status = EXIT_SUCCESS;
+  guint n;
+  gint i;
+
+  gtr_dirs_init ();
+
+  setlocale (LC_ALL, "");
+
+  bindtextdomain (GETTEXT_PACKAGE, gtr_dirs_get_gtr_locale_dir ());
+  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+  textdomain (GETTEXT_PACKAGE);
+
+  context = g_option_context_new (_("COMMAND FILE… — Process PO files"));
+  g_option_context_set_summary (context,
+                                _("Commands:\n"
+                                  "  stats         Count the translated, fuzzy and untranslated messages\n"
+                                  "  check         Check the files like msgfmt --check\n"
+                                  "  pretranslate  Fill the untranslated messages, needs --tm\n"
+                                  "  normalize     Update the header and rewrap the messages"));
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr (_("%s\nRun “%s --help” to see a full list of available command line options.\n"),
+                  error->message, argv[0]);
+      g_error_free (error);
+      g_option_context_free (context);
+      return EXIT_FAILURE;
+    }
+  g_option_context_free (context);
+
+  if (argc < 3 || !g_strv_contains ((const gchar * const *) commands, argv[1]))
+    {
+      g_printerr (_("Run “%s --help” to see the commands.\n"), argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  for (command = COMMAND_STATS; g_strcmp0 (commands[command], argv[1]) != 0; command++)
+    ;
+
+  /* The header reads the editor preferences */
+  if (!has_schema ("org.gnome.gtranslator.preferences.files"))
+    {
+      g_printerr (_("The settings schemas of %s are not installed\n"), PACKAGE);
+      return EXIT_FAILURE;
+    }
+
+  if (command == COMMAND_PRETRANSLATE)
+    {
+      /* The translation memory is the only source for now */
+      if (!use_tm)
+        {
+          g_printerr (_("pretranslate needs --tm\n"));
+          return EXIT_FAILURE;
+        }
+
+      if (!has_schema ("org.gnome.gtranslator.plugins.translation-memory"))
+        {
+          g_printerr (_("The settings schemas of %s are not installed\n"), PACKAGE);
+          return EXIT_FAILURE;
+        }
+
+      partitions = gtr_translation_memory_partitions_get_default ();
+    }
+
+  /* The headers share the profile manager, which is freed when its last
+   * reference goes away but never created again, so it is held until the
+   * end. Created here, before the threads race to do it. */
+  prof_manager = gtr_profile_manager_get_default ();
+
+  jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) job_free);
+  pool = g_thread_pool_new (process_file, NULL,
+                            n_jobs > 0 ? n_jobs : (gint) g_get_num_processors (),
+                            FALSE, NULL);
+
+  for (i = 2; i < argc; i++)
+    {
+      Job *job;
+
+      job = g_slice_new0 (Job);
+      job->path = g_strdup (argv[i]);
+      g_ptr_array_add (jobs, job);
+
+      g_thread_pool_push (pool, job, NULL);
+    }
+
+  /* Wait for all the files */
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  for (n = 0; n < jobs->len; n++)
+    {
+      Job *job = g_ptr_array_index (jobs, n);
+
+      if (job->report != NULL)
+        {
+          if (job->failed)
+            g_printerr ("%s\n", job->report);
+          else
+            g_print ("%s\n", job->report);
+        }
+
+      if (job->failed)
+        status = EXIT_FAILURE;
+
+      translated += job->translated;
+      fuzzy += job->fuzzy;
+      untranslated += job->untranslated;
+    }
+
+  if (command == COMMAND_STATS && jobs->len > 1)
+    g_print (_("Total: %d translated, %d fuzzy, %d untranslated\n"),
+             translated, fuzzy, untranslated);
+
+  g_ptr_array_unref (jobs);
+  g_clear_object (&partitions);
+  g_object_unref (prof_manager);
+  gtr_dirs_shutdown ();
+
+  return status;
+}
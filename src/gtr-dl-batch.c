@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Downloads a set of PO files from Damned Lies into a directory. Every
+ * file is given by its info endpoint, which has the path of the PO file.
+ * At most MAX_DOWNLOADS files are fetched at once, one failure doesn't
+ * stop the others, and running the batch again resumes the files that
+ * were interrupted.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-dl-batch.h"
+#include "gtr-dl-client.h"
+
+/* Same as the connections per host of the client */
+#define MAX_DOWNLOADS 4
+
+enum
+{
+  PROGRESS,
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL];
+
+typedef struct
+{
+  GFile *directory;
+
+  /* Info endpoints not started yet */
+  GQueue *pending;
+
+  guint total;
+  guint completed;
+  guint failed;
+  guint running;
+  GError *first_error;
+
+  GTask *task;
+} GtrDlBatchPrivate;
+
+struct _GtrDlBatch
+{
+  GObject parent_instance;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtrDlBatch, gtr_dl_batch, G_TYPE_OBJECT)
+
+typedef struct
+{
+  GtrDlBatch *batch;
+  gchar *info_path;
+} Job;
+
+static void start_jobs (GtrDlBatch *batch);
+
+static void
+job_free (Job *job)
+{
+  g_free (job->info_path);
+  g_slice_free (Job, job);
+}
+
+static void
+finish (GtrDlBatch *batch)
+{
+  GtrDlBatchPrivate *priv = gtr_dl_batch_get_instance_private (batch);
+  GTask *task;
+
+  task = priv->task;
+  priv->task = NULL;
+
+  if (g_task_return_error_if_cancelled (task))
+    ;
+  else if (priv->failed > 0)
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "%u of %u files could not be downloaded: %s",
+                             priv->failed, priv->total,
+                             priv->first_error->message);
+  else
+    g_task_return_boolean (task, TRUE);
+
+  g_object_unref (task);
+}
+
+static void
+job_done (Job    *job,
+          GError *error)
+{
+  GtrDlBatch *batch = job->batch;
+  GtrDlBatchPrivate *priv = gtr_dl_batch_get_instance_private (batch);
+
+  priv->running--;
+  priv->completed++;
+
+  if (error != NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_warning ("Error downloading %s: %s", job->info_path, error->message);
+
+          priv->failed++;
+          if (priv->first_error == NULL)
+            priv->first_error = g_error_copy (error);
+        }
+
+      g_error_free (error);
+    }
+
+  job_free (job);
+
+  g_signal_emit (batch, signals[PROGRESS], 0, priv->completed, priv->total);
+
+  start_jobs (batch);
+}
+
+static void
+job_downloaded_cb (GObject      *source_object,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  GError *error = NULL;
+
+  gtr_dl_client_download_finish (result, &error);
+  job_done (user_data, error);
+}
+
+static void
+job_info_cb (GObject      *source_object,
+             GAsyncResult *result,
+             gpointer      user_data)
+{
+  Job *job = user_data;
+  GtrDlBatchPrivate *priv = gtr_dl_batch_get_instance_private (job->batch);
+  g_autoptr(JsonNode) node = NULL;
+  const gchar *po_file = NULL;
+  gchar *basename;
+  GFile *destination;
+  GError *error = NULL;
+
+  node = gtr_dl_client_get_json_finish (result, NULL, &error);
+  if (node == NULL)
+    {
+      job_done (job, error);
+      return;
+    }
+
+  if (JSON_NODE_HOLDS_OBJECT (node))
+    po_file = json_object_get_string_member (json_node_get_object (node), "po_file");
+
+  if (po_file == NULL)
+    {
+      job_done (job, g_error_new (G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                                  "No file found"));
+      return;
+    }
+
+  basename = g_path_get_basename (po_file);
+  destination = g_file_get_child (priv->directory, basename);
+
+  gtr_dl_client_download_async (po_file, destination,
+                                g_task_get_cancellable (priv->task),
+                                job_downloaded_cb, job);
+
+  g_object_unref (destination);
+  g_free (basename);
+}
+
+static void
+start_jobs (GtrDlBatch *batch)
+{
+  GtrDlBatchPrivate *priv = gtr_dl_batch_get_instance_private (batch);
+  GCancellable *cancellable = g_task_get_cancellable (priv->task);
+
+  while (priv->running < MAX_DOWNLOADS &&
+         !g_queue_is_empty (priv->pending) &&
+         !g_cancellable_is_cancelled (cancellable))
+    {
+      Job *job;
+
+      job = g_slice_new0 (Job);
+      job->batch = batch;
+      job->info_path = g_queue_pop_head (priv->pending);
+
+      priv->running++;
+      gtr_dl_client_get_json_async (job->info_path, cancellable,
+                                    job_info_cb, job);
+    }
+
+  if (priv->running == 0)
+    finish (batch);
+}
+
+static void
+gtr_dl_batch_finalize (GObject *object)
+{
+  GtrDlBatchPrivate *priv = gtr_dl_batch_get_instance_private (GTR_DL_BATCH (object));
+
+  g_object_unref (priv->directory);
+  g_queue_free_full (priv->pending, g_free);
+  g_clear_error (&priv->first_error);
+
+  G_OBJECT_CLASS (gtr_dl_batch_parent_class)->finalize (object);
+}
+
+static void
+gtr_dl_batch_class_init (GtrDlBatchClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gtr_dl_batch_finalize;
+
+  /**
+   * GtrDlBatch::progress:
+   * @batch: the batch
+   * @completed: files done, downloaded or not
+   * @total: files in the batch
+   */
+  signals[PROGRESS] =
+    g_signal_new ("progress",
+                  G_OBJECT_CLASS_TYPE (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_UINT);
+}
+
+static void
+gtr_dl_batch_init (GtrDlBatch *batch)
+{
+  GtrDlBatchPrivate *priv = gtr_dl_batch_get_instance_private (batch);
+
+  priv->pending = g_queue_new ();
+}
+
+/**
+ * gtr_dl_batch_new:
+ * @directory: where to save the files
+ *
+ * Returns: (transfer full): a new, empty #GtrDlBatch.
+ */
+GtrDlBatch *
+gtr_dl_batch_new (GFile *directory)
+{
+  GtrDlBatch *batch;
+  GtrDlBatchPrivate *priv;
+
+  g_return_val_if_fail (G_IS_FILE (directory), NULL);
+
+  batch = g_object_new (GTR_TYPE_DL_BATCH, NULL);
+  priv = gtr_dl_batch_get_instance_private (batch);
+  priv->directory = g_object_ref (directory);
+
+  return batch;
+}
+
+/**
+ * gtr_dl_batch_add:
+ * @batch: a #GtrDlBatch
+ * @info_path: the API endpoint of a file, like
+ * "modules/[module]/branches/[branch]/domains/[domain]/languages/[team]"
+ *
+ * Adds a file to @batch, before it's run.
+ */
+void
+gtr_dl_batch_add (GtrDlBatch  *batch,
+                  const gchar *info_path)
+{
+  GtrDlBatchPrivate *priv;
+
+  g_return_if_fail (GTR_IS_DL_BATCH (batch));
+  g_return_if_fail (info_path != NULL);
+
+  priv = gtr_dl_batch_get_instance_private (batch);
+  g_return_if_fail (priv->task == NULL);
+
+  g_queue_push_tail (priv->pending, g_strdup (info_path));
+  priv->total++;
+}
+
+/**
+ * gtr_dl_batch_run_async:
+ * @batch: a #GtrDlBatch
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called once every file is done
+ * @user_data: data for @callback
+ *
+ * Downloads the files of @batch. #GtrDlBatch::progress is emitted after
+ * every file.
+ */
+void
+gtr_dl_batch_run_async (GtrDlBatch          *batch,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
+{
+  GtrDlBatchPrivate *priv;
+
+  g_return_if_fail (GTR_IS_DL_BATCH (batch));
+
+  priv = gtr_dl_batch_get_instance_private (batch);
+  g_return_if_fail (priv->task == NULL);
+
+  priv->task = g_task_new (batch, cancellable, callback, user_data);
+  g_task_set_source_tag (priv->task, gtr_dl_batch_run_async);
+
+  start_jobs (batch);
+}
+
+/**
+ * gtr_dl_batch_run_finish:
+ * @batch: a #GtrDlBatch
+ * @result: a #GAsyncResult
+ * @error: a #GError
+ *
+ * Returns: %TRUE if every file was downloaded.
+ */
+gboolean
+gtr_dl_batch_run_finish (GtrDlBatch    *batch,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, batch), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GTR_TYPE_DL_BATCH (gtr_dl_batch_get_type())
+
+G_DECLARE_FINAL_TYPE (GtrDlBatch, gtr_dl_batch, GTR, DL_BATCH, GObject)
+
+GtrDlBatch *gtr_dl_batch_new          (GFile               *directory);
+
+void        gtr_dl_batch_add          (GtrDlBatch          *batch,
+                                       const gchar         *info_path);
+
+void        gtr_dl_batch_run_async    (GtrDlBatch          *batch,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data);
+
+gboolean    gtr_dl_batch_run_finish   (GtrDlBatch          *batch,
+                                       GAsyncResult        *result,
+                                       GError             **error);
+
+G_END_DECLS
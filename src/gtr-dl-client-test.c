@@ -0,0 +1,719 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tests of the Damned Lies client against a local SoupServer, which
+ * GTR_DL_API_URL points to. They cover the revalidation of cached JSON,
+ * reading it back while offline, resuming downloads and the checks done
+ * before a download replaces its destination.
+ *
+ * The cache and the downloads go to a temporary directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-dl-client.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILE_PATH "/files/test.po"
+#define FILE_ETAG "\"file-1\""
+
+#define N_SLOW_DOWNLOADS 8
+/* Milliseconds a slow download waits before it's answered */
+#define SLOW_DELAY 100
+
+typedef struct
+{
+  SoupServer *server;
+
+  /* Teams, answered as JSON with an ETag */
+  gchar *teams;
+  gchar *teams_etag;
+  gboolean offline;
+
+  /* Requests received, and how the last one was answered */
+  guint n_requests;
+  guint last_status;
+  gchar *last_if_none_match;
+  goffset last_range_start;
+
+  /* Sent by the file responses, if set */
+  gchar *digest;
+  gboolean chunked;
+  const gchar *file;
+
+  /* Slow downloads being answered at once */
+  gint active;
+  gint max_active;
+} TestServer;
+
+static TestServer test_server;
+static gchar *tmp_dir;
+
+static const gchar *po_file =
+  "msgid \"\"\n"
+  "msgstr \"\"\n"
+  "\"Project-Id-Version: test\\n\"\n"
+  "\"MIME-Version: 1.0\\n\"\n"
+  "\"Content-Type: text/plain; charset=UTF-8\\n\"\n"
+  "\"Content-Transfer-Encoding: 8bit\\n\"\n"
+  "\n"
+  "msgid \"Open\"\n"
+  "msgstr \"Abrir\"\n"
+  "\n"
+  "msgid \"Save\"\n"
+  "msgstr \"Guardar\"\n"
+  "\n"
+  "msgid \"Close the current file\"\n"
+  "msgstr \"Cerrar el archivo actual\"\n";
+
+static const gchar *broken_po_file =
+  "msgid \"Open\"\n"
+  "msgstr \"Abrir\n"
+  "msgid\n";
+
+static void
+remove_dir (const gchar *path)
+{
+  GDir *dir;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          gchar *child = g_build_filename (path, name, NULL);
+
+          if (g_file_test (child, G_FILE_TEST_IS_DIR))
+            remove_dir (child);
+          else
+            g_unlink (child);
+
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_rmdir (path);
+}
+
+static void
+reset_server (void)
+{
+  test_server.offline = FALSE;
+  test_server.n_requests = 0;
+  test_server.last_status = 0;
+  g_clear_pointer (&test_server.last_if_none_match, g_free);
+  test_server.last_range_start = -1;
+  g_clear_pointer (&test_server.digest, g_free);
+  test_server.chunked = FALSE;
+  test_server.file = po_file;
+  test_server.active = 0;
+  test_server.max_active = 0;
+}
+
+static void
+serve_teams (SoupMessage *msg)
+{
+  const gchar *if_none_match;
+
+  if_none_match = soup_message_headers_get_one (msg->request_headers,
+                                                "If-None-Match");
+  g_free (test_server.last_if_none_match);
+  test_server.last_if_none_match = g_strdup (if_none_match);
+
+  if (g_strcmp0 (if_none_match, test_server.teams_etag) == 0)
+    {
+      soup_message_set_status (msg, SOUP_STATUS_NOT_MODIFIED);
+      return;
+    }
+
+  soup_message_headers_replace (msg->response_headers, "ETag",
+                                test_server.teams_etag);
+  soup_message_set_response (msg, "application/json", SOUP_MEMORY_COPY,
+                             test_server.teams, strlen (test_server.teams));
+  soup_message_set_status (msg, SOUP_STATUS_OK);
+}
+
+static void
+serve_file (SoupMessage *msg)
+{
+  const gchar *range, *if_range;
+  goffset total = strlen (test_server.file);
+  goffset start;
+
+  soup_message_headers_replace (msg->response_headers, "ETag", FILE_ETAG);
+  if (test_server.digest != NULL)
+    soup_message_headers_replace (msg->response_headers, "Repr-Digest",
+                                  test_server.digest);
+
+  range = soup_message_headers_get_one (msg->request_headers, "Range");
+  if_range = soup_message_headers_get_one (msg->request_headers, "If-Range");
+
+  /* A range of another version of the file gets the whole file */
+  if (range != NULL && g_strcmp0 (if_range, FILE_ETAG) == 0 &&
+      sscanf (range, "bytes=%" G_GINT64_FORMAT "-", &start) == 1)
+    {
+      test_server.last_range_start = start;
+
+      if (start >= total)
+        {
+          gchar *content_range;
+
+          content_range = g_strdup_printf ("bytes */%" G_GOFFSET_FORMAT, total);
+          soup_message_headers_replace (msg->response_headers, "Content-Range",
+                                        content_range);
+          g_free (content_range);
+          soup_message_set_status (msg, SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE);
+          return;
+        }
+
+      soup_message_headers_set_content_range (msg->response_headers,
+                                              start, total - 1, total);
+      soup_message_set_response (msg, "text/x-gettext-translation",
+                                 SOUP_MEMORY_COPY, test_server.file + start,
+                                 total - start);
+      soup_message_set_status (msg, SOUP_STATUS_PARTIAL_CONTENT);
+      return;
+    }
+
+  /* Or SoupServer would answer the range itself */
+  soup_message_headers_remove (msg->request_headers, "Range");
+
+  if (test_server.chunked)
+    {
+      soup_message_headers_set_encoding (msg->response_headers,
+                                         SOUP_ENCODING_CHUNKED);
+      soup_message_headers_set_content_type (msg->response_headers,
+                                             "text/x-gettext-translation",
+                                             NULL);
+      soup_message_body_append (msg->response_body, SOUP_MEMORY_COPY,
+                                test_server.file, total);
+      soup_message_body_complete (msg->response_body);
+    }
+  else
+    soup_message_set_response (msg, "text/x-gettext-translation",
+                               SOUP_MEMORY_COPY, test_server.file, total);
+
+  soup_message_set_status (msg, SOUP_STATUS_OK);
+}
+
+static void
+slow_finished_cb (SoupMessage *msg)
+{
+  test_server.active--;
+}
+
+static gboolean
+answer_slow_cb (gpointer user_data)
+{
+  SoupMessage *msg = user_data;
+
+  serve_file (msg);
+  soup_server_unpause_message (test_server.server, msg);
+  g_object_unref (msg);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+server_cb (SoupServer        *server,
+           SoupMessage       *msg,
+           const char        *path,
+           GHashTable        *query,
+           SoupClientContext *client,
+           gpointer           user_data)
+{
+  test_server.n_requests++;
+
+  if (test_server.offline)
+    {
+      GIOStream *stream;
+
+      /* Like a network that went down */
+      stream = soup_client_context_steal_connection (client);
+      g_io_stream_close (stream, NULL, NULL);
+      g_object_unref (stream);
+      return;
+    }
+
+  if (g_strcmp0 (path, "/api/v1/teams") == 0)
+    serve_teams (msg);
+  else if (g_strcmp0 (path, FILE_PATH) == 0)
+    serve_file (msg);
+  else if (g_str_has_prefix (path, "/files/slow/"))
+    {
+      test_server.active++;
+      test_server.max_active = MAX (test_server.max_active, test_server.active);
+      g_signal_connect (msg, "finished", G_CALLBACK (slow_finished_cb), NULL);
+
+      soup_server_pause_message (server, msg);
+      g_timeout_add (SLOW_DELAY, answer_slow_cb, g_object_ref (msg));
+    }
+  else
+    soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+
+  test_server.last_status = msg->status_code;
+}
+
+static void
+result_cb (GObject      *source_object,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  GAsyncResult **result_out = user_data;
+
+  *result_out = g_object_ref (result);
+}
+
+static GAsyncResult *
+wait_for_result (GAsyncResult **result)
+{
+  while (*result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  return *result;
+}
+
+static JsonNode *
+get_json (const gchar  *path,
+          gboolean     *not_modified,
+          GError      **error)
+{
+  GAsyncResult *result = NULL;
+  JsonNode *root;
+
+  gtr_dl_client_get_json_async (path, NULL, result_cb, &result);
+  root = gtr_dl_client_get_json_finish (wait_for_result (&result),
+                                        not_modified, error);
+  g_object_unref (result);
+
+  return root;
+}
+
+static JsonNode *
+get_cached_json (const gchar  *path,
+                 GError      **error)
+{
+  GAsyncResult *result = NULL;
+  JsonNode *root;
+
+  gtr_dl_client_get_cached_json_async (path, NULL, result_cb, &result);
+  root = gtr_dl_client_get_cached_json_finish (wait_for_result (&result),
+                                               error);
+  g_object_unref (result);
+
+  return root;
+}
+
+static gboolean
+download (const gchar  *path,
+          GFile        *destination,
+          GError      **error)
+{
+  GAsyncResult *result = NULL;
+  gboolean downloaded;
+
+  gtr_dl_client_download_async (path, destination, NULL, result_cb, &result);
+  downloaded = gtr_dl_client_download_finish (wait_for_result (&result), error);
+  g_object_unref (result);
+
+  return downloaded;
+}
+
+static const gchar *
+get_team_name (JsonNode *root)
+{
+  return json_object_get_string_member (json_node_get_object (root), "name");
+}
+
+static void
+set_teams (const gchar *name,
+           const gchar *etag)
+{
+  g_free (test_server.teams);
+  g_free (test_server.teams_etag);
+  test_server.teams = g_strdup_printf ("{\"name\": \"%s\"}", name);
+  test_server.teams_etag = g_strdup (etag);
+}
+
+/* Creates the files an interrupted download leaves */
+static GFile *
+prepare_download (const gchar *name,
+                  const gchar *partial,
+                  const gchar *validator)
+{
+  gchar *path, *partial_path, *validator_path;
+  GFile *destination;
+
+  path = g_build_filename (tmp_dir, name, NULL);
+  partial_path = g_strconcat (path, ".part", NULL);
+  validator_path = g_strconcat (path, ".part.validator", NULL);
+
+  g_unlink (path);
+  g_unlink (partial_path);
+  g_unlink (validator_path);
+
+  if (partial != NULL)
+    g_assert_true (g_file_set_contents (partial_path, partial, -1, NULL));
+  if (validator != NULL)
+    g_assert_true (g_file_set_contents (validator_path, validator, -1, NULL));
+
+  destination = g_file_new_for_path (path);
+
+  g_free (validator_path);
+  g_free (partial_path);
+  g_free (path);
+
+  return destination;
+}
+
+static void
+assert_downloaded (GFile *destination)
+{
+  gchar *contents, *uri, *partial_uri;
+  GFile *partial;
+
+  g_assert_true (g_file_load_contents (destination, NULL, &contents, NULL,
+                                       NULL, NULL));
+  g_assert_cmpstr (contents, ==, po_file);
+  g_free (contents);
+
+  uri = g_file_get_uri (destination);
+  partial_uri = g_strconcat (uri, ".part", NULL);
+  partial = g_file_new_for_uri (partial_uri);
+  g_assert_false (g_file_query_exists (partial, NULL));
+
+  g_object_unref (partial);
+  g_free (partial_uri);
+  g_free (uri);
+}
+
+static void
+test_json_revalidation (void)
+{
+  JsonNode *root;
+  gboolean not_modified;
+  GError *error = NULL;
+
+  reset_server ();
+  set_teams ("first", "\"teams-1\"");
+
+  root = get_json ("teams", &not_modified, &error);
+  g_assert_no_error (error);
+  g_assert_false (not_modified);
+  g_assert_cmpstr (get_team_name (root), ==, "first");
+  json_node_unref (root);
+
+  /* The cached response is revalidated with its ETag */
+  root = get_json ("teams", &not_modified, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (test_server.last_if_none_match, ==, "\"teams-1\"");
+  g_assert_cmpuint (test_server.last_status, ==, SOUP_STATUS_NOT_MODIFIED);
+  g_assert_true (not_modified);
+  g_assert_cmpstr (get_team_name (root), ==, "first");
+  json_node_unref (root);
+
+  /* And replaced once it changes */
+  set_teams ("second", "\"teams-2\"");
+  root = get_json ("teams", &not_modified, &error);
+  g_assert_no_error (error);
+  g_assert_false (not_modified);
+  g_assert_cmpstr (get_team_name (root), ==, "second");
+  json_node_unref (root);
+}
+
+static void
+test_json_offline (void)
+{
+  JsonNode *root;
+  GError *error = NULL;
+
+  reset_server ();
+  set_teams ("cached", "\"teams-3\"");
+
+  root = get_json ("teams", NULL, &error);
+  g_assert_no_error (error);
+  json_node_unref (root);
+
+  /* The request fails, but the last response is still there */
+  test_server.offline = TRUE;
+  root = get_json ("teams", NULL, &error);
+  g_assert_nonnull (error);
+  g_assert_null (root);
+  g_clear_error (&error);
+
+  root = get_cached_json ("teams", &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (get_team_name (root), ==, "cached");
+  json_node_unref (root);
+}
+
+static void
+test_download (void)
+{
+  GFile *destination;
+  GError *error = NULL;
+
+  reset_server ();
+  destination = prepare_download ("download.po", NULL, NULL);
+
+  download (FILE_PATH, destination, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (test_server.last_range_start, ==, -1);
+  assert_downloaded (destination);
+
+  g_object_unref (destination);
+}
+
+static void
+test_download_resume (void)
+{
+  GFile *destination;
+  gchar *partial;
+  GError *error = NULL;
+
+  reset_server ();
+  partial = g_strndup (po_file, 40);
+  destination = prepare_download ("resume.po", partial, FILE_ETAG);
+
+  download (FILE_PATH, destination, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (test_server.last_status, ==, SOUP_STATUS_PARTIAL_CONTENT);
+  g_assert_cmpint (test_server.last_range_start, ==, 40);
+  assert_downloaded (destination);
+
+  g_object_unref (destination);
+  g_free (partial);
+}
+
+static void
+test_download_changed (void)
+{
+  GFile *destination;
+  GError *error = NULL;
+
+  reset_server ();
+
+  /* Left by a download of another version of the file */
+  destination = prepare_download ("changed.po", "msgid \"Old\"\nmsgstr",
+                                  "\"file-0\"");
+
+  download (FILE_PATH, destination, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (test_server.last_status, ==, SOUP_STATUS_OK);
+  assert_downloaded (destination);
+
+  g_object_unref (destination);
+}
+
+static void
+test_download_range_not_satisfiable (void)
+{
+  GFile *destination;
+  gchar *partial;
+  GError *error = NULL;
+
+  reset_server ();
+  partial = g_strconcat (po_file, "\nmsgid \"Extra\"\n", NULL);
+  destination = prepare_download ("longer.po", partial, FILE_ETAG);
+
+  /* The 416 is followed by a download from the start */
+  download (FILE_PATH, destination, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (test_server.n_requests, ==, 2);
+  g_assert_cmpuint (test_server.last_status, ==, SOUP_STATUS_OK);
+  assert_downloaded (destination);
+
+  g_object_unref (destination);
+  g_free (partial);
+}
+
+static void
+test_download_digest (void)
+{
+  GFile *destination;
+  gchar *digest;
+  GChecksum *checksum;
+  guint8 bytes[32];
+  gsize length = sizeof (bytes);
+  GError *error = NULL;
+
+  reset_server ();
+  destination = prepare_download ("digest.po", NULL, NULL);
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) po_file, -1);
+  g_checksum_get_digest (checksum, bytes, &length);
+  g_checksum_free (checksum);
+
+  digest = g_base64_encode (bytes, length);
+  test_server.digest = g_strdup_printf ("sha-256=:%s:", digest);
+
+  download (FILE_PATH, destination, &error);
+  g_assert_no_error (error);
+  assert_downloaded (destination);
+
+  /* A digest of another file */
+  g_object_unref (destination);
+  destination = prepare_download ("digest.po", NULL, NULL);
+  g_free (test_server.digest);
+  test_server.digest = g_strdup ("sha-256=:AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=:");
+
+  download (FILE_PATH, destination, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_false (g_file_query_exists (destination, NULL));
+  g_clear_error (&error);
+
+  g_object_unref (destination);
+  g_free (digest);
+}
+
+static void
+test_download_broken_po (void)
+{
+  GFile *destination;
+  GError *error = NULL;
+
+  reset_server ();
+
+  /* A chunked response has no size to check */
+  test_server.chunked = TRUE;
+  test_server.file = broken_po_file;
+  destination = prepare_download ("broken.po", NULL, NULL);
+
+  download (FILE_PATH, destination, &error);
+  g_assert_nonnull (error);
+  g_assert_false (g_file_query_exists (destination, NULL));
+  g_clear_error (&error);
+
+  /* The same response is fine if the file is */
+  test_server.file = po_file;
+  download (FILE_PATH, destination, &error);
+  g_assert_no_error (error);
+  assert_downloaded (destination);
+
+  g_object_unref (destination);
+}
+
+static void
+test_download_concurrency (void)
+{
+  GAsyncResult *results[N_SLOW_DOWNLOADS] = { NULL, };
+  GFile *destinations[N_SLOW_DOWNLOADS];
+  GError *error = NULL;
+  gint max_conns;
+  gint i;
+
+  reset_server ();
+
+  for (i = 0; i < N_SLOW_DOWNLOADS; i++)
+    {
+      gchar *name, *path;
+
+      name = g_strdup_printf ("slow-%d.po", i);
+      destinations[i] = prepare_download (name, NULL, NULL);
+      path = g_strdup_printf ("/files/slow/%s", name);
+
+      gtr_dl_client_download_async (path, destinations[i], NULL, result_cb,
+                                    &results[i]);
+      g_free (path);
+      g_free (name);
+    }
+
+  for (i = 0; i < N_SLOW_DOWNLOADS; i++)
+    {
+      gtr_dl_client_download_finish (wait_for_result (&results[i]), &error);
+      g_assert_no_error (error);
+      assert_downloaded (destinations[i]);
+
+      g_object_unref (results[i]);
+      g_object_unref (destinations[i]);
+    }
+
+  /* The session never opens more connections than the server allows */
+  g_object_get (gtr_dl_client_get_session (), "max-conns-per-host", &max_conns,
+                NULL);
+  g_assert_cmpint (test_server.max_active, >, 1);
+  g_assert_cmpint (test_server.max_active, <=, max_conns);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GSList *uris;
+  gchar *base, *api_url;
+  GError *error = NULL;
+  gint status;
+
+  g_test_init (&argc, &argv, NULL);
+
+  /* The responses are cached in $XDG_CACHE_HOME/gtranslator, it must be
+   * set before anything asks GLib for the user directories */
+  tmp_dir = g_dir_make_tmp ("gtr-dl-client-test-XXXXXX", &error);
+  g_assert_no_error (error);
+  g_setenv ("XDG_CACHE_HOME", tmp_dir, TRUE);
+
+  test_server.server = soup_server_new (NULL, NULL);
+  soup_server_add_handler (test_server.server, NULL, server_cb, NULL, NULL);
+  soup_server_listen_local (test_server.server, 0,
+                            SOUP_SERVER_LISTEN_IPV4_ONLY, &error);
+  g_assert_no_error (error);
+
+  uris = soup_server_get_uris (test_server.server);
+  base = soup_uri_to_string (uris->data, FALSE);
+  g_slist_free_full (uris, (GDestroyNotify) soup_uri_free);
+
+  /* Read once, by the first request */
+  api_url = g_strconcat (base, g_str_has_suffix (base, "/") ? "" : "/",
+                         "api/v1/", NULL);
+  g_setenv ("GTR_DL_API_URL", api_url, TRUE);
+  g_free (api_url);
+  g_free (base);
+
+  g_test_add_func ("/dl-client/json/revalidation", test_json_revalidation);
+  g_test_add_func ("/dl-client/json/offline", test_json_offline);
+  g_test_add_func ("/dl-client/download", test_download);
+  g_test_add_func ("/dl-client/download/resume", test_download_resume);
+  g_test_add_func ("/dl-client/download/changed", test_download_changed);
+  g_test_add_func ("/dl-client/download/range-not-satisfiable",
+                   test_download_range_not_satisfiable);
+  g_test_add_func ("/dl-client/download/digest", test_download_digest);
+  g_test_add_func ("/dl-client/download/broken-po", test_download_broken_po);
+  g_test_add_func ("/dl-client/download/concurrency", test_download_concurrency);
+
+  status = g_test_run ();
+
+  reset_server ();
+  g_free (test_server.teams);
+  g_free (test_server.teams_etag);
+  soup_server_disconnect (test_server.server);
+  g_object_unref (test_server.server);
+
+  remove_dir (tmp_dir);
+  g_free (tmp_dir);
+
+  return status;
+}
@@ -0,0 +1,910 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Client of the Damned Lies API. Every request goes through one
+ * SoupSession, so connections to the server are reused, and is
+ * asynchronous, so a slow server never blocks the UI.
+ *
+ * JSON responses are kept in the user cache dir with their ETag and
+ * Last-Modified headers. They can be read back at once, without
+ * network, and later requests only download what changed since.
+ *
+ * Downloads are checked before they replace the destination: their size
+ * against the one announced by the server, their digest when the server
+ * sends one, and PO files are read by gettext, as a chunked response has
+ * no announced size.
+ *
+ * The API base can be changed with the GTR_DL_API_URL environment
+ * variable, e.g. to point to a local server.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-dl-client.h"
+#include "gtr-po.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define API_URL "https://l10n.gnome.org/api/v1/"
+
+/* Seconds */
+#define TIMEOUT 30
+#define IDLE_TIMEOUT 60
+
+#define MAX_CONNS_PER_HOST 4
+
+/* Bytes read at a time to compute the digest of a download */
+#define DIGEST_BUFFER_SIZE 8192
+
+typedef struct
+{
+  SoupMessage *msg;
+  GFile *destination;
+  GInputStream *input;
+
+  /* Downloads are written next to the destination and resumed from there */
+  GFile *partial;
+  GFile *validator;
+  goffset offset;
+  goffset expected;
+  /* Base64 digest of the whole file sent by the server, if any */
+  GChecksumType digest_type;
+  gchar *digest;
+
+  /* Cached response, the metadata has a .meta extension */
+  gchar *cache_path;
+  GMemoryOutputStream *body;
+  gchar *etag;
+  gchar *last_modified;
+  gboolean not_modified;
+} RequestData;
+
+static void
+request_data_free (RequestData *data)
+{
+  g_clear_object (&data->msg);
+  g_clear_object (&data->destination);
+  g_clear_object (&data->input);
+  g_clear_object (&data->partial);
+  g_clear_object (&data->validator);
+  g_clear_object (&data->body);
+  g_free (data->cache_path);
+  g_free (data->digest);
+  g_free (data->etag);
+  g_free (data->last_modified);
+  g_slice_free (RequestData, data);
+}
+
+static gchar *
+get_cache_path (SoupURI *uri)
+{
+  gchar *uri_string;
+  gchar *checksum;
+  gchar *path;
+
+  uri_string = soup_uri_to_string (uri, FALSE);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri_string, -1);
+  path = g_build_filename (g_get_user_cache_dir (), PACKAGE, "dl", checksum, NULL);
+
+  g_free (checksum);
+  g_free (uri_string);
+
+  return path;
+}
+
+/**
+ * gtr_dl_client_get_session:
+ *
+ * Returns: (transfer none): the session shared by all the requests to the
+ * server.
+ */
+SoupSession *
+gtr_dl_client_get_session (void)
+{
+  static gsize session = 0;
+
+  if (g_once_init_enter (&session))
+    {
+      SoupSession *new_session;
+
+      new_session = soup_session_new_with_options ("timeout", TIMEOUT,
+                                                   "idle-timeout", IDLE_TIMEOUT,
+                                                   "max-conns-per-host", MAX_CONNS_PER_HOST,
+                                                   "user-agent", PACKAGE "/" PACKAGE_VERSION " ",
+                                                   NULL);
+      g_once_init_leave (&session, (gsize) new_session);
+    }
+
+  return (SoupSession *) session;
+}
+
+/**
+ * gtr_dl_client_get_uri:
+ * @path: an API endpoint, like "teams", or an absolute path on the server
+ *
+ * Returns: (transfer full): the URI of @path, resolved against the API base.
+ */
+SoupURI *
+gtr_dl_client_get_uri (const gchar *path)
+{
+  static gsize base = 0;
+
+  if (g_once_init_enter (&base))
+    {
+      const gchar *api_url;
+      SoupURI *uri;
+
+      api_url = g_getenv ("GTR_DL_API_URL");
+      uri = soup_uri_new (api_url != NULL && *api_url != '\0' ? api_url : API_URL);
+      if (uri == NULL)
+        {
+          g_warning ("Invalid API URL %s", api_url);
+          uri = soup_uri_new (API_URL);
+        }
+
+      g_once_init_leave (&base, (gsize) uri);
+    }
+
+  return soup_uri_new_with_base ((SoupURI *) base, path);
+}
+
+static gboolean
+check_status (SoupMessage  *msg,
+              GError      **error)
+{
+  if (SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
+    return TRUE;
+
+  g_set_error (error, G_IO_ERROR,
+               msg->status_code == SOUP_STATUS_NOT_FOUND ?
+               G_IO_ERROR_NOT_FOUND : G_IO_ERROR_FAILED,
+               "%s", soup_status_get_phrase (msg->status_code));
+
+  return FALSE;
+}
+
+static GTask *
+request_new (const gchar         *path,
+             GCancellable        *cancellable,
+             GAsyncReadyCallback  callback,
+             gpointer             user_data)
+{
+  RequestData *data;
+  SoupURI *uri;
+  GTask *task;
+
+  uri = gtr_dl_client_get_uri (path);
+
+  data = g_slice_new0 (RequestData);
+  data->msg = soup_message_new_from_uri ("GET", uri);
+  data->cache_path = get_cache_path (uri);
+  soup_uri_free (uri);
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_task_data (task, data, (GDestroyNotify) request_data_free);
+
+  return task;
+}
+
+static void
+save_response (RequestData *data)
+{
+  GKeyFile *meta;
+  gchar *dirname;
+  gchar *meta_path;
+  GError *error = NULL;
+
+  dirname = g_path_get_dirname (data->cache_path);
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  /* Both files are replaced atomically; a body newer than its validators
+   * only costs a full download next time */
+  if (!g_file_set_contents (data->cache_path,
+                            g_memory_output_stream_get_data (data->body),
+                            g_memory_output_stream_get_data_size (data->body),
+                            &error))
+    {
+      g_warning ("Error caching response: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  meta = g_key_file_new ();
+  if (data->etag != NULL)
+    g_key_file_set_string (meta, "Response", "ETag", data->etag);
+  if (data->last_modified != NULL)
+    g_key_file_set_string (meta, "Response", "Last-Modified", data->last_modified);
+
+  meta_path = g_strconcat (data->cache_path, ".meta", NULL);
+  if (!g_key_file_save_to_file (meta, meta_path, &error))
+    {
+      g_warning ("Error caching response: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_free (meta_path);
+  g_key_file_free (meta);
+}
+
+static void
+add_validators (RequestData *data)
+{
+  GKeyFile *meta;
+  gchar *meta_path;
+  gchar *value;
+
+  /* Without the body, a 304 would be useless */
+  if (!g_file_test (data->cache_path, G_FILE_TEST_IS_REGULAR))
+    return;
+
+  meta = g_key_file_new ();
+  meta_path = g_strconcat (data->cache_path, ".meta", NULL);
+
+  if (g_key_file_load_from_file (meta, meta_path, G_KEY_FILE_NONE, NULL))
+    {
+      value = g_key_file_get_string (meta, "Response", "ETag", NULL);
+      if (value != NULL)
+        soup_message_headers_replace (data->msg->request_headers,
+                                      "If-None-Match", value);
+      g_free (value);
+
+      value = g_key_file_get_string (meta, "Response", "Last-Modified", NULL);
+      if (value != NULL)
+        soup_message_headers_replace (data->msg->request_headers,
+                                      "If-Modified-Since", value);
+      g_free (value);
+    }
+
+  g_free (meta_path);
+  g_key_file_free (meta);
+}
+
+/* Parses the downloaded body, caching it, or the cached one */
+static void
+json_thread (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+  RequestData *data = task_data;
+  JsonParser *parser;
+  gchar *contents = NULL;
+  gsize length;
+  GError *error = NULL;
+
+  if (data->body != NULL)
+    {
+      contents = g_memory_output_stream_get_data (data->body);
+      length = g_memory_output_stream_get_data_size (data->body);
+    }
+  else if (!g_file_get_contents (data->cache_path, &contents, &length, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  parser = json_parser_new ();
+
+  if (!json_parser_load_from_data (parser, contents, length, &error))
+    g_task_return_error (task, error);
+  else if (json_parser_get_root (parser) == NULL)
+    g_task_return_new_error (task, JSON_PARSER_ERROR, JSON_PARSER_ERROR_PARSE,
+                             "Empty response");
+  else
+    {
+      /* Only valid responses are cached */
+      if (data->body != NULL)
+        save_response (data);
+
+      g_task_return_pointer (task, json_node_copy (json_parser_get_root (parser)),
+                             (GDestroyNotify) json_node_unref);
+    }
+
+  g_object_unref (parser);
+  if (data->body == NULL)
+    g_free (contents);
+}
+
+static void
+json_read_cb (GObject      *source_object,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+  GTask *task = user_data;
+  GError *error = NULL;
+
+  if (g_output_stream_splice_finish (G_OUTPUT_STREAM (source_object),
+                                     result, &error) < 0)
+    g_task_return_error (task, error);
+  else
+    g_task_run_in_thread (task, json_thread);
+
+  g_object_unref (task);
+}
+
+static void
+json_sent_cb (GObject      *source_object,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+  GTask *task = user_data;
+  RequestData *data = g_task_get_task_data (task);
+  SoupMessageHeaders *headers = data->msg->response_headers;
+  GInputStream *stream;
+  GError *error = NULL;
+
+  stream = soup_session_send_finish (SOUP_SESSION (source_object),
+                                     result, &error);
+  if (stream == NULL)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  /* The cached response is still valid */
+  if (data->msg->status_code == SOUP_STATUS_NOT_MODIFIED)
+    {
+      data->not_modified = TRUE;
+      g_input_stream_close (stream, NULL, NULL);
+      g_object_unref (stream);
+      g_task_run_in_thread (task, json_thread);
+      g_object_unref (task);
+      return;
+    }
+
+  if (!check_status (data->msg, &error))
+    {
+      g_object_unref (stream);
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  data->etag = g_strdup (soup_message_headers_get_one (headers, "ETag"));
+  data->last_modified = g_strdup (soup_message_headers_get_one (headers, "Last-Modified"));
+
+  /* The body is kept to be cached once parsed */
+  data->body = G_MEMORY_OUTPUT_STREAM (g_memory_output_stream_new_resizable ());
+  g_output_stream_splice_async (G_OUTPUT_STREAM (data->body), stream,
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                G_PRIORITY_DEFAULT,
+                                g_task_get_cancellable (task),
+                                json_read_cb, task);
+  g_object_unref (stream);
+}
+
+/**
+ * gtr_dl_client_get_json_async:
+ * @path: the API endpoint, like "teams" or "modules/gtranslator"
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called with the parsed response
+ * @user_data: data for @callback
+ *
+ * Requests @path and parses the response as JSON. If the response is
+ * cached, the server is only asked whether it changed.
+ */
+void
+gtr_dl_client_get_json_async (const gchar         *path,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+  RequestData *data;
+  GTask *task;
+
+  g_return_if_fail (path != NULL);
+
+  task = request_new (path, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_dl_client_get_json_async);
+
+  data = g_task_get_task_data (task);
+  add_validators (data);
+
+  soup_session_send_async (gtr_dl_client_get_session (), data->msg,
+                           cancellable, json_sent_cb, task);
+}
+
+/**
+ * gtr_dl_client_get_json_finish:
+ * @result: a #GAsyncResult
+ * @not_modified: (out) (allow-none): whether the cached response was
+ * still valid
+ * @error: a #GError
+ *
+ * Returns: (transfer full): the root of the response, or %NULL.
+ */
+JsonNode *
+gtr_dl_client_get_json_finish (GAsyncResult  *result,
+                               gboolean      *not_modified,
+                               GError       **error)
+{
+  RequestData *data;
+
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  data = g_task_get_task_data (G_TASK (result));
+  if (not_modified != NULL)
+    *not_modified = data->not_modified;
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * gtr_dl_client_get_cached_json_async:
+ * @path: the API endpoint, like "teams" or "modules/gtranslator"
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called with the cached response
+ * @user_data: data for @callback
+ *
+ * Reads the last response to @path from the cache, without network. It
+ * may be outdated, so it's meant to be shown while
+ * gtr_dl_client_get_json_async() revalidates it.
+ */
+void
+gtr_dl_client_get_cached_json_async (const gchar         *path,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (path != NULL);
+
+  task = request_new (path, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_dl_client_get_cached_json_async);
+
+  g_task_run_in_thread (task, json_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gtr_dl_client_get_cached_json_finish:
+ * @result: a #GAsyncResult
+ * @error: a #GError
+ *
+ * Returns: (transfer full): the cached response, or %NULL if there is
+ * none.
+ */
+JsonNode *
+gtr_dl_client_get_cached_json_finish (GAsyncResult  *result,
+                                      GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void download_send (GTask *task);
+
+static void
+download_discard (RequestData *data)
+{
+  g_file_delete (data->partial, NULL, NULL);
+  g_file_delete (data->validator, NULL, NULL);
+}
+
+/*
+ * Reads the digest of the file from the Repr-Digest header (RFC 9530),
+ * like sha-256=:<base64>:, or the older Digest header (RFC 3230), like
+ * SHA-256=<base64>. Both describe the whole file, also in a 206 response.
+ */
+static void
+save_digest (RequestData *data)
+{
+  SoupMessageHeaders *headers = data->msg->response_headers;
+  const gchar *header;
+  gchar **items;
+  gint i;
+
+  g_clear_pointer (&data->digest, g_free);
+
+  header = soup_message_headers_get_list (headers, "Repr-Digest");
+  if (header == NULL)
+    header = soup_message_headers_get_list (headers, "Digest");
+  if (header == NULL)
+    return;
+
+  items = g_strsplit (header, ",", -1);
+  for (i = 0; items[i] != NULL && data->digest == NULL; i++)
+    {
+      gchar *value;
+
+      value = strchr (g_strstrip (items[i]), '=');
+      if (value == NULL)
+        continue;
+      *value++ = '\0';
+
+      if (g_ascii_strcasecmp (items[i], "sha-256") == 0)
+        data->digest_type = G_CHECKSUM_SHA256;
+      else if (g_ascii_strcasecmp (items[i], "sha-512") == 0)
+        data->digest_type = G_CHECKSUM_SHA512;
+      else
+        continue;
+
+      /* Structured fields wrap the bytes in colons */
+      data->digest = g_strdup (value);
+      g_strdelimit (data->digest, ":", ' ');
+      g_strstrip (data->digest);
+    }
+  g_strfreev (items);
+}
+
+static gboolean
+check_digest (RequestData   *data,
+              GCancellable  *cancellable,
+              GError       **error)
+{
+  GFileInputStream *input;
+  GChecksum *checksum;
+  guchar *expected;
+  guint8 *buffer;
+  guint8 digest[64];
+  gsize expected_len;
+  gsize digest_len = sizeof (digest);
+  gssize n_read;
+  gboolean result = FALSE;
+
+  input = g_file_read (data->partial, cancellable, error);
+  if (input == NULL)
+    return FALSE;
+
+  checksum = g_checksum_new (data->digest_type);
+  buffer = g_malloc (DIGEST_BUFFER_SIZE);
+
+  while ((n_read = g_input_stream_read (G_INPUT_STREAM (input), buffer,
+                                        DIGEST_BUFFER_SIZE, cancellable,
+                                        error)) > 0)
+    g_checksum_update (checksum, buffer, n_read);
+
+  if (n_read == 0)
+    {
+      g_checksum_get_digest (checksum, digest, &digest_len);
+      expected = g_base64_decode (data->digest, &expected_len);
+
+      result = expected_len == digest_len &&
+               memcmp (expected, digest, digest_len) == 0;
+      if (!result)
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                             "The digest of the download does not match");
+
+      g_free (expected);
+    }
+
+  g_free (buffer);
+  g_checksum_free (checksum);
+  g_object_unref (input);
+
+  return result;
+}
+
+/* Checks the whole download and moves it in place */
+static void
+download_verify_thread (GTask        *task,
+                        gpointer      source_object,
+                        gpointer      task_data,
+                        GCancellable *cancellable)
+{
+  RequestData *data = task_data;
+  gchar *basename;
+  gboolean is_po;
+  GError *error = NULL;
+
+  basename = g_file_get_basename (data->destination);
+  is_po = g_str_has_suffix (basename, ".po");
+  g_free (basename);
+
+  if ((data->digest != NULL && !check_digest (data, cancellable, &error)) ||
+      (is_po && !gtr_po_check_file (data->partial, &error)))
+    {
+      /* Corrupt, resuming it would not help */
+      download_discard (data);
+      g_task_return_error (task, error);
+      return;
+    }
+
+  /* The destination is only replaced once the whole file is written */
+  if (!g_file_move (data->partial, data->destination, G_FILE_COPY_OVERWRITE,
+                    cancellable, NULL, NULL, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_file_delete (data->validator, NULL, NULL);
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+download_spliced_cb (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  GTask *task = user_data;
+  RequestData *data = g_task_get_task_data (task);
+  GFileInfo *info;
+  goffset size;
+  GError *error = NULL;
+
+  /* An interrupted download is kept to be resumed */
+  if (g_output_stream_splice_finish (G_OUTPUT_STREAM (source_object),
+                                     result, &error) < 0)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  info = g_file_query_info (data->partial, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, NULL, &error);
+  if (info == NULL)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  size = g_file_info_get_size (info);
+  g_object_unref (info);
+
+  /* The connection may close before the whole file is sent */
+  if (data->expected >= 0 && size != data->expected)
+    {
+      if (size > data->expected)
+        download_discard (data);
+
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                               "Incomplete download: %" G_GOFFSET_FORMAT
+                               " of %" G_GOFFSET_FORMAT " bytes",
+                               size, data->expected);
+      g_object_unref (task);
+      return;
+    }
+
+  g_task_run_in_thread (task, download_verify_thread);
+  g_object_unref (task);
+}
+
+static void
+download_opened_cb (GObject      *source_object,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+  GTask *task = user_data;
+  RequestData *data = g_task_get_task_data (task);
+  GFileOutputStream *output;
+  GError *error = NULL;
+
+  if (data->offset > 0)
+    output = g_file_append_to_finish (G_FILE (source_object), result, &error);
+  else
+    output = g_file_replace_finish (G_FILE (source_object), result, &error);
+
+  if (output == NULL)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  g_output_stream_splice_async (G_OUTPUT_STREAM (output), data->input,
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                G_PRIORITY_DEFAULT,
+                                g_task_get_cancellable (task),
+                                download_spliced_cb, task);
+  g_object_unref (output);
+}
+
+/* Remembers which version of the file is being downloaded, so it's only
+ * resumed if it didn't change on the server */
+static void
+save_validator (RequestData *data)
+{
+  SoupMessageHeaders *headers = data->msg->response_headers;
+  const gchar *validator;
+
+  validator = soup_message_headers_get_one (headers, "ETag");
+  if (validator == NULL)
+    validator = soup_message_headers_get_one (headers, "Last-Modified");
+
+  if (validator == NULL)
+    g_file_delete (data->validator, NULL, NULL);
+  else
+    g_file_replace_contents (data->validator, validator, strlen (validator),
+                             NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL, NULL);
+}
+
+static void
+download_sent_cb (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GTask *task = user_data;
+  RequestData *data = g_task_get_task_data (task);
+  SoupMessageHeaders *headers = data->msg->response_headers;
+  GError *error = NULL;
+
+  data->input = soup_session_send_finish (SOUP_SESSION (source_object),
+                                          result, &error);
+  if (data->input == NULL)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  /* The partial file is longer than the file, start again */
+  if (data->msg->status_code == SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE &&
+      data->offset > 0)
+    {
+      SoupURI *uri;
+
+      download_discard (data);
+      g_clear_object (&data->input);
+
+      uri = soup_uri_copy (soup_message_get_uri (data->msg));
+      g_object_unref (data->msg);
+      data->msg = soup_message_new_from_uri ("GET", uri);
+      soup_uri_free (uri);
+
+      download_send (task);
+      return;
+    }
+
+  if (!check_status (data->msg, &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  save_digest (data);
+
+  if (data->msg->status_code == SOUP_STATUS_PARTIAL_CONTENT)
+    {
+      goffset start, end, total;
+
+      if (!soup_message_headers_get_content_range (headers, &start, &end, &total) ||
+          start != data->offset)
+        {
+          download_discard (data);
+          g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                                   "Invalid range in the response");
+          g_object_unref (task);
+          return;
+        }
+
+      data->expected = total;
+      g_file_append_to_async (data->partial, G_FILE_CREATE_NONE,
+                              G_PRIORITY_DEFAULT,
+                              g_task_get_cancellable (task),
+                              download_opened_cb, task);
+    }
+  else
+    {
+      /* The whole file, because it changed or ranges are not supported */
+      data->offset = 0;
+      data->expected = -1;
+      if (soup_message_headers_get_encoding (headers) == SOUP_ENCODING_CONTENT_LENGTH)
+        data->expected = soup_message_headers_get_content_length (headers);
+
+      save_validator (data);
+      g_file_replace_async (data->partial, NULL, FALSE, G_FILE_CREATE_NONE,
+                            G_PRIORITY_DEFAULT,
+                            g_task_get_cancellable (task),
+                            download_opened_cb, task);
+    }
+}
+
+static void
+download_send (GTask *task)
+{
+  RequestData *data = g_task_get_task_data (task);
+  GFileInfo *info;
+  gchar *validator = NULL;
+
+  data->offset = 0;
+
+  /* Resume what a previous attempt left, if the file is the same */
+  info = g_file_query_info (data->partial, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (info != NULL &&
+      g_file_load_contents (data->validator, NULL, &validator, NULL, NULL, NULL))
+    {
+      data->offset = g_file_info_get_size (info);
+      if (data->offset > 0)
+        {
+          soup_message_headers_set_range (data->msg->request_headers,
+                                          data->offset, -1);
+          soup_message_headers_replace (data->msg->request_headers,
+                                        "If-Range", validator);
+        }
+    }
+
+  g_clear_object (&info);
+  g_free (validator);
+
+  /* Sizes and ranges must refer to the file as it's saved */
+  soup_message_disable_feature (data->msg, SOUP_TYPE_CONTENT_DECODER);
+
+  soup_session_send_async (gtr_dl_client_get_session (), data->msg,
+                           g_task_get_cancellable (task),
+                           download_sent_cb, task);
+}
+
+/**
+ * gtr_dl_client_download_async:
+ * @path: the path of the file on the server
+ * @destination: where to save the file
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called once the file is saved
+ * @user_data: data for @callback
+ *
+ * Downloads @path into @destination. The file is written to
+ * "@destination.part" and only moved to @destination once its size, its
+ * digest if the server sent one and, for PO files, its syntax are
+ * checked. If a previous download was interrupted, it's resumed as long as
+ * the file didn't change on the server.
+ */
+void
+gtr_dl_client_download_async (const gchar         *path,
+                              GFile               *destination,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+  RequestData *data;
+  GTask *task;
+  gchar *uri, *partial_uri, *validator_uri;
+
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (G_IS_FILE (destination));
+
+  task = request_new (path, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_dl_client_download_async);
+
+  data = g_task_get_task_data (task);
+  data->destination = g_object_ref (destination);
+
+  uri = g_file_get_uri (destination);
+  partial_uri = g_strconcat (uri, ".part", NULL);
+  validator_uri = g_strconcat (uri, ".part.validator", NULL);
+  data->partial = g_file_new_for_uri (partial_uri);
+  data->validator = g_file_new_for_uri (validator_uri);
+  g_free (validator_uri);
+  g_free (partial_uri);
+  g_free (uri);
+
+  download_send (task);
+}
+
+gboolean
+gtr_dl_client_download_finish (GAsyncResult  *result,
+                               GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+SoupSession *gtr_dl_client_get_session            (void);
+
+SoupURI     *gtr_dl_client_get_uri                (const gchar          *path);
+
+void         gtr_dl_client_get_json_async         (const gchar          *path,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+
+JsonNode    *gtr_dl_client_get_json_finish        (GAsyncResult         *result,
+                                                   gboolean             *not_modified,
+                                                   GError              **error);
+
+void         gtr_dl_client_get_cached_json_async  (const gchar          *path,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+
+JsonNode    *gtr_dl_client_get_cached_json_finish (GAsyncResult         *result,
+                                                   GError              **error);
+
+void         gtr_dl_client_download_async         (const gchar          *path,
+                                                   GFile                *destination,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+
+gboolean     gtr_dl_client_download_finish        (GAsyncResult         *result,
+                                                   GError              **error);
+
+G_END_DECLS
@@ -21,16 +21,16 @@
 #endif
 
 #include "gtr-actions.h"
+#include "gtr-dl-batch.h"
+#include "gtr-dl-client.h"
 #include "gtr-dl-teams.h"
 #include "gtr-window.h"
 #include "gtr-utils.h"
-#include <libsoup/soup.h>
 
+#include <glib/gi18n.h>
 #include <json-glib/json-glib.h>
 #include <json-glib/json-gobject.h>
 
-#define API_URL "https://l10n.gnome.org/api/v1/"
-
 typedef struct
 {
   GtkWidget *titlebar;
@@ -42,24 +42,48 @@ typedef struct
   GtkWidget *stats_label;
   GtkWidget *file_label;
   GtkWidget *instructions;
+  GtkWidget *batch_button;
+  GtkWidget *batch_progress;
+  GtkWidget *batch_stop_button;
 
   GtkWidget *teams_combobox;
   GtkWidget *modules_combobox;
+  GtkWidget *modules_entry;
   GtkWidget *domains_combobox;
   GtkWidget *branches_combobox;
 
   GtkListStore *teams_store;
   GtkListStore *modules_store;
+  GtkTreeModel *modules_filter;
   GtkListStore *domains_store;
   GtkListStore *branches_store;
 
   gchar *selected_team;
   gchar *selected_module;
   gchar *selected_branch;
-  const gchar *selected_domain;
+  gchar *selected_domain;
   const gchar *file_path;
 
   GtrWindow *main_window;
+
+  /* Requests to the server, cancelled with the widget */
+  GCancellable *cancellable;
+  /* Module details and file info, cancelled by a new selection */
+  GCancellable *details_cancellable;
+  GCancellable *info_cancellable;
+
+  /* Modules still to be added to the list, a few on every idle */
+  GPtrArray *modules_pending;
+  guint modules_next;
+  guint modules_idle;
+  GCancellable *modules_cancellable;
+
+  /* Casefolded text of the modules search entry */
+  gchar *modules_search;
+
+  /* Download of all the domains, if running */
+  GtrDlBatch *batch;
+  GCancellable *batch_cancellable;
 } GtrDlTeamsPrivate;
 
 struct _GtrDlTeams
@@ -73,6 +97,40 @@ static void team_add_cb (GtkButton *btn, GtrDlTeams *self);
 static void gtr_dl_teams_save_combo_selected (GtkComboBox *combo, GtrDlTeams *self);
 static void gtr_dl_teams_load_po_file (GtkButton *button, GtrDlTeams *self);
 static void gtr_dl_teams_get_file_info (GtrDlTeams *self);
+static void gtr_dl_teams_update_batch_button (GtrDlTeams *self);
+
+static void
+show_warning (GtrDlTeams  *self,
+              const gchar *format,
+              const gchar *message)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  GtkWidget *dialog;
+
+  dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
+                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                   GTK_MESSAGE_WARNING,
+                                   GTK_BUTTONS_CLOSE,
+                                   format,
+                                   message);
+  gtk_dialog_run (GTK_DIALOG (dialog));
+  gtk_widget_destroy (dialog);
+}
+
+/* Replaces the cancellable of a request, cancelling the previous one */
+static GCancellable *
+renew_cancellable (GCancellable **cancellable)
+{
+  if (*cancellable != NULL)
+    {
+      g_cancellable_cancel (*cancellable);
+      g_object_unref (*cancellable);
+    }
+
+  *cancellable = g_cancellable_new ();
+
+  return *cancellable;
+}
 
 static void
 gtr_dl_teams_list_add (JsonArray *array,
@@ -88,123 +146,376 @@ gtr_dl_teams_list_add (JsonArray *array,
                                     -1);
 }
 
-static void
-gtr_dl_modules_list_add (JsonArray *array,
-                         guint      index,
-                         JsonNode  *element,
-                         gpointer   data)
+typedef void (*FillFunc) (GtrDlTeams *self,
+                          JsonNode   *node);
+
+/* A cached response is shown at once and replaced if the server has a
+ * newer one */
+typedef struct
 {
-  JsonObject *object = json_node_get_object (element);
+  GtrDlTeams *self;
+  gchar *path;
+  GCancellable *cancellable;
+  FillFunc fill;
+  const gchar *error_format;
+  gboolean filled;
+} Fetch;
 
-  gtk_list_store_insert_with_values(data, NULL, -1,
-                                    0, json_object_get_string_member (object, "name"),
-                                    -1);
+static void
+fetch_free (Fetch *fetch)
+{
+  g_free (fetch->path);
+  g_clear_object (&fetch->cancellable);
+  g_slice_free (Fetch, fetch);
 }
 
 static void
-gtr_dl_teams_parse_teams_json (GObject *object,
-                               GAsyncResult *result,
-                               gpointer user_data)
+fetch_fresh_cb (GObject      *object,
+                GAsyncResult *result,
+                gpointer      user_data)
 {
-  g_autoptr(JsonParser) parser = json_parser_new ();
-  g_autoptr(GInputStream) stream = NULL;
+  Fetch *fetch = user_data;
+  g_autoptr(JsonNode) node = NULL;
+  gboolean not_modified = FALSE;
   GError *error = NULL;
-  JsonNode *node = NULL;
-  JsonArray *array = NULL;
 
-  GtrDlTeams *widget = GTR_DL_TEAMS (user_data);
-  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (widget);
+  node = gtr_dl_client_get_json_finish (result, &not_modified, &error);
 
-  GtkWidget *dialog;
+  /* The widget may be gone, don't touch it */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      fetch_free (fetch);
+      return;
+    }
 
-  /* Parse JSON */
-  stream = soup_session_send_finish (SOUP_SESSION (object), result, &error);
+  if (error != NULL)
+    {
+      /* Offline, the cached response is good enough */
+      if (!fetch->filled)
+        show_warning (fetch->self, fetch->error_format, error->message);
+      g_error_free (error);
+    }
+  else if (!fetch->filled || !not_modified)
+    fetch->fill (fetch->self, node);
 
-  if (error)
+  fetch_free (fetch);
+}
+
+static void
+fetch_cached_cb (GObject      *object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  Fetch *fetch = user_data;
+  g_autoptr(JsonNode) node = NULL;
+  GError *error = NULL;
+
+  node = gtr_dl_client_get_cached_json_finish (result, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                             GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                             GTK_MESSAGE_WARNING,
-                                             GTK_BUTTONS_CLOSE,
-                                             "%s",
-                                             error->message);
-      gtk_dialog_run (GTK_DIALOG (dialog));
-      gtk_widget_destroy (dialog);
+      g_error_free (error);
+      fetch_free (fetch);
       return;
     }
 
-  json_parser_load_from_stream (parser, stream, NULL, NULL);
+  /* Not cached yet */
+  g_clear_error (&error);
+
+  if (node != NULL)
+    {
+      fetch->fill (fetch->self, node);
+      fetch->filled = TRUE;
+    }
+
+  gtr_dl_client_get_json_async (fetch->path, fetch->cancellable,
+                                fetch_fresh_cb, fetch);
+}
+
+static void
+fetch_json (GtrDlTeams   *self,
+            const gchar  *path,
+            GCancellable *cancellable,
+            FillFunc      fill,
+            const gchar  *error_format)
+{
+  Fetch *fetch;
+
+  fetch = g_slice_new0 (Fetch);
+  fetch->self = self;
+  fetch->path = g_strdup (path);
+  fetch->cancellable = g_object_ref (cancellable);
+  fetch->fill = fill;
+  fetch->error_format = error_format;
 
-  node = json_parser_get_root (parser);
-  array = json_node_get_array (node);
+  gtr_dl_client_get_cached_json_async (path, cancellable,
+                                       fetch_cached_cb, fetch);
+}
+
+/* Fills a list keeping the selected row, if it's still there */
+static void
+fill_combo (GtrDlTeams        *self,
+            GtkWidget         *combo,
+            GtkListStore      *store,
+            JsonNode          *node,
+            JsonArrayForeach   add_func,
+            gint               column,
+            const gchar       *selected)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (store);
+  GtkTreeIter iter;
+  gboolean valid;
 
-  /* Fill teams list store with values from JSON and set store as combo box model */
-  json_array_foreach_element (array, gtr_dl_teams_list_add, GTK_TREE_MODEL (priv->teams_store));
+  g_signal_handlers_block_by_func (combo, gtr_dl_teams_save_combo_selected, self);
 
-  gtk_combo_box_set_model (GTK_COMBO_BOX (priv->teams_combobox), GTK_TREE_MODEL (priv->teams_store));
+  gtk_list_store_clear (store);
+  json_array_foreach_element (json_node_get_array (node), add_func, store);
+  gtk_combo_box_set_model (GTK_COMBO_BOX (combo), model);
+
+  valid = selected != NULL && gtk_tree_model_get_iter_first (model, &iter);
+  while (valid)
+    {
+      g_autofree gchar *value = NULL;
+
+      gtk_tree_model_get (model, &iter, column, &value, -1);
+      if (g_strcmp0 (value, selected) == 0)
+        {
+          gtk_combo_box_set_active_iter (GTK_COMBO_BOX (combo), &iter);
+          break;
+        }
+
+      valid = gtk_tree_model_iter_next (model, &iter);
+    }
+
+  g_signal_handlers_unblock_by_func (combo, gtr_dl_teams_save_combo_selected, self);
 
   /* Enable selection */
-  gtk_widget_set_sensitive (priv->teams_combobox, TRUE);
+  gtk_widget_set_sensitive (combo, TRUE);
 }
 
 static void
-gtr_dl_teams_load_module_details_json (GtkComboBox *combo,
-                                       GtrDlTeams *self)
+gtr_dl_teams_fill_teams (GtrDlTeams *self,
+                         JsonNode   *node)
 {
   GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
-  g_autoptr(SoupMessage) msg = NULL;
-  g_autoptr(SoupSession) session = NULL;
-  g_autofree gchar *module_endpoint;
-  g_autoptr(JsonParser) parser = NULL;
-  gint i;
-  GError *error = NULL;
-  JsonNode *node = NULL;
-  JsonObject *object;
-  JsonNode *branchesNode;
-  JsonNode *domainsNode;
-  GtkWidget *dialog;
 
-  gtk_widget_hide (priv->file_label);
-  gtk_widget_show (priv->instructions);
-  gtk_label_set_text (GTK_LABEL (priv->stats_label), "");
+  fill_combo (self, priv->teams_combobox, priv->teams_store, node,
+              gtr_dl_teams_list_add, 1, priv->selected_team);
+}
 
-  /* Disable (down)load button */
-  gtk_widget_set_sensitive (priv->branches_combobox, FALSE);
-  gtk_widget_set_sensitive (priv->domains_combobox, FALSE);
-  gtk_widget_set_sensitive (priv->load_button, FALSE);
+/* Rows added to the modules list on every idle */
+#define MODULES_BATCH 200
 
-  gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (priv->branches_combobox));
-  gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (priv->domains_combobox));
+enum
+{
+  MODULE_NAME_COLUMN,
+  /* Casefolded name, so filtering doesn't fold every row on every key */
+  MODULE_KEY_COLUMN
+};
 
-  /* Get module details JSON from DL API */
-  module_endpoint = g_strconcat ((const gchar *)API_URL, "modules/", priv->selected_module, NULL);
-  msg = soup_message_new ("GET", module_endpoint);
-  session = soup_session_new ();
-  soup_session_send_message (session, msg);
+typedef struct
+{
+  gchar *name;
+  gchar *key;
+} ModuleEntry;
+
+static void
+module_entry_free (ModuleEntry *entry)
+{
+  g_free (entry->name);
+  g_free (entry->key);
+  g_slice_free (ModuleEntry, entry);
+}
+
+static gchar *
+search_key (const gchar *text)
+{
+  g_autofree gchar *normalized = NULL;
 
-  if (!SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+
+  return g_utf8_casefold (normalized, -1);
+}
+
+/* Builds the rows out of the main thread */
+static void
+modules_index_thread (GTask        *task,
+                      gpointer      source_object,
+                      gpointer      task_data,
+                      GCancellable *cancellable)
+{
+  JsonArray *array;
+  GPtrArray *entries;
+  guint i, length;
+
+  array = JSON_NODE_HOLDS_ARRAY (task_data) ? json_node_get_array (task_data) : NULL;
+  length = array != NULL ? json_array_get_length (array) : 0;
+  entries = g_ptr_array_new_full (length, (GDestroyNotify) module_entry_free);
+
+  for (i = 0; i < length; i++)
     {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                       GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                       GTK_MESSAGE_WARNING,
-                                       GTK_BUTTONS_CLOSE,
-                                       "Error loading module info: %s",
-                                       soup_status_get_phrase (msg->status_code));
-      gtk_dialog_run (GTK_DIALOG (dialog));
-      gtk_widget_destroy (dialog);
-      return;
+      JsonObject *object = json_array_get_object_element (array, i);
+      const gchar *name;
+      ModuleEntry *entry;
+
+      name = object != NULL ? json_object_get_string_member (object, "name") : NULL;
+      if (name == NULL)
+        continue;
+
+      entry = g_slice_new (ModuleEntry);
+      entry->name = g_strdup (name);
+      entry->key = search_key (name);
+      g_ptr_array_add (entries, entry);
+    }
+
+  g_task_return_pointer (task, entries, (GDestroyNotify) g_ptr_array_unref);
+}
+
+static gboolean
+gtr_dl_teams_add_modules (gpointer user_data)
+{
+  GtrDlTeams *self = user_data;
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  guint end;
+
+  end = MIN (priv->modules_next + MODULES_BATCH, priv->modules_pending->len);
+
+  g_signal_handlers_block_by_func (priv->modules_combobox, gtr_dl_teams_save_combo_selected, self);
+
+  for (; priv->modules_next < end; priv->modules_next++)
+    {
+      ModuleEntry *entry = g_ptr_array_index (priv->modules_pending, priv->modules_next);
+      GtkTreeIter iter, filter_iter;
+
+      gtk_list_store_insert_with_values (priv->modules_store, &iter, -1,
+                                         MODULE_NAME_COLUMN, entry->name,
+                                         MODULE_KEY_COLUMN, entry->key,
+                                         -1);
+
+      /* A refreshed list keeps the selected module */
+      if (g_strcmp0 (entry->name, priv->selected_module) == 0 &&
+          gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (priv->modules_filter),
+                                                            &filter_iter, &iter))
+        gtk_combo_box_set_active_iter (GTK_COMBO_BOX (priv->modules_combobox), &filter_iter);
+    }
+
+  g_signal_handlers_unblock_by_func (priv->modules_combobox, gtr_dl_teams_save_combo_selected, self);
+
+  /* The loaded modules can be selected while the rest are added */
+  gtk_widget_set_sensitive (priv->modules_combobox, TRUE);
+  gtk_widget_set_sensitive (priv->modules_entry, TRUE);
+
+  if (priv->modules_next < priv->modules_pending->len)
+    return G_SOURCE_CONTINUE;
+
+  g_clear_pointer (&priv->modules_pending, g_ptr_array_unref);
+  priv->modules_idle = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtr_dl_teams_modules_indexed (GObject      *source_object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  GtrDlTeams *self;
+  GtrDlTeamsPrivate *priv;
+  GPtrArray *entries;
+
+  /* A newer list arrived or the widget is gone */
+  entries = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (entries == NULL)
+    return;
+
+  self = GTR_DL_TEAMS (user_data);
+  priv = gtr_dl_teams_get_instance_private (self);
+
+  g_signal_handlers_block_by_func (priv->modules_combobox, gtr_dl_teams_save_combo_selected, self);
+  gtk_list_store_clear (priv->modules_store);
+  g_signal_handlers_unblock_by_func (priv->modules_combobox, gtr_dl_teams_save_combo_selected, self);
+
+  priv->modules_pending = entries;
+  priv->modules_next = 0;
+  priv->modules_idle = g_idle_add (gtr_dl_teams_add_modules, self);
+}
+
+static void
+gtr_dl_teams_fill_modules (GtrDlTeams *self,
+                           JsonNode   *node)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  GTask *task;
+
+  if (priv->modules_idle != 0)
+    {
+      g_source_remove (priv->modules_idle);
+      priv->modules_idle = 0;
     }
+  g_clear_pointer (&priv->modules_pending, g_ptr_array_unref);
 
-  parser = json_parser_new ();
+  task = g_task_new (NULL, renew_cancellable (&priv->modules_cancellable),
+                     gtr_dl_teams_modules_indexed, self);
+  g_task_set_task_data (task, json_node_ref (node), (GDestroyNotify) json_node_unref);
+  g_task_run_in_thread (task, modules_index_thread);
+  g_object_unref (task);
+}
 
-  /* Load response body and fill branches and domains, then show widgets */
-  json_parser_load_from_data (parser, msg->response_body->data, msg->response_body->length, &error);
-  node = json_parser_get_root (parser);
+static gboolean
+gtr_dl_teams_module_visible (GtkTreeModel *model,
+                             GtkTreeIter  *iter,
+                             gpointer      user_data)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (GTR_DL_TEAMS (user_data));
+  g_autofree gchar *key = NULL;
+
+  if (priv->modules_search == NULL || *priv->modules_search == '\0')
+    return TRUE;
+
+  gtk_tree_model_get (model, iter, MODULE_KEY_COLUMN, &key, -1);
+
+  return key != NULL && strstr (key, priv->modules_search) != NULL;
+}
+
+static void
+gtr_dl_teams_search_modules (GtkSearchEntry *entry,
+                             GtrDlTeams     *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+
+  g_free (priv->modules_search);
+  priv->modules_search = search_key (gtk_entry_get_text (GTK_ENTRY (entry)));
+
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (priv->modules_filter));
+}
+
+static void
+gtr_dl_teams_fill_module_details (GtrDlTeams *self,
+                                  JsonNode   *node)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  g_autofree gchar *branch = NULL;
+  g_autofree gchar *domain = NULL;
+  gint i;
+  JsonObject *object_json;
+  JsonNode *branchesNode;
+  JsonNode *domainsNode;
 
-  object = json_node_get_object(node);
+  /* A refreshed response keeps the selected branch and domain */
+  branch = g_strdup (gtk_combo_box_get_active_id (GTK_COMBO_BOX (priv->branches_combobox)));
+  domain = g_strdup (gtk_combo_box_get_active_id (GTK_COMBO_BOX (priv->domains_combobox)));
+
+  g_signal_handlers_block_by_func (priv->branches_combobox, gtr_dl_teams_save_combo_selected, self);
+  g_signal_handlers_block_by_func (priv->domains_combobox, gtr_dl_teams_save_combo_selected, self);
+
+  gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (priv->branches_combobox));
+  gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (priv->domains_combobox));
+
+  object_json = json_node_get_object (node);
 
   /* branches */
-  branchesNode = json_object_get_member (object, "branches");
+  branchesNode = json_object_get_member (object_json, "branches");
 
   if (branchesNode != NULL)
     {
@@ -226,7 +537,7 @@ gtr_dl_teams_load_module_details_json (GtkComboBox *combo,
   // TODO: check why there are no branches, display notification to user
 
   /* domains */
-  domainsNode = json_object_get_member (object, "domains");
+  domainsNode = json_object_get_member (object_json, "domains");
 
   if (domainsNode != NULL)
     {
@@ -246,66 +557,64 @@ gtr_dl_teams_load_module_details_json (GtkComboBox *combo,
       gtk_widget_set_sensitive (priv->domains_combobox, TRUE);
     }
   // TODO: check why there are no domains and display notification to user
-}
 
-static void
-gtr_dl_teams_parse_modules_json (GObject *object,
-                                 GAsyncResult *result,
-                                 gpointer user_data)
-{
-  g_autoptr(JsonParser) parser = json_parser_new ();
-  g_autoptr(GInputStream) stream = NULL;
-	GError *error = NULL;
+  if (branch != NULL)
+    gtk_combo_box_set_active_id (GTK_COMBO_BOX (priv->branches_combobox), branch);
+  if (domain != NULL)
+    gtk_combo_box_set_active_id (GTK_COMBO_BOX (priv->domains_combobox), domain);
 
-  JsonNode *node = NULL;
-  JsonArray *array = NULL;
+  /* The handler is blocked, and the domain may be gone */
+  g_free (priv->selected_domain);
+  priv->selected_domain = g_strdup (gtk_combo_box_get_active_id (GTK_COMBO_BOX (priv->domains_combobox)));
 
-  GtrDlTeams *widget = GTR_DL_TEAMS (user_data);
-  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (widget);
+  g_signal_handlers_unblock_by_func (priv->branches_combobox, gtr_dl_teams_save_combo_selected, self);
+  g_signal_handlers_unblock_by_func (priv->domains_combobox, gtr_dl_teams_save_combo_selected, self);
 
-  GtkWidget *dialog;
+  gtr_dl_teams_update_batch_button (self);
+}
 
-  /* Parse JSON */
-  stream = soup_session_send_finish (SOUP_SESSION (object), result, &error);
-  if (error)
-    {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                             GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                             GTK_MESSAGE_WARNING,
-                                             GTK_BUTTONS_CLOSE,
-                                             "%s",
-                                             error->message);
-      gtk_dialog_run (GTK_DIALOG (dialog));
-      gtk_widget_destroy (dialog);
-      return;
-    }
+static void
+gtr_dl_teams_load_module_details_json (GtkComboBox *combo,
+                                       GtrDlTeams *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  g_autofree gchar *module_endpoint = NULL;
 
-  json_parser_load_from_stream (parser, stream, NULL, NULL);
+  gtk_widget_hide (priv->file_label);
+  gtk_widget_show (priv->instructions);
+  gtk_label_set_text (GTK_LABEL (priv->stats_label), "");
 
-  node = json_parser_get_root (parser);
-  array = json_node_get_array (node);
+  /* Disable (down)load button */
+  gtk_widget_set_sensitive (priv->branches_combobox, FALSE);
+  gtk_widget_set_sensitive (priv->domains_combobox, FALSE);
+  gtk_widget_set_sensitive (priv->load_button, FALSE);
 
-  /* Fill modules list store with values from JSON and set store as combo box model */
-  json_array_foreach_element (array, gtr_dl_modules_list_add, GTK_TREE_MODEL (priv->modules_store));
+  gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (priv->branches_combobox));
+  gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (priv->domains_combobox));
 
-  gtk_combo_box_set_model (GTK_COMBO_BOX (priv->modules_combobox), GTK_TREE_MODEL (priv->modules_store));
+  /* The file info of the previous module is not wanted anymore */
+  if (priv->info_cancellable != NULL)
+    g_cancellable_cancel (priv->info_cancellable);
 
-  gtk_widget_set_sensitive (priv->modules_combobox, TRUE);
+  /* Get module details JSON from DL API */
+  module_endpoint = g_strconcat ("modules/", priv->selected_module, NULL);
+  fetch_json (self, module_endpoint,
+              renew_cancellable (&priv->details_cancellable),
+              gtr_dl_teams_fill_module_details,
+              "Error loading module info: %s");
 }
 
 static void
 gtr_dl_teams_load_json (GtkButton *btn,
                         GtrDlTeams *self)
 {
-  /* Get team list JSON from DL */
-  g_autoptr(SoupSession) session = soup_session_new ();
-  g_autoptr(SoupMessage) message = soup_message_new ("GET", g_strconcat ((const gchar *)API_URL, "teams", NULL));
-  soup_session_send_async (session, message, NULL, gtr_dl_teams_parse_teams_json, self);
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
 
-  /* Get module list JSON from DL */
-  g_autoptr(SoupSession) session_modules = soup_session_new ();
-  g_autoptr(SoupMessage) message_modules = soup_message_new ("GET", g_strconcat ((const gchar *)API_URL, "modules", NULL));
-  soup_session_send_async (session_modules, message_modules, NULL, gtr_dl_teams_parse_modules_json, self);
+  /* Both lists are requested at once on the shared session */
+  fetch_json (self, "teams", priv->cancellable,
+              gtr_dl_teams_fill_teams, "%s");
+  fetch_json (self, "modules", priv->cancellable,
+              gtr_dl_teams_fill_modules, "%s");
 }
 
 void gtr_dl_teams_verify_and_load (GtrDlTeams *self)
@@ -328,58 +637,39 @@ void gtr_dl_teams_verify_and_load (GtrDlTeams *self)
 }
 
 static void
-gtr_dl_teams_get_file_info (GtrDlTeams *self)
+gtr_dl_teams_parse_file_info (GObject      *source_object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
 {
-  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
-  gchar *stats_endpoint;
-  JsonNode *node = NULL;
-  g_autoptr(JsonParser) parser = NULL;
-  g_autoptr(JsonObject) object = NULL;
-  SoupMessage *msg;
-  SoupSession *session;
+  g_autoptr(JsonNode) node = NULL;
+  GtrDlTeams *self;
+  GtrDlTeamsPrivate *priv;
   GError *error = NULL;
+  JsonObject *object;
   JsonNode *stats_node;
   JsonObject *stats_object;
   const char *format;
   char *markup;
-  GtkWidget *dialog;
 
-  /* API endpoint: modules/[module]/branches/[branch]/domains/[domain]/languages/[team] */
-  stats_endpoint = g_strconcat ((const gchar *)API_URL,
-                                 "modules/",
-                                 priv->selected_module,
-                                 "/branches/",
-                                 priv->selected_branch,
-                                 "/domains/",
-                                 priv->selected_domain,
-                                 "/languages/",
-                                 priv->selected_team,
-                                 NULL);
-
-  msg = soup_message_new ("GET", stats_endpoint);
-  session = soup_session_new ();
-  soup_session_send_message (session, msg);
-
-  if (!SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
+  node = gtr_dl_client_get_json_finish (result, NULL, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                       GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                       GTK_MESSAGE_WARNING,
-                                       GTK_BUTTONS_CLOSE,
-                                       "Error loading file info: %s",
-                                       soup_status_get_phrase (msg->status_code));
-      gtk_dialog_run (GTK_DIALOG (dialog));
-      gtk_widget_destroy (dialog);
+      g_error_free (error);
       return;
     }
 
-  parser = json_parser_new ();
+  self = GTR_DL_TEAMS (user_data);
+  priv = gtr_dl_teams_get_instance_private (self);
 
-  /* Load response body and get path to PO file */
-  json_parser_load_from_data (parser, msg->response_body->data, msg->response_body->length, &error);
-  node = json_parser_get_root (parser);
+  if (error)
+    {
+      show_warning (self, "Error loading file info: %s", error->message);
+      g_error_free (error);
+      return;
+    }
 
-  object = json_node_get_object(node);
+  object = json_node_get_object (node);
 
   /* Save file path; escape the string - slashes inside! */
   priv->file_path = g_strescape (json_object_get_string_member (object, "po_file"), "");
@@ -412,93 +702,250 @@ gtr_dl_teams_get_file_info (GtrDlTeams *self)
 }
 
 static void
-gtr_dl_teams_load_po_file (GtkButton *button, GtrDlTeams *self)
+gtr_dl_teams_get_file_info (GtrDlTeams *self)
 {
   GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
-  SoupMessage *msg;
-  SoupSession *session;
-  GError *error = NULL;
-  GFile *tmp_file = NULL;
-  GFileIOStream *iostream = NULL;
-  GOutputStream *output = NULL;
-  gsize bytes = 0;
-  GtkWidget *dialog;
-  g_autoptr(GFile) dest_file = NULL;
+  g_autofree gchar *stats_endpoint = NULL;
+
+  /* API endpoint: modules/[module]/branches/[branch]/domains/[domain]/languages/[team] */
+  stats_endpoint = g_strconcat ("modules/",
+                                priv->selected_module,
+                                "/branches/",
+                                priv->selected_branch,
+                                "/domains/",
+                                priv->selected_domain,
+                                "/languages/",
+                                priv->selected_team,
+                                NULL);
+
+  gtr_dl_client_get_json_async (stats_endpoint,
+                                renew_cancellable (&priv->info_cancellable),
+                                gtr_dl_teams_parse_file_info,
+                                self);
+}
 
-  /* Load the file, save as temp; path to file is https://l10n.gnome.org/[priv->file_path] */
-  session = soup_session_new ();
-  msg = soup_message_new ("GET", g_strconcat ("https://l10n.gnome.org", g_strcompress(priv->file_path), NULL));
-  soup_session_send_message (session, msg);
+static void
+gtr_dl_teams_po_file_downloaded (GObject      *source_object,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  GFile *dest_file = user_data;
+  GtrDlTeams *self;
+  GtrDlTeamsPrivate *priv;
+  GError *error = NULL;
 
-	if (!SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
+  if (!gtr_dl_client_download_finish (result, &error))
     {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                       GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                       GTK_MESSAGE_WARNING,
-                                       GTK_BUTTONS_CLOSE,
-                                       "Error loading file: %s",
-                                       soup_status_get_phrase (msg->status_code));
-      gtk_dialog_run (GTK_DIALOG (dialog));
-      gtk_widget_destroy (dialog);
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          self = g_object_get_data (G_OBJECT (dest_file), "dl-teams");
+          show_warning (self, "Error loading file: %s", error->message);
+        }
+
+      g_error_free (error);
+      g_object_unref (dest_file);
       return;
     }
 
-  tmp_file = g_file_new_tmp (NULL, &iostream, &error);
+  self = g_object_get_data (G_OBJECT (dest_file), "dl-teams");
+  priv = gtr_dl_teams_get_instance_private (self);
 
+  gtr_open (dest_file, priv->main_window, &error);
   if (error != NULL)
     {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                       GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                       GTK_MESSAGE_WARNING,
-                                       GTK_BUTTONS_CLOSE,
-                                       "Error creating temp file: %s",
-                                       error->message);
-      gtk_dialog_run (GTK_DIALOG (dialog));
-      gtk_widget_destroy (dialog);
+      show_warning (self, "%s", error->message);
       g_error_free (error);
-      return;
     }
 
-  output = g_io_stream_get_output_stream (G_IO_STREAM (iostream));
-  g_output_stream_write_all (output,
-                             msg->response_body->data,
-                             msg->response_body->length,
-                             &bytes,
-                             NULL,
-                             &error);
+  g_object_unref (dest_file);
+}
 
-  if (error != NULL)
+static void
+gtr_dl_teams_load_po_file (GtkButton *button, GtrDlTeams *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  g_autofree gchar *file_path = NULL;
+  g_autofree gchar *basename = NULL;
+  g_autofree gchar *dest_path = NULL;
+  GFile *dest_file;
+
+  /* The path to the file is relative to the server, like /POT/... */
+  file_path = g_strcompress (priv->file_path);
+
+  /* Save file to /tmp; file basename is the part from last / character on */
+  basename = g_path_get_basename (file_path);
+  dest_path = g_build_filename (g_get_tmp_dir (), basename, NULL);
+  dest_file = g_file_new_for_path (dest_path);
+  g_object_set_data (G_OBJECT (dest_file), "dl-teams", self);
+
+  gtr_dl_client_download_async (file_path, dest_file, priv->cancellable,
+                                gtr_dl_teams_po_file_downloaded, dest_file);
+}
+
+static void
+gtr_dl_teams_update_batch_button (GtrDlTeams *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  GtkTreeModel *domains;
+
+  domains = gtk_combo_box_get_model (GTK_COMBO_BOX (priv->domains_combobox));
+
+  gtk_widget_set_sensitive (priv->batch_button,
+                            priv->batch == NULL &&
+                            priv->selected_team != NULL &&
+                            priv->selected_module != NULL &&
+                            priv->selected_branch != NULL &&
+                            gtk_tree_model_iter_n_children (domains, NULL) > 0);
+}
+
+static void
+gtr_dl_teams_batch_reset (GtrDlTeams *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+
+  if (priv->batch != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (priv->batch, self);
+      g_clear_object (&priv->batch);
+    }
+
+  if (priv->batch_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->batch_cancellable);
+      g_clear_object (&priv->batch_cancellable);
+    }
+
+  gtk_widget_hide (priv->batch_stop_button);
+  gtk_widget_show (priv->batch_button);
+  gtr_dl_teams_update_batch_button (self);
+}
+
+static void
+gtr_dl_teams_batch_progress (GtrDlBatch *batch,
+                             guint       completed,
+                             guint       total,
+                             GtrDlTeams *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  g_autofree gchar *text = NULL;
+
+  /* Translators: progress of the download of several PO files */
+  text = g_strdup_printf (_("%u of %u files"), completed, total);
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->batch_progress),
+                                 (gdouble) completed / total);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (priv->batch_progress), text);
+}
+
+static void
+gtr_dl_teams_batch_done (GObject      *source_object,
+                         GAsyncResult *result,
+                         gpointer      user_data)
+{
+  GtrDlTeams *self;
+  GtrDlTeamsPrivate *priv;
+  GError *error = NULL;
+
+  /* Stopped, or the widget is gone */
+  if (!gtr_dl_batch_run_finish (GTR_DL_BATCH (source_object), result, &error) &&
+      g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                       GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                       GTK_MESSAGE_WARNING,
-                                       GTK_BUTTONS_CLOSE,
-                                       "Error writing stream: %s",
-                                       error->message);
       g_error_free (error);
       return;
     }
 
-  /* Save file to /tmp; file basename is the part from last / character on */
-  dest_file = g_file_new_for_uri (g_strconcat ("file:///tmp", strrchr (priv->file_path, '/'), NULL));
-
-  g_file_copy (tmp_file, dest_file, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error);
+  self = GTR_DL_TEAMS (user_data);
+  priv = gtr_dl_teams_get_instance_private (self);
 
   if (error != NULL)
     {
-      dialog = gtk_message_dialog_new (GTK_WINDOW (priv->main_window),
-                                       GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                       GTK_MESSAGE_WARNING,
-                                       GTK_BUTTONS_CLOSE,
-                                       "Error creating tmp file %s",
-                                       error->message);
+      show_warning (self, "Error downloading files: %s", error->message);
       g_error_free (error);
+    }
+  else
+    gtk_progress_bar_set_text (GTK_PROGRESS_BAR (priv->batch_progress),
+                               _("All files downloaded"));
+
+  gtr_dl_teams_batch_reset (self);
+}
+
+static void
+gtr_dl_teams_batch_stop (GtkButton  *button,
+                         GtrDlTeams *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+
+  /* The files downloaded so far are kept; running it again resumes */
+  gtr_dl_teams_batch_reset (self);
+  gtk_widget_hide (priv->batch_progress);
+}
+
+static void
+gtr_dl_teams_batch_download (GtkButton  *button,
+                             GtrDlTeams *self)
+{
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (self);
+  GtkFileChooserNative *native;
+  GtkTreeModel *domains;
+  GtkTreeIter iter;
+  gboolean valid;
+  GFile *directory;
+  gint id_column;
+
+  native = gtk_file_chooser_native_new (_("Select project directory"),
+                                        GTK_WINDOW (priv->main_window),
+                                        GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER,
+                                        _("_OK"),
+                                        _("_Cancel"));
+
+  if (gtk_native_dialog_run (GTK_NATIVE_DIALOG (native)) != GTK_RESPONSE_ACCEPT)
+    {
+      g_object_unref (native);
       return;
     }
 
-  gtr_open (dest_file, priv->main_window, &error);
+  directory = gtk_file_chooser_get_file (GTK_FILE_CHOOSER (native));
+  g_object_unref (native);
+
+  priv->batch = gtr_dl_batch_new (directory);
+  priv->batch_cancellable = g_cancellable_new ();
+  g_object_unref (directory);
 
-  g_object_unref (tmp_file);
+  /* One file for every domain of the branch */
+  domains = gtk_combo_box_get_model (GTK_COMBO_BOX (priv->domains_combobox));
+  id_column = gtk_combo_box_get_id_column (GTK_COMBO_BOX (priv->domains_combobox));
+
+  for (valid = gtk_tree_model_get_iter_first (domains, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (domains, &iter))
+    {
+      g_autofree gchar *domain = NULL;
+      g_autofree gchar *endpoint = NULL;
+
+      gtk_tree_model_get (domains, &iter, id_column, &domain, -1);
+      endpoint = g_strconcat ("modules/",
+                              priv->selected_module,
+                              "/branches/",
+                              priv->selected_branch,
+                              "/domains/",
+                              domain,
+                              "/languages/",
+                              priv->selected_team,
+                              NULL);
+      gtr_dl_batch_add (priv->batch, endpoint);
+    }
+
+  g_signal_connect (priv->batch, "progress",
+                    G_CALLBACK (gtr_dl_teams_batch_progress), self);
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->batch_progress), 0.0);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (priv->batch_progress), NULL);
+  gtk_widget_show (priv->batch_progress);
+  gtk_widget_hide (priv->batch_button);
+  gtk_widget_show (priv->batch_stop_button);
+
+  gtr_dl_batch_run_async (priv->batch, priv->batch_cancellable,
+                          gtr_dl_teams_batch_done, self);
 }
 
 static void
@@ -510,6 +957,10 @@ gtr_dl_teams_save_combo_selected (GtkComboBox *combo,
   GtkTreePath *path;
   const gchar *name;
 
+  /* The list of teams or modules was cleared */
+  if (gtk_combo_box_get_active (combo) < 0 && !GTK_IS_COMBO_BOX_TEXT (combo))
+    return;
+
   path = gtk_tree_path_new_from_indices (gtk_combo_box_get_active (combo), -1);
 
   /* Save selected combo option */
@@ -517,8 +968,10 @@ gtr_dl_teams_save_combo_selected (GtkComboBox *combo,
 
   if (strcmp(name, "combo_modules") == 0)
     {
-      gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->modules_store), &iter, path);
-      gtk_tree_model_get (GTK_TREE_MODEL (priv->modules_store), &iter, 0, &priv->selected_module, -1);
+      /* The list of modules is filtered */
+      gtk_combo_box_get_active_iter (combo, &iter);
+      gtk_tree_model_get (gtk_combo_box_get_model (combo), &iter,
+                          MODULE_NAME_COLUMN, &priv->selected_module, -1);
       /* Reload module details on module change */
       gtr_dl_teams_load_module_details_json (combo, self);
     }
@@ -533,9 +986,12 @@ gtr_dl_teams_save_combo_selected (GtkComboBox *combo,
     }
   else if (strcmp(name, "combo_domains") == 0)
     {
-      priv->selected_domain = gtk_combo_box_get_active_id (GTK_COMBO_BOX (combo));
+      g_free (priv->selected_domain);
+      priv->selected_domain = g_strdup (gtk_combo_box_get_active_id (GTK_COMBO_BOX (combo)));
     }
 
+  gtr_dl_teams_update_batch_button (self);
+
   /* Check if all four required values have been selected to proceed with loading PO file */
   gtr_dl_teams_verify_and_load (self);
 }
@@ -543,12 +999,54 @@ gtr_dl_teams_save_combo_selected (GtkComboBox *combo,
 static void
 gtr_dl_teams_dispose (GObject *object)
 {
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (GTR_DL_TEAMS (object));
+
+  /* Pending callbacks must not touch the widget anymore */
+  if (priv->cancellable != NULL)
+    g_cancellable_cancel (priv->cancellable);
+  if (priv->details_cancellable != NULL)
+    g_cancellable_cancel (priv->details_cancellable);
+  if (priv->info_cancellable != NULL)
+    g_cancellable_cancel (priv->info_cancellable);
+
+  g_clear_object (&priv->cancellable);
+  g_clear_object (&priv->details_cancellable);
+  g_clear_object (&priv->info_cancellable);
+
+  if (priv->modules_cancellable != NULL)
+    g_cancellable_cancel (priv->modules_cancellable);
+  g_clear_object (&priv->modules_cancellable);
+
+  if (priv->modules_idle != 0)
+    {
+      g_source_remove (priv->modules_idle);
+      priv->modules_idle = 0;
+    }
+  g_clear_pointer (&priv->modules_pending, g_ptr_array_unref);
+  g_clear_object (&priv->modules_filter);
+
+  if (priv->batch != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (priv->batch, object);
+      g_clear_object (&priv->batch);
+    }
+  if (priv->batch_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->batch_cancellable);
+      g_clear_object (&priv->batch_cancellable);
+    }
+
   G_OBJECT_CLASS (gtr_dl_teams_parent_class)->dispose (object);
 }
 
 static void
 gtr_dl_teams_finalize (GObject *object)
 {
+  GtrDlTeamsPrivate *priv = gtr_dl_teams_get_instance_private (GTR_DL_TEAMS (object));
+
+  g_free (priv->modules_search);
+  g_free (priv->selected_domain);
+
   G_OBJECT_CLASS (gtr_dl_teams_parent_class)->finalize (object);
 }
 
@@ -571,6 +1069,9 @@ gtr_dl_teams_class_init (GtrDlTeamsClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, stats_label);
   gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, load_button);
   gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, instructions);
+  gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, batch_button);
+  gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, batch_progress);
+  gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, batch_stop_button);
 
   gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, open_button);
   gtk_widget_class_bind_template_child_private (widget_class, GtrDlTeams, dl_button);
@@ -585,12 +1086,17 @@ gtr_dl_teams_init (GtrDlTeams *self)
   gtk_widget_init_template (GTK_WIDGET (self));
 
   priv->main_window = NULL;
+  priv->cancellable = g_cancellable_new ();
 
   gtk_widget_set_sensitive (priv->load_button, FALSE);
 
   /* Init teams and modules list stores */
   priv->teams_store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
-  priv->modules_store = gtk_list_store_new (1, G_TYPE_STRING);
+  priv->modules_store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
+  priv->modules_filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (priv->modules_store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (priv->modules_filter),
+                                          gtr_dl_teams_module_visible,
+                                          self, NULL);
 
   /* Add combo boxes for DL teams and modules */
   priv->teams_combobox = gtk_combo_box_new ();
@@ -616,6 +1122,14 @@ gtr_dl_teams_init (GtrDlTeams *self)
                                   "text", 0,
                                   NULL);
 
+  gtk_combo_box_set_model (GTK_COMBO_BOX (priv->modules_combobox), priv->modules_filter);
+
+  /* Type-ahead search of the modules */
+  priv->modules_entry = gtk_search_entry_new ();
+  gtk_entry_set_placeholder_text (GTK_ENTRY (priv->modules_entry), _("Search modules"));
+  gtk_container_add (GTK_CONTAINER (priv->select_box), priv->modules_entry);
+  gtk_widget_set_sensitive (priv->modules_entry, FALSE);
+
   gtk_container_add (GTK_CONTAINER (priv->select_box), priv->modules_combobox);
   gtk_widget_set_sensitive (priv->modules_combobox, FALSE);
 
@@ -650,6 +1164,10 @@ gtr_dl_teams_init (GtrDlTeams *self)
                     "changed",
                     G_CALLBACK (gtr_dl_teams_save_combo_selected),
                     self);
+  g_signal_connect (priv->modules_entry,
+                    "search-changed",
+                    G_CALLBACK (gtr_dl_teams_search_modules),
+                    self);
   g_signal_connect (priv->domains_combobox,
                     "changed",
                     G_CALLBACK (gtr_dl_teams_save_combo_selected),
@@ -664,6 +1182,15 @@ gtr_dl_teams_init (GtrDlTeams *self)
                     "clicked",
                     G_CALLBACK (gtr_dl_teams_load_po_file),
                     self);
+
+  g_signal_connect (priv->batch_button,
+                    "clicked",
+                    G_CALLBACK (gtr_dl_teams_batch_download),
+                    self);
+  g_signal_connect (priv->batch_stop_button,
+                    "clicked",
+                    G_CALLBACK (gtr_dl_teams_batch_stop),
+                    self);
 }
 
 GtrDlTeams*
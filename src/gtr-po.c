@@ -112,6 +112,10 @@ enum
 
 static gchar *message_error = NULL;
 
+/* libgettextpo keeps the reader and error handler state in globals,
+ * so only one catalog can be read at a time. */
+G_LOCK_DEFINE_STATIC (gettext_po);
+
 static void
 gtr_po_set_property (GObject      *object,
                      guint         prop_id,
@@ -315,6 +319,31 @@ on_gettext_po_xerror2 (gint severity,
   message_error = g_strdup_printf ("%s.\n %s", message_text1, message_text2);
 }
 
+/* Only the errors make gtr_po_check_file() fail, not the warnings */
+static void
+on_check_xerror (gint severity,
+                 po_message_t message,
+                 const gchar * filename, size_t lineno, size_t column,
+                 gint multiline_p, const gchar * message_text)
+{
+  if (severity != PO_SEVERITY_WARNING && message_error == NULL)
+    message_error = g_strdup (message_text);
+}
+
+static void
+on_check_xerror2 (gint severity,
+                  po_message_t message1,
+                  const gchar * filename1, size_t lineno1,
+                  size_t column1, gint multiline_p1,
+                  const gchar * message_text1, po_message_t message2,
+                  const gchar * filename2, size_t lineno2,
+                  size_t column2, gint multiline_p2,
+                  const gchar * message_text2)
+{
+  if (severity != PO_SEVERITY_WARNING && message_error == NULL)
+    message_error = g_strdup_printf ("%s.\n %s", message_text1, message_text2);
+}
+
 static gboolean
 po_file_is_empty (po_file_t file)
 {
@@ -633,6 +662,8 @@ gtr_po_parse (GtrPo * po, GFile * location, GError ** error)
   g_return_val_if_fail (GTR_IS_PO (po), FALSE);
   g_return_val_if_fail (location != NULL, FALSE);
 
+  G_LOCK (gettext_po);
+
   if (message_error != NULL)
     {
       g_free (message_error);
@@ -646,6 +677,7 @@ gtr_po_parse (GtrPo * po, GFile * location, GError ** error)
 
   if (!_gtr_po_load_ensure_utf8 (po, error))
     {
+      G_UNLOCK (gettext_po);
       g_object_unref (po);
       return FALSE;
     }
@@ -659,6 +691,8 @@ gtr_po_parse (GtrPo * po, GFile * location, GError ** error)
                    GTR_PO_ERROR, GTR_PO_ERROR_RECOVERY, "%s", message_error);
     }
 
+  G_UNLOCK (gettext_po);
+
   /*
    * Determine the message domains to track
    */
@@ -804,6 +838,7 @@ gtr_po_save_file (GtrPo * po, GError ** error)
       return;
     }
 
+  G_LOCK (gettext_po);
   if (!po_file_write (gtr_po_get_po_file (po), filename, &handler))
     {
       g_set_error (error,
@@ -812,9 +847,12 @@ gtr_po_save_file (GtrPo * po, GError ** error)
                    _("There was an error writing the PO file: %s"),
                    message_error);
       g_free (message_error);
+      message_error = NULL;
+      G_UNLOCK (gettext_po);
       g_free (filename);
       return;
     }
+  G_UNLOCK (gettext_po);
   g_free (filename);
 
   /* If we are here everything is ok and we can set the state as saved */
@@ -1305,6 +1343,66 @@ gtr_po_get_message_position (GtrPo * po)
   return gtr_msg_get_po_position (GTR_MSG (priv->current->data));
 }
 
+/**
+ * gtr_po_check_file:
+ * @location: a PO file
+ * @error: a variable to store the errors
+ *
+ * Reads @location to check that it is a whole PO file, e.g. after a
+ * download, without loading it in a #GtrPo. The warnings of gettext are
+ * ignored. It can be called from any thread.
+ *
+ * Returns: %TRUE if gettext read the file without errors
+ **/
+gboolean
+gtr_po_check_file (GFile * location, GError ** error)
+{
+  struct po_xerror_handler handler;
+  po_file_t file;
+  gchar *filename;
+  gboolean result = FALSE;
+  gint saved_errno;
+
+  g_return_val_if_fail (G_IS_FILE (location), FALSE);
+
+  handler.xerror = &on_check_xerror;
+  handler.xerror2 = &on_check_xerror2;
+
+  filename = g_file_get_path (location);
+
+  G_LOCK (gettext_po);
+  g_clear_pointer (&message_error, g_free);
+
+  file = po_file_read (filename, &handler);
+  saved_errno = errno;
+
+  if (file == NULL)
+    g_set_error (error,
+                 GTR_PO_ERROR,
+                 GTR_PO_ERROR_FILENAME,
+                 _("Failed opening file “%s”: %s"),
+                 filename, g_strerror (saved_errno));
+  else if (message_error != NULL)
+    g_set_error (error,
+                 GTR_PO_ERROR, GTR_PO_ERROR_GETTEXT, "%s", message_error);
+  else if (po_file_is_empty (file))
+    g_set_error (error,
+                 GTR_PO_ERROR,
+                 GTR_PO_ERROR_FILE_EMPTY, _("The file is empty"));
+  else
+    result = TRUE;
+
+  if (file != NULL)
+    po_file_free (file);
+
+  g_clear_pointer (&message_error, g_free);
+  G_UNLOCK (gettext_po);
+
+  g_free (filename);
+
+  return result;
+}
+
 /**
  * gtr_po_check_po_file:
  * @po: a #GtrPo
@@ -1318,15 +1416,22 @@ gtr_po_check_po_file (GtrPo * po)
 {
   GtrPoPrivate *priv = gtr_po_get_instance_private (po);
   struct po_xerror_handler handler;
+  gchar *error;
 
   g_return_val_if_fail (po != NULL, NULL);
 
   handler.xerror = &on_gettext_po_xerror;
   handler.xerror2 = &on_gettext_po_xerror2;
+
+  G_LOCK (gettext_po);
   message_error = NULL;
 
   //TODO: handle error and mark wrong msgids
   po_file_check_all (priv->gettext_po_file, &handler);
 
-  return message_error;
+  error = message_error;
+  message_error = NULL;
+  G_UNLOCK (gettext_po);
+
+  return error;
 }
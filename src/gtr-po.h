@@ -155,6 +155,8 @@ gtr_po_get_message_position (GtrPo * po);
 
      gchar *gtr_po_check_po_file (GtrPo * po);
 
+     gboolean gtr_po_check_file (GFile * location, GError ** error);
+
 
 /* Unexported funcs */
      void
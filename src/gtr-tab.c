@@ -888,7 +888,7 @@ gtr_tab_new (GtrPo * po,
 
   priv = gtr_tab_get_instance_private (tab);
   gtr_context_init_tm (GTR_CONTEXT_PANEL (priv->context),
-                       gtr_window_get_tm (GTR_WINDOW (window)));
+                       gtr_window_get_tm_for_po (GTR_WINDOW (window), po));
 
   /* FIXME: make the po a property */
   priv->po = po;
@@ -45,7 +45,9 @@
 
 #include "translation-memory/gtr-translation-memory.h"
 #include "translation-memory/gtr-translation-memory-dialog.h"
-#include "translation-memory/gda/gtr-gda.h"
+#include "translation-memory/gtr-translation-memory-maintenance.h"
+#include "translation-memory/gtr-translation-memory-partitions.h"
+#include "translation-memory/gtr-translation-memory-pretranslate.h"
 
 #include "codeview/gtr-codeview.h"
 
@@ -68,7 +70,8 @@ typedef struct
 {
   GSettings *state_settings;
   GSettings *tm_settings;
-  GtrTranslationMemory *translation_memory;
+  GtrTranslationMemoryPartitions *tm_partitions;
+  guint tm_maintenance_id;
 
   GtrCodeView *codeview;
 
@@ -785,15 +788,11 @@ gtr_window_init (GtrWindow *window)
   gtk_widget_show_all (priv->stack);
 
   // translation memory
-  priv->translation_memory = GTR_TRANSLATION_MEMORY (gtr_gda_new());
   priv->tm_settings = g_settings_new ("org.gnome.gtranslator.plugins.translation-memory");
-  gtr_translation_memory_set_max_omits (priv->translation_memory,
-                                        g_settings_get_int (priv->tm_settings,
-                                                            "max-missing-words"));
-  gtr_translation_memory_set_max_delta (priv->translation_memory,
-                                        g_settings_get_int (priv->tm_settings,
-                                                            "max-length-diff"));
-  gtr_translation_memory_set_max_items (priv->translation_memory, 10);
+  priv->tm_partitions = gtr_translation_memory_partitions_get_default ();
+  priv->tm_maintenance_id =
+    gtr_translation_memory_maintain_when_idle (priv->tm_partitions,
+                                               priv->tm_settings);
 
   // code view
   priv->codeview = gtr_code_view_new (window);
@@ -827,7 +826,12 @@ gtr_window_dispose (GObject * object)
 
   g_clear_object (&priv->state_settings);
   g_clear_object (&priv->prof_manager);
-  g_clear_object (&priv->translation_memory);
+  if (priv->tm_maintenance_id != 0)
+    {
+      g_source_remove (priv->tm_maintenance_id);
+      priv->tm_maintenance_id = 0;
+    }
+  g_clear_object (&priv->tm_partitions);
   g_clear_object (&priv->tm_settings);
   g_clear_object (&priv->codeview);
 
@@ -1212,7 +1216,7 @@ gtr_window_show_tm_dialog (GtrWindow *window)
 
   if (dlg == NULL)
     {
-      dlg = gtr_translation_memory_dialog_new (priv->translation_memory);
+      dlg = gtr_translation_memory_dialog_new (gtr_window_get_tm (window));
       gtk_window_set_transient_for (GTK_WINDOW (dlg), GTK_WINDOW (window));
 
       g_signal_connect (dlg, "destroy",
@@ -1228,18 +1232,88 @@ gtr_window_show_tm_dialog (GtrWindow *window)
   gtk_window_present (GTK_WINDOW (dlg));
 }
 
+void
+gtr_window_pretranslate (GtrWindow *window)
+{
+  GtrWindowPrivate *priv = gtr_window_get_instance_private (window);
+  GtrTab *tab = gtr_window_get_active_tab (window);
+
+  if (!tab)
+    return;
+
+  gtr_translation_memory_pretranslate (gtr_window_get_tm_for_po (window,
+                                                                gtr_tab_get_po (tab)),
+                                       tab,
+                                       g_settings_get_int (priv->tm_settings,
+                                                           "pretranslate-min-score"));
+}
+
+/**
+ * gtr_window_get_tm:
+ * @window: a #GtrWindow
+ *
+ * Gets the translation memory of the language of the active profile.
+ *
+ * Returns: (transfer none): a #GtrTranslationMemory
+ */
 GtrTranslationMemory *
 gtr_window_get_tm (GtrWindow *window) {
   GtrWindowPrivate *priv = gtr_window_get_instance_private (window);
-  return priv->translation_memory;
+  GtrProfile *profile;
+  const gchar *language = NULL;
+
+  profile = gtr_profile_manager_get_active_profile (priv->prof_manager);
+  if (profile != NULL)
+    language = gtr_profile_get_language_code (profile);
+
+  return gtr_translation_memory_partitions_get (priv->tm_partitions, language);
+}
+
+/**
+ * gtr_window_get_tm_for_po:
+ * @window: a #GtrWindow
+ * @po: a #GtrPo
+ *
+ * Gets the translation memory of the language of @po, as stated by the
+ * Language field of its header or else by its profile or the active one.
+ *
+ * Returns: (transfer none): a #GtrTranslationMemory
+ */
+GtrTranslationMemory *
+gtr_window_get_tm_for_po (GtrWindow *window,
+                          GtrPo     *po)
+{
+  GtrWindowPrivate *priv = gtr_window_get_instance_private (window);
+  GtrTranslationMemory *tm;
+  GtrHeader *header;
+  GtrProfile *profile;
+  gchar *language;
+
+  header = gtr_po_get_header (po);
+  language = gtr_header_get_language_code (header);
+
+  if (language == NULL || *language == '\0')
+    {
+      g_free (language);
+
+      profile = gtr_header_get_profile (header);
+      if (profile == NULL)
+        return gtr_window_get_tm (window);
+
+      language = g_strdup (gtr_profile_get_language_code (profile));
+    }
+
+  tm = gtr_translation_memory_partitions_get (priv->tm_partitions, language);
+  g_free (language);
+
+  return tm;
 }
 
 void
 gtr_window_tm_keybind (GtrWindow *window,
                        GSimpleAction *action)
 {
-  GtrWindowPrivate *priv = gtr_window_get_instance_private (window);
-  GtrTranslationMemory *tm = priv->translation_memory;
+  GtrTranslationMemory *tm;
   GList *tm_list;
   const gchar *msgid;
   GtrTab *tab = gtr_window_get_active_tab (window);
@@ -1259,6 +1333,7 @@ gtr_window_tm_keybind (GtrWindow *window,
   po = gtr_tab_get_po (tab);
   msg = gtr_tab_get_msg (tab);
   msgid = gtr_msg_get_msgid (msg);
+  tm = gtr_window_get_tm_for_po (window, po);
   tm_list = gtr_translation_memory_lookup (tm, msgid);
 
   action_name = g_action_get_name (G_ACTION (action));
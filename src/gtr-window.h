@@ -82,7 +82,9 @@ void gtr_window_set_active_tab (GtrWindow * window, GtkWidget * tab);
 void _gtr_window_close_tab (GtrWindow * window, GtrTab * tab);
 
 GtrTranslationMemory * gtr_window_get_tm (GtrWindow *window);
+GtrTranslationMemory * gtr_window_get_tm_for_po (GtrWindow *window, GtrPo *po);
 void gtr_window_show_tm_dialog (GtrWindow *window);
+void gtr_window_pretranslate (GtrWindow *window);
 
 void gtr_window_remove_all_pages (GtrWindow *window);
 
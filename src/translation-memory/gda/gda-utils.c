@@ -25,6 +25,7 @@
 
 #include "gda-utils.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <glib.h>
@@ -55,98 +56,278 @@ static const gchar *badwords[] = {
   NULL
 };
 
+/* Longest word in badwords, longer words are never looked up */
+#define MAX_BADWORD_LEN 4
+
+/* Text made only of characters below this code point (Basic Latin,
+ * Latin-1 Supplement and Latin Extended-A/B) is split without Pango */
+#define LATIN_LIMIT 0x250
+
+/* Punctuation Pango keeps inside a word when it is between two letters
+ * or digits, as in "don't", "e.g" or "1,000" */
+#define MID_WORD_CHARS "'.,:;"
+
+/* The words of a phrase are stored in a single block: the NULL-terminated
+ * array of pointers followed by the text of the words. The phrase is walked
+ * twice, first to measure the block and then to fill it. */
+typedef struct
+{
+  guint n_words;
+  gsize n_bytes;
+
+  /* NULL while measuring */
+  gchar **words;
+  gchar *text;
+} WordArena;
+
+static GHashTable *
+get_badwords (void)
+{
+  static GHashTable *badwords_set = NULL;
+
+  if (g_once_init_enter (&badwords_set))
+    {
+      GHashTable *set = g_hash_table_new (g_str_hash, g_str_equal);
+      gint i;
+
+      for (i = 0; badwords[i] != NULL; i++)
+        g_hash_table_add (set, (gpointer) badwords[i]);
+
+      g_once_init_leave (&badwords_set, set);
+    }
+
+  return badwords_set;
+}
+
 static gboolean
-check_good_word (const gchar * word, gchar ** badwords)
+check_good_word (const gchar *word, gsize len)
 {
-  gboolean check = TRUE;
-  gchar *lower = g_utf8_strdown (word, -1);
-  gint i = 0;
+  gchar lower[MAX_BADWORD_LEN + 1];
+  gsize i;
 
-  while (badwords[i] != NULL)
+  /* All the bad words are short and ASCII */
+  if (len > MAX_BADWORD_LEN)
+    return TRUE;
+
+  for (i = 0; i < len; i++)
     {
-      gchar *lower_collate = g_utf8_collate_key (lower, -1);
+      if (!g_ascii_isalpha (word[i]))
+        return TRUE;
+      lower[i] = g_ascii_tolower (word[i]);
+    }
+  lower[len] = '\0';
 
-      if (strcmp (lower_collate, badwords[i]) == 0)
+  return !g_hash_table_contains (get_badwords (), lower);
+}
+
+static void
+word_arena_add (WordArena *arena, const gchar *word, gsize len)
+{
+  if (len == 0 || !check_good_word (word, len))
+    return;
+
+  if (arena->words != NULL)
+    {
+      arena->words[arena->n_words] = arena->text;
+      memcpy (arena->text, word, len);
+      arena->text[len] = '\0';
+      arena->text += len + 1;
+    }
+
+  arena->n_words++;
+  arena->n_bytes += len + 1;
+}
+
+/*
+ * Whether add_latin_words() splits @string at the same places as Pango,
+ * so the words match the ones already in the database. It is not the
+ * case for the punctuation and symbols Pango keeps inside words, like
+ * apostrophes, underscores or soft hyphens, nor where a letter touches a
+ * digit, so that text is still split by Pango.
+ */
+static gboolean
+is_latin_text (const gchar *string)
+{
+  const gchar *p = string;
+  gunichar prev = 0;
+
+  while (*p != '\0')
+    {
+      const gchar *next = g_utf8_next_char (p);
+      gunichar c = g_utf8_get_char (p);
+
+      if (c >= LATIN_LIMIT || c == '_')
+        return FALSE;
+
+      if (c < 0x80)
         {
-          check = FALSE;
-          g_free (lower_collate);
-          break;
+          if (strchr (MID_WORD_CHARS, c) != NULL &&
+              g_unichar_isalnum (prev) &&
+              g_unichar_isalnum (g_utf8_get_char (next)))
+            return FALSE;
         }
-      i++;
-      g_free (lower_collate);
+      /* Superscripts, fractions, the middle dot and soft hyphen */
+      else if (!g_unichar_isalpha (c) &&
+               !g_unichar_isspace (c) &&
+               (!g_unichar_ispunct (c) || c == 0xb7))
+        return FALSE;
+
+      if (g_unichar_isalnum (c) && g_unichar_isalnum (prev) &&
+          g_unichar_isdigit (c) != g_unichar_isdigit (prev))
+        return FALSE;
+
+      prev = c;
+      p = next;
     }
-  return check;
+
+  return TRUE;
 }
 
+/* Words are the runs of letters and digits */
+static void
+add_latin_words (const gchar *string, WordArena *arena)
+{
+  const gchar *p = string;
+  const gchar *start = NULL;
+
+  while (TRUE)
+    {
+      gboolean is_word_char;
+
+      if ((guchar) *p < 0x80)
+        is_word_char = g_ascii_isalnum (*p);
+      else
+        is_word_char = g_unichar_isalnum (g_utf8_get_char (p));
+
+      if (is_word_char && start == NULL)
+        start = p;
+      else if (!is_word_char && start != NULL)
+        {
+          word_arena_add (arena, start, p - start);
+          start = NULL;
+        }
+
+      if (*p == '\0')
+        break;
+
+      p = g_utf8_next_char (p);
+    }
+}
+
+static void
+add_pango_words (const gchar *string,
+                 PangoLogAttr *attrs,
+                 gint char_len,
+                 WordArena *arena)
+{
+  const gchar *s = string;
+  const gchar *start = NULL;
+  gint i;
+
+  for (i = 0; i <= char_len; i++)
+    {
+      if (attrs[i].is_word_start)
+        start = s;
+      if (attrs[i].is_word_end && start != NULL)
+        word_arena_add (arena, start, s - start);
+
+      s = g_utf8_next_char (s);
+    }
+}
 
 /**
  * gtr_gda_utils_split_string_in_words:
  * @string: the text to process
  *
- * Process a text and split it in words using pango.
- * 
- * Returns: an array of words of the processed text
+ * Process a text and split it in words. Text in Latin scripts is split at
+ * the characters that are not letters or digits when that gives the same
+ * words as pango, other text is split using pango.
+ *
+ * Returns: a %NULL-terminated array of words of the processed text, allocated
+ * as a single block that must be freed with g_free()
  */
 gchar **
 gtr_gda_utils_split_string_in_words (const gchar * string)
 {
-  PangoLanguage *lang = pango_language_from_string ("en");
-  PangoLogAttr *attrs;
-  GPtrArray *array;
-  gint char_len;
-  gint i = 0;
-  gchar *s;
-  gchar *start = NULL;
-  static gchar **badwords_collate = NULL;
-
-  if (badwords_collate == NULL)
+  WordArena arena = { 0, };
+  PangoLogAttr *attrs = NULL;
+  gint char_len = 0;
+  gboolean latin;
+  gchar **words;
+
+  latin = is_latin_text (string);
+
+  if (latin)
+    add_latin_words (string, &arena);
+  else
     {
-      gint words_size = g_strv_length ((gchar **) badwords);
-      gint x = 0;
+      PangoLanguage *lang = pango_language_from_string ("en");
 
-      badwords_collate = g_new0 (gchar *, words_size + 1);
+      char_len = g_utf8_strlen (string, -1);
+      attrs = g_new (PangoLogAttr, char_len + 1);
 
-      while (badwords[x] != NULL)
-        {
-          badwords_collate[x] = g_utf8_collate_key (badwords[x], -1);
-          x++;
-        }
-      badwords_collate[x] = NULL;
+      pango_get_log_attrs (string,
+                           strlen (string), -1, lang, attrs, char_len + 1);
+
+      add_pango_words (string, attrs, char_len, &arena);
     }
 
-  char_len = g_utf8_strlen (string, -1);
-  attrs = g_new (PangoLogAttr, char_len + 1);
+  words = g_malloc (sizeof (gchar *) * (arena.n_words + 1) + arena.n_bytes);
+  arena.words = words;
+  arena.text = (gchar *) (words + arena.n_words + 1);
+  arena.n_words = 0;
+  arena.n_bytes = 0;
 
-  pango_get_log_attrs (string,
-                       strlen (string), -1, lang, attrs, char_len + 1);
+  if (latin)
+    add_latin_words (string, &arena);
+  else
+    add_pango_words (string, attrs, char_len, &arena);
 
-  array = g_ptr_array_new ();
+  words[arena.n_words] = NULL;
 
-  s = (gchar *) string;
-  while (i <= char_len)
-    {
-      gchar *end;
+  g_free (attrs);
 
-      if (attrs[i].is_word_start)
-        start = s;
-      if (attrs[i].is_word_end)
-        {
-          gchar *word;
+  return words;
+}
 
-          end = s;
-          word = g_strndup (start, end - start);
+static int
+string_comparator (const void *s1, const void *s2)
+{
+  return strcmp (*(const gchar **) s1, *(const gchar **) s2);
+}
 
-          if (check_good_word (word, badwords_collate))
-            g_ptr_array_add (array, word);
-        }
+/**
+ * gtr_gda_utils_split_string_in_unique_words:
+ * @string: the text to process
+ *
+ * Like gtr_gda_utils_split_string_in_words() but the words are sorted and
+ * every word appears only once.
+ *
+ * Returns: an array of words of the processed text, to be freed with g_free()
+ */
+gchar **
+gtr_gda_utils_split_string_in_unique_words (const gchar *string)
+{
+  gchar **words = gtr_gda_utils_split_string_in_words (string);
+  gsize count = g_strv_length (words);
+  gsize w;
+  gsize r;
 
-      i++;
-      s = g_utf8_next_char (s);
-    }
+  if (count <= 1)
+    return words;
 
-  g_free (attrs);
-  g_ptr_array_add (array, NULL);
+  qsort (words, count, sizeof (gchar *), string_comparator);
 
-  return (gchar **) g_ptr_array_free (array, FALSE);
-}
+  w = 1;
+  for (r = 1; r < count; ++r)
+    {
+      if (0 != strcmp (words[r], words[w-1]))
+        {
+          words[w] = words[r];
+          ++w;
+        }
+    }
+  words[w] = NULL;
 
+  return words;
+}
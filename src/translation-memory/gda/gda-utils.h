@@ -26,6 +26,8 @@
 #include <gtk/gtk.h>
 #include <gio/gio.h>
 
-gchar **gtr_gda_utils_split_string_in_words (const gchar *string);
+gchar **gtr_gda_utils_split_string_in_words        (const gchar *string);
+
+gchar **gtr_gda_utils_split_string_in_unique_words (const gchar *string);
 
 #endif
@@ -23,19 +23,33 @@
 #include <sql-parser/gda-sql-parser.h>
 #include "gtr-gda.h"
 #include "gtr-translation-memory.h"
+#include "gtr-translation-memory-utils.h"
 #include "gtr-dirs.h"
 #include "gda-utils.h"
 
 #include <glib.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
+/* Entries read at a time by gtr_gda_foreach(), it must match the limit
+ * of stmt_select_entries */
+#define FOREACH_PAGE_SIZE 512
+
+enum
+{
+  PROP_0,
+  PROP_LANGUAGE
+};
+
 static void
 gtr_translation_memory_iface_init (GtrTranslationMemoryInterface * iface);
 
 typedef struct
 {
   GdaConnection *db;
+  gchar *filename;
+  gchar *language;
 
   GdaSqlParser *parser;
 
@@ -52,11 +66,29 @@ typedef struct
 
   GdaStatement *stmt_delete_trans;
 
+  GdaStatement *stmt_find_file;
+  GdaStatement *stmt_select_file_stamp;
+  GdaStatement *stmt_select_file_entries;
+  GdaStatement *stmt_insert_file;
+  GdaStatement *stmt_update_file;
+  GdaStatement *stmt_insert_file_entry;
+  GdaStatement *stmt_delete_file_entry;
+
+  GdaStatement *stmt_select_entries;
+
   guint max_omits;
   guint max_delta;
   gint max_items;
 
   GHashTable *lookup_query_cache;
+
+  /* Serializes access to the connection, the importer stores from a
+   * worker thread while the UI keeps doing lookups */
+  GMutex lock;
+
+  /* Set once open_thread() is done */
+  gint opened;
+  GCond opened_cond;
 } GtrGdaPrivate;
 
 G_DEFINE_TYPE_WITH_CODE (GtrGda,
@@ -66,6 +98,18 @@ G_DEFINE_TYPE_WITH_CODE (GtrGda,
                          G_IMPLEMENT_INTERFACE (GTR_TYPE_TRANSLATION_MEMORY,
                                                 gtr_translation_memory_iface_init))
 
+/* Takes priv->lock once the database has been opened */
+static void
+lock_database (GtrGda *self)
+{
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  g_mutex_lock (&priv->lock);
+
+  while (!priv->opened)
+    g_cond_wait (&priv->opened_cond, &priv->lock);
+}
+
 static gint
 select_integer (GdaConnection *db,
                 GdaStatement *stmt,
@@ -143,42 +187,30 @@ insert_row (GdaConnection *db,
   return result;
 }
 
-static int
-string_comparator (const void *s1, const void *s2)
-{
-  return strcmp (*(const gchar **) s1, *(const gchar **) s2);
-}
-
-static gchar **
-gtr_gda_split_string_in_words (const gchar *phrase)
+static gboolean
+execute_non_select (GdaConnection *db,
+                    GdaStatement *stmt,
+                    GdaSet *params,
+                    GError **error)
 {
-  gchar **words = gtr_gda_utils_split_string_in_words (phrase);
-  gsize count = g_strv_length (words);
-  gint w;
-  gint r;
+  gboolean result;
 
-  if (count <= 1)
-    return words;
+  result = gda_connection_statement_execute_non_select (db, stmt, params,
+                                                        NULL, error) != -1;
+  g_object_unref (params);
 
-  qsort (words, count, sizeof (gchar *), string_comparator);
+  return result;
+}
 
-  w = 1;
-  r = 1;
-  for (; r < count; ++r)
-    {
-      if (0 == strcmp (words[r], words[w-1]))
-        {
-          g_free (words[r]);
-        }
-      else
-        {
-          words[w] = words[r];
-          ++w;
-        }
-    }
-  words[w] = NULL;
+static gint64
+value_get_int64 (const GValue *val)
+{
+  if (G_VALUE_HOLDS_INT64 (val))
+    return g_value_get_int64 (val);
+  if (G_VALUE_HOLDS_INT (val))
+    return g_value_get_int (val);
 
-  return words;
+  return 0;
 }
 
 static void
@@ -271,7 +303,7 @@ gtr_gda_store_impl (GtrGda *self,
     {
       gsize sz, i;
 
-      words = gtr_gda_split_string_in_words (original);
+      words = gtr_gda_utils_split_string_in_unique_words (original);
       sz = g_strv_length (words);
 
       inner_error = NULL;
@@ -295,7 +327,7 @@ gtr_gda_store_impl (GtrGda *self,
             goto error;
         }
 
-      g_strfreev (words);
+      g_free (words);
     }
   else
     {
@@ -332,7 +364,7 @@ gtr_gda_store_impl (GtrGda *self,
   return TRUE;
 
  error:
-  g_strfreev (words);
+  g_free (words);
   g_propagate_error (error, inner_error);
   return FALSE;
 }
@@ -347,12 +379,15 @@ gtr_gda_store (GtrTranslationMemory * tm, GtrMsg * msg)
 
   g_return_val_if_fail (GTR_IS_GDA (self), FALSE);
 
+  lock_database (self);
+
   error = NULL;
   if (!gda_connection_begin_transaction (priv->db,
                                          NULL,
                                          GDA_TRANSACTION_ISOLATION_READ_COMMITTED,
                                          &error))
     {
+      g_mutex_unlock (&priv->lock);
       g_warning ("starting transaction failed: %s", error->message);
       g_error_free (error);
       return FALSE;
@@ -375,6 +410,8 @@ gtr_gda_store (GtrTranslationMemory * tm, GtrMsg * msg)
   else
     gda_connection_rollback_transaction (priv->db, NULL, NULL);
 
+  g_mutex_unlock (&priv->lock);
+
   return result;
 }
 
@@ -389,12 +426,15 @@ gtr_gda_store_list (GtrTranslationMemory * tm, GList * msgs)
 
   g_return_val_if_fail (GTR_IS_GDA (self), FALSE);
 
+  lock_database (self);
+
   error = NULL;
   if (!gda_connection_begin_transaction (priv->db,
                                          NULL,
                                          GDA_TRANSACTION_ISOLATION_READ_COMMITTED,
                                          &error))
     {
+      g_mutex_unlock (&priv->lock);
       g_warning ("starting transaction failed: %s", error->message);
       g_error_free (error);
       return FALSE;
@@ -425,6 +465,8 @@ gtr_gda_store_list (GtrTranslationMemory * tm, GList * msgs)
   else
     gda_connection_rollback_transaction (priv->db, NULL, NULL);
 
+  g_mutex_unlock (&priv->lock);
+
   return result;
 }
 
@@ -443,11 +485,13 @@ gtr_gda_remove (GtrTranslationMemory *tm,
                                translation_id);
 
   error = NULL;
+  lock_database (self);
   gda_connection_statement_execute_non_select (priv->db,
                                                priv->stmt_delete_trans,
                                                params,
                                                NULL,
                                                &error);
+  g_mutex_unlock (&priv->lock);
   if (error)
     {
       g_warning ("removing translation failed: %s", error->message);
@@ -457,6 +501,301 @@ gtr_gda_remove (GtrTranslationMemory *tm,
   g_object_unref (params);
 }
 
+static gboolean
+gtr_gda_get_file_stamp (GtrTranslationMemory *tm,
+                        const gchar *path,
+                        goffset *size,
+                        gint64 *mtime,
+                        gchar **hash)
+{
+  GtrGda *self = GTR_GDA (tm);
+  GdaSet *params;
+  GdaDataModel *model;
+  GError *error = NULL;
+  gboolean found = FALSE;
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  params = gda_set_new_inline (1, "path", G_TYPE_STRING, path);
+
+  lock_database (self);
+
+  model = gda_connection_statement_execute_select (priv->db,
+                                                   priv->stmt_select_file_stamp,
+                                                   params,
+                                                   &error);
+  if (model != NULL && gda_data_model_get_n_rows (model) > 0)
+    {
+      const GValue *val_size, *val_mtime, *val_hash;
+
+      val_size = gda_data_model_get_value_at (model, 0, 0, NULL);
+      val_mtime = gda_data_model_get_value_at (model, 1, 0, NULL);
+      val_hash = gda_data_model_get_value_at (model, 2, 0, NULL);
+
+      if (val_size && val_mtime && val_hash && G_VALUE_HOLDS_STRING (val_hash))
+        {
+          *size = value_get_int64 (val_size);
+          *mtime = value_get_int64 (val_mtime);
+          *hash = g_value_dup_string (val_hash);
+          found = TRUE;
+        }
+    }
+
+  g_mutex_unlock (&priv->lock);
+
+  if (error)
+    {
+      g_warning ("reading file stamp failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  if (model)
+    g_object_unref (model);
+  g_object_unref (params);
+
+  return found;
+}
+
+static gboolean
+gtr_gda_update_file_stamp (GtrGda *self,
+                           const gchar *path,
+                           goffset size,
+                           gint64 mtime,
+                           const gchar *hash,
+                           GError **error)
+{
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  return execute_non_select (priv->db,
+                             priv->stmt_update_file,
+                             gda_set_new_inline (4,
+                                                 "path", G_TYPE_STRING, path,
+                                                 "size", G_TYPE_INT64, (gint64) size,
+                                                 "mtime", G_TYPE_INT64, mtime,
+                                                 "hash", G_TYPE_STRING, hash),
+                             error);
+}
+
+static gboolean
+gtr_gda_set_file_stamp (GtrTranslationMemory *tm,
+                        const gchar *path,
+                        goffset size,
+                        gint64 mtime,
+                        const gchar *hash)
+{
+  GtrGda *self = GTR_GDA (tm);
+  GError *error = NULL;
+  gboolean result;
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  lock_database (self);
+  result = gtr_gda_update_file_stamp (self, path, size, mtime, hash, &error);
+  g_mutex_unlock (&priv->lock);
+
+  if (error)
+    {
+      g_warning ("updating file stamp failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  return result;
+}
+
+static GHashTable *
+gtr_gda_select_file_entries (GtrGda *self,
+                             gint file_id,
+                             GError **error)
+{
+  GdaSet *params;
+  GdaDataModel *model;
+  GHashTable *entries;
+  gint count, i;
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  params = gda_set_new_inline (1, "file_id", G_TYPE_INT, file_id);
+  model = gda_connection_statement_execute_select (priv->db,
+                                                   priv->stmt_select_file_entries,
+                                                   params,
+                                                   error);
+  g_object_unref (params);
+
+  if (!model)
+    return entries;
+
+  count = gda_data_model_get_n_rows (model);
+  for (i = 0; i < count; i++)
+    {
+      const GValue *val;
+
+      val = gda_data_model_get_typed_value_at (model, 0, i,
+                                               G_TYPE_STRING, FALSE,
+                                               NULL);
+      if (val)
+        g_hash_table_add (entries, g_value_dup_string (val));
+    }
+
+  g_object_unref (model);
+
+  return entries;
+}
+
+static gboolean
+gtr_gda_store_file_impl (GtrGda *self,
+                         const gchar *path,
+                         goffset size,
+                         gint64 mtime,
+                         const gchar *hash,
+                         GList *msgs,
+                         GError **error)
+{
+  GHashTable *old_entries;
+  GHashTable *new_entries;
+  GHashTableIter iter;
+  gpointer digest;
+  GError *inner_error = NULL;
+  GList *l;
+  gint file_id;
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  file_id = select_integer (priv->db,
+                            priv->stmt_find_file,
+                            gda_set_new_inline (1, "path", G_TYPE_STRING, path),
+                            &inner_error);
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return FALSE;
+    }
+
+  if (file_id == 0)
+    {
+      old_entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+      file_id = insert_row (priv->db,
+                            priv->stmt_insert_file,
+                            gda_set_new_inline (4,
+                                                "path", G_TYPE_STRING, path,
+                                                "size", G_TYPE_INT64, (gint64) size,
+                                                "mtime", G_TYPE_INT64, mtime,
+                                                "hash", G_TYPE_STRING, hash),
+                            &inner_error);
+    }
+  else
+    {
+      old_entries = gtr_gda_select_file_entries (self, file_id, &inner_error);
+      if (!inner_error)
+        gtr_gda_update_file_stamp (self, path, size, mtime, hash, &inner_error);
+    }
+
+  new_entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* Only the entries that were not in the previous import are stored,
+   * the rest of the translation memory is left untouched */
+  for (l = msgs; l && !inner_error; l = g_list_next (l))
+    {
+      GtrMsg *msg = GTR_MSG (l->data);
+      const gchar *original, *translation;
+      gchar *entry;
+
+      if (!gtr_msg_is_translated (msg) || gtr_msg_is_fuzzy (msg))
+        continue;
+
+      original = gtr_msg_get_msgid (msg);
+      translation = gtr_msg_get_msgstr (msg);
+      entry = gtr_translation_memory_utils_entry_digest (original, translation);
+
+      if (g_hash_table_contains (new_entries, entry))
+        {
+          g_free (entry);
+          continue;
+        }
+
+      if (!g_hash_table_remove (old_entries, entry))
+        {
+          if (gtr_gda_store_impl (self, original, translation, &inner_error))
+            execute_non_select (priv->db,
+                                priv->stmt_insert_file_entry,
+                                gda_set_new_inline (2,
+                                                    "file_id", G_TYPE_INT, file_id,
+                                                    "digest", G_TYPE_STRING, entry),
+                                &inner_error);
+        }
+
+      g_hash_table_add (new_entries, entry);
+    }
+
+  /* What is left are the entries that were removed from the file */
+  g_hash_table_iter_init (&iter, old_entries);
+  while (!inner_error && g_hash_table_iter_next (&iter, &digest, NULL))
+    {
+      execute_non_select (priv->db,
+                          priv->stmt_delete_file_entry,
+                          gda_set_new_inline (2,
+                                              "file_id", G_TYPE_INT, file_id,
+                                              "digest", G_TYPE_STRING, digest),
+                          &inner_error);
+    }
+
+  g_hash_table_unref (old_entries);
+  g_hash_table_unref (new_entries);
+
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtr_gda_store_file (GtrTranslationMemory *tm,
+                    const gchar *path,
+                    goffset size,
+                    gint64 mtime,
+                    const gchar *hash,
+                    GList *msgs)
+{
+  GtrGda *self = GTR_GDA (tm);
+  gboolean result;
+  GError *error;
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  g_return_val_if_fail (GTR_IS_GDA (self), FALSE);
+
+  lock_database (self);
+
+  error = NULL;
+  if (!gda_connection_begin_transaction (priv->db,
+                                         NULL,
+                                         GDA_TRANSACTION_ISOLATION_READ_COMMITTED,
+                                         &error))
+    {
+      g_mutex_unlock (&priv->lock);
+      g_warning ("starting transaction failed: %s", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  error = NULL;
+  result = gtr_gda_store_file_impl (self, path, size, mtime, hash, msgs, &error);
+
+  if (error)
+    {
+      g_warning ("storing file failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  if (result)
+    gda_connection_commit_transaction (priv->db, NULL, NULL);
+  else
+    gda_connection_rollback_transaction (priv->db, NULL, NULL);
+
+  g_mutex_unlock (&priv->lock);
+
+  return result;
+}
+
 static void
 free_match (gpointer data)
 {
@@ -567,13 +906,24 @@ gtr_gda_lookup (GtrTranslationMemory * tm, const gchar * phrase)
 
   g_return_val_if_fail (GTR_IS_GDA (self), NULL);
 
+  /* The UI finds nothing until the database is open, rather than
+   * blocking while it is, other threads wait for it */
+  if (!g_atomic_int_get (&priv->opened) &&
+      g_main_context_is_owner (g_main_context_default ()))
+    return NULL;
+
+  lock_database (self);
+
   if (!gda_connection_begin_transaction (priv->db,
                                          NULL,
                                          GDA_TRANSACTION_ISOLATION_READ_COMMITTED,
                                          NULL))
-    return NULL;
+    {
+      g_mutex_unlock (&priv->lock);
+      return NULL;
+    }
 
-  words = gtr_gda_split_string_in_words (phrase);
+  words = gtr_gda_utils_split_string_in_unique_words (phrase);
   cnt = g_strv_length (words);
 
   inner_error = NULL;
@@ -682,6 +1032,10 @@ gtr_gda_lookup (GtrTranslationMemory * tm, const gchar * phrase)
 
   gda_connection_rollback_transaction (priv->db, NULL, NULL);
 
+  g_mutex_unlock (&priv->lock);
+
+  g_free (words);
+
   if (inner_error)
     {
       g_list_free_full (matches, free_match);
@@ -703,8 +1057,10 @@ gtr_gda_set_max_omits (GtrTranslationMemory * tm, gsize omits)
   GtrGda *self = GTR_GDA (tm);
   GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
 
+  g_mutex_lock (&priv->lock);
   priv->max_omits = omits;
   g_hash_table_remove_all (priv->lookup_query_cache);
+  g_mutex_unlock (&priv->lock);
 }
 
 static void
@@ -713,8 +1069,10 @@ gtr_gda_set_max_delta (GtrTranslationMemory * tm, gsize delta)
   GtrGda *self = GTR_GDA (tm);
   GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
 
+  g_mutex_lock (&priv->lock);
   priv->max_delta = delta;
   g_hash_table_remove_all (priv->lookup_query_cache);
+  g_mutex_unlock (&priv->lock);
 }
 
 static void
@@ -723,8 +1081,186 @@ gtr_gda_set_max_items (GtrTranslationMemory * tm, gint items)
   GtrGda *self = GTR_GDA (tm);
   GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
 
+  g_mutex_lock (&priv->lock);
   priv->max_items = items;
   g_hash_table_remove_all (priv->lookup_query_cache);
+  g_mutex_unlock (&priv->lock);
+}
+
+/*
+ * The entries are read in pages so the lock is not held while @func runs,
+ * the last TRANS.ID seen is the start of the next page.
+ */
+static void
+gtr_gda_foreach (GtrTranslationMemory *tm,
+                 GtrTranslationMemoryForeachFunc func,
+                 gpointer user_data)
+{
+  GtrGda *self = GTR_GDA (tm);
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+  GPtrArray *page;
+  gint last_id = 0;
+  gboolean more = TRUE;
+
+  page = g_ptr_array_new_with_free_func (g_free);
+
+  while (more)
+    {
+      GdaDataModel *model;
+      GdaSet *params;
+      GError *error = NULL;
+      gint n_rows, i;
+      guint j;
+
+      params = gda_set_new_inline (1, "last_id", G_TYPE_INT, last_id);
+
+      lock_database (self);
+
+      model = gda_connection_statement_execute_select (priv->db,
+                                                       priv->stmt_select_entries,
+                                                       params,
+                                                       &error);
+      n_rows = model ? gda_data_model_get_n_rows (model) : 0;
+
+      for (i = 0; i < n_rows; i++)
+        {
+          const GValue *val_id, *val_orig, *val_trans;
+
+          val_id = gda_data_model_get_value_at (model, 0, i, NULL);
+          val_orig = gda_data_model_get_value_at (model, 1, i, NULL);
+          val_trans = gda_data_model_get_value_at (model, 2, i, NULL);
+
+          if (val_id)
+            last_id = (gint) value_get_int64 (val_id);
+
+          if (!val_orig || !G_VALUE_HOLDS_STRING (val_orig) ||
+              !val_trans || !G_VALUE_HOLDS_STRING (val_trans))
+            continue;
+
+          g_ptr_array_add (page, g_value_dup_string (val_orig));
+          g_ptr_array_add (page, g_value_dup_string (val_trans));
+        }
+
+      g_mutex_unlock (&priv->lock);
+
+      if (model)
+        g_object_unref (model);
+      g_object_unref (params);
+
+      if (error)
+        {
+          g_warning ("reading translations failed: %s", error->message);
+          g_error_free (error);
+          break;
+        }
+
+      /* A short page is the last one */
+      more = n_rows == FOREACH_PAGE_SIZE;
+
+      for (j = 0; j < page->len; j += 2)
+        if (!func (g_ptr_array_index (page, j),
+                   g_ptr_array_index (page, j + 1),
+                   user_data))
+          {
+            more = FALSE;
+            break;
+          }
+
+      g_ptr_array_set_size (page, 0);
+    }
+
+  g_ptr_array_unref (page);
+}
+
+/* Run by gtr_gda_maintain() in a single transaction, in this order */
+static const gchar *maintenance_sql[] = {
+  /* translations whose original is gone */
+  "delete from TRANS where not exists "
+  "(select 1 from ORIG where ORIG.ID=TRANS.ORIG_ID)",
+
+  /* identical translations of the same original, the first one is kept */
+  "delete from TRANS where ID not in "
+  "(select min(ID) from TRANS group by ORIG_ID, VALUE)",
+
+  /* originals left without translations by gtr_gda_remove() */
+  "delete from ORIG where not exists "
+  "(select 1 from TRANS where TRANS.ORIG_ID=ORIG.ID)",
+
+  "delete from WORD_ORIG_LINK where not exists "
+  "(select 1 from ORIG where ORIG.ID=WORD_ORIG_LINK.ORIG_ID)",
+
+  "delete from WORD where not exists "
+  "(select 1 from WORD_ORIG_LINK where WORD_ORIG_LINK.WORD_ID=WORD.ID)",
+
+  NULL
+};
+
+static gint64
+get_database_size (const gchar *filename)
+{
+  GStatBuf buf;
+
+  if (g_stat (filename, &buf) != 0)
+    return 0;
+
+  return buf.st_size;
+}
+
+static gboolean
+gtr_gda_maintain (GtrTranslationMemory *tm,
+                  GCancellable *cancellable,
+                  gint64 *reclaimed,
+                  GError **error)
+{
+  GtrGda *self = GTR_GDA (tm);
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+  gboolean result;
+  gint64 size;
+  gint i;
+
+  /* The GDA connection can't be shared, so the lookups wait for the
+   * maintenance to finish */
+  lock_database (self);
+
+  size = get_database_size (priv->filename);
+
+  result = gda_connection_begin_transaction (priv->db,
+                                             NULL,
+                                             GDA_TRANSACTION_ISOLATION_READ_COMMITTED,
+                                             error);
+
+  for (i = 0; result && maintenance_sql[i] != NULL; i++)
+    result = !g_cancellable_set_error_if_cancelled (cancellable, error) &&
+             gda_connection_execute_non_select_command (priv->db,
+                                                        maintenance_sql[i],
+                                                        error) >= 0;
+
+  if (result)
+    result = gda_connection_commit_transaction (priv->db, NULL, error);
+  else
+    gda_connection_rollback_transaction (priv->db, NULL, NULL);
+
+  if (result)
+    result = !g_cancellable_set_error_if_cancelled (cancellable, error) &&
+             gda_connection_execute_non_select_command (priv->db, "reindex", error) >= 0 &&
+             !g_cancellable_set_error_if_cancelled (cancellable, error) &&
+             gda_connection_execute_non_select_command (priv->db, "vacuum", error) >= 0 &&
+             gda_connection_execute_non_select_command (priv->db, "analyze", error) >= 0;
+
+  g_mutex_unlock (&priv->lock);
+
+  if (reclaimed != NULL)
+    *reclaimed = MAX (size - get_database_size (priv->filename), 0);
+
+  return result;
+}
+
+static gboolean
+gtr_gda_is_open (GtrTranslationMemory *tm)
+{
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (GTR_GDA (tm));
+
+  return g_atomic_int_get (&priv->opened);
 }
 
 static void
@@ -737,6 +1273,12 @@ gtr_translation_memory_iface_init (GtrTranslationMemoryInterface * iface)
   iface->set_max_omits = gtr_gda_set_max_omits;
   iface->set_max_delta = gtr_gda_set_max_delta;
   iface->set_max_items = gtr_gda_set_max_items;
+  iface->get_file_stamp = gtr_gda_get_file_stamp;
+  iface->set_file_stamp = gtr_gda_set_file_stamp;
+  iface->store_file = gtr_gda_store_file;
+  iface->foreach = gtr_gda_foreach;
+  iface->maintain = gtr_gda_maintain;
+  iface->is_open = gtr_gda_is_open;
 }
 
 static GdaStatement *
@@ -761,7 +1303,7 @@ prepare_statement(GdaSqlParser *parser, const gchar *query)
 }
 
 static void
-gtr_gda_init (GtrGda * self)
+open_database (GtrGda *self)
 {
   gchar *connection_string;
   GError *error = NULL;
@@ -772,14 +1314,25 @@ gtr_gda_init (GtrGda * self)
   {
     const gchar *config_dir;
     gchar *encoded_config_dir;
+    gchar *encoded_name;
+    gchar *name;
+    gchar *basename;
 
     config_dir = gtr_dirs_get_user_config_dir ();
     encoded_config_dir = gda_rfc1738_encode (config_dir);
+    name = gtr_translation_memory_utils_database_name (priv->language);
+    encoded_name = gda_rfc1738_encode (name);
 
     connection_string = g_strdup_printf ("DB_DIR=%s;"
-                                         "DB_NAME=translation-memory",
-                                         encoded_config_dir);
-
+                                         "DB_NAME=%s",
+                                         encoded_config_dir,
+                                         encoded_name);
+    basename = g_strconcat (name, ".db", NULL);
+    priv->filename = g_build_filename (config_dir, basename, NULL);
+
+    g_free (basename);
+    g_free (encoded_name);
+    g_free (name);
     g_free (encoded_config_dir);
   }
 
@@ -788,6 +1341,8 @@ gtr_gda_init (GtrGda * self)
                                                     NULL,
                                                     GDA_CONNECTION_OPTIONS_NONE,
                                                     &error);
+  g_free (connection_string);
+
   if (error)
     {
       g_warning ("Error creating database: %s", error->message);
@@ -827,6 +1382,49 @@ gtr_gda_init (GtrGda * self)
                                              "on TRANS (ORIG_ID)",
                                              NULL);
 
+  gda_connection_execute_non_select_command (priv->db,
+                                             "create index "
+                                             "if not exists IDX_WORD_ORIG_LINK_ORIG_ID "
+                                             "on WORD_ORIG_LINK (ORIG_ID)",
+                                             NULL);
+
+  gda_connection_execute_non_select_command (priv->db,
+                                             "create index "
+                                             "if not exists IDX_ORIG_SENTENCE_SIZE "
+                                             "on ORIG (SENTENCE_SIZE)",
+                                             NULL);
+
+  /* Imported PO files, to skip the unchanged ones on the next import */
+  gda_connection_execute_non_select_command (priv->db,
+                                             "create table FILE ("
+                                             "ID integer primary key autoincrement,"
+                                             "PATH text unique,"
+                                             "SIZE int64,"
+                                             "MTIME int64,"
+                                             "HASH text)",
+                                             NULL);
+
+  gda_connection_execute_non_select_command (priv->db,
+                                             "create table FILE_ENTRY ("
+                                             "FILE_ID integer,"
+                                             "DIGEST text,"
+                                             "primary key (FILE_ID, DIGEST))",
+                                             NULL);
+
+  /* GtrSqlite keeps a full text index of ORIG up to date with triggers
+   * that need FTS5, which the SQLite of libgda may lack. They are dropped
+   * so storing originals keeps working here, and GtrSqlite rebuilds the
+   * index when it opens the database in full text search mode again. */
+  gda_connection_execute_non_select_command (priv->db,
+                                             "drop trigger if exists ORIG_FTS_INSERT",
+                                             NULL);
+  gda_connection_execute_non_select_command (priv->db,
+                                             "drop trigger if exists ORIG_FTS_DELETE",
+                                             NULL);
+  gda_connection_execute_non_select_command (priv->db,
+                                             "drop trigger if exists ORIG_FTS_UPDATE",
+                                             NULL);
+
   /* prepare statements */
 
   priv->parser = gda_connection_create_parser (priv->db);
@@ -887,6 +1485,230 @@ gtr_gda_init (GtrGda * self)
                        "delete from TRANS "
                        "where id = ##id_trans::int");
 
+  priv->stmt_find_file =
+    prepare_statement (priv->parser,
+                       "select ID from FILE "
+                       "where PATH=##path::string");
+
+  priv->stmt_select_file_stamp =
+    prepare_statement (priv->parser,
+                       "select SIZE, MTIME, HASH from FILE "
+                       "where PATH=##path::string");
+
+  priv->stmt_select_file_entries =
+    prepare_statement (priv->parser,
+                       "select DIGEST from FILE_ENTRY "
+                       "where FILE_ID=##file_id::int");
+
+  priv->stmt_insert_file =
+    prepare_statement (priv->parser,
+                       "insert into "
+                       "FILE (PATH, SIZE, MTIME, HASH) "
+                       "values "
+                       "(##path::string, ##size::gint64, "
+                       "##mtime::gint64, ##hash::string)");
+
+  priv->stmt_update_file =
+    prepare_statement (priv->parser,
+                       "update FILE "
+                       "set SIZE=##size::gint64, MTIME=##mtime::gint64, "
+                       "HASH=##hash::string "
+                       "where PATH=##path::string");
+
+  priv->stmt_insert_file_entry =
+    prepare_statement (priv->parser,
+                       "insert into "
+                       "FILE_ENTRY (FILE_ID, DIGEST) "
+                       "values "
+                       "(##file_id::int, ##digest::string)");
+
+  priv->stmt_delete_file_entry =
+    prepare_statement (priv->parser,
+                       "delete from FILE_ENTRY "
+                       "where FILE_ID=##file_id::int "
+                       "and DIGEST=##digest::string");
+
+  priv->stmt_select_entries =
+    prepare_statement (priv->parser,
+                       "select TRANS.ID, ORIG.VALUE, TRANS.VALUE "
+                       "from TRANS, ORIG "
+                       "where ORIG.ID=TRANS.ORIG_ID "
+                       "and TRANS.ID>##last_id::int "
+                       "order by TRANS.ID "
+                       "limit 512");
+}
+
+static gint
+get_user_version (GtrGda *self)
+{
+  GdaDataModel *model;
+  const GValue *val;
+  gint version = 0;
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  model = gda_connection_execute_select_command (priv->db,
+                                                 "pragma user_version",
+                                                 NULL);
+  if (model == NULL)
+    return 0;
+
+  if (gda_data_model_get_n_rows (model) > 0)
+    {
+      val = gda_data_model_get_value_at (model, 0, 0, NULL);
+      if (val)
+        version = (gint) value_get_int64 (val);
+    }
+
+  g_object_unref (model);
+
+  return version;
+}
+
+/*
+ * GtrSqlite doesn't write the word tables in full text search mode, so
+ * the originals it stored meanwhile have no words. They are added once,
+ * a page at a time, as the links are inserted while reading ORIG.
+ */
+static void
+index_missing_words (GtrGda *self)
+{
+  GPtrArray *values;
+  GArray *ids;
+  gint last_id = 0;
+  gint n_rows;
+  GError *error = NULL;
+  gchar *pragma;
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  if (priv->db == NULL ||
+      get_user_version (self) >= GTR_TRANSLATION_MEMORY_WORD_INDEX_VERSION)
+    return;
+
+  if (!gda_connection_begin_transaction (priv->db,
+                                         NULL,
+                                         GDA_TRANSACTION_ISOLATION_READ_COMMITTED,
+                                         &error))
+    {
+      g_warning ("starting transaction failed: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  values = g_ptr_array_new_with_free_func (g_free);
+  ids = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  do
+    {
+      GdaDataModel *model;
+      gchar *query;
+      gint i;
+      guint j;
+
+      g_ptr_array_set_size (values, 0);
+      g_array_set_size (ids, 0);
+
+      query = g_strdup_printf ("select ID, VALUE from ORIG where ID>%d "
+                               "and not exists (select 1 from WORD_ORIG_LINK "
+                               "where WORD_ORIG_LINK.ORIG_ID=ORIG.ID) "
+                               "order by ID limit %d",
+                               last_id, FOREACH_PAGE_SIZE);
+      model = gda_connection_execute_select_command (priv->db, query, &error);
+      g_free (query);
+
+      n_rows = model ? gda_data_model_get_n_rows (model) : 0;
+
+      for (i = 0; i < n_rows; i++)
+        {
+          const GValue *val_id, *val_orig;
+
+          val_id = gda_data_model_get_value_at (model, 0, i, NULL);
+          val_orig = gda_data_model_get_value_at (model, 1, i, NULL);
+
+          if (val_id)
+            last_id = (gint) value_get_int64 (val_id);
+
+          if (!val_id || !val_orig || !G_VALUE_HOLDS_STRING (val_orig))
+            continue;
+
+          g_array_append_val (ids, last_id);
+          g_ptr_array_add (values, g_value_dup_string (val_orig));
+        }
+
+      if (model)
+        g_object_unref (model);
+
+      for (j = 0; j < values->len && !error; j++)
+        {
+          gchar **words;
+          gsize k;
+
+          words = gtr_gda_utils_split_string_in_unique_words (g_ptr_array_index (values, j));
+          for (k = 0; words[k] != NULL && !error; k++)
+            gtr_gda_words_append (self, words[k],
+                                  g_array_index (ids, gint, j), &error);
+          g_free (words);
+        }
+    }
+  while (n_rows > 0 && !error);
+
+  g_ptr_array_unref (values);
+  g_array_unref (ids);
+
+  if (error)
+    {
+      g_warning ("indexing the words of the originals failed: %s", error->message);
+      g_error_free (error);
+      gda_connection_rollback_transaction (priv->db, NULL, NULL);
+      return;
+    }
+
+  pragma = g_strdup_printf ("pragma user_version=%d",
+                            GTR_TRANSLATION_MEMORY_WORD_INDEX_VERSION);
+  gda_connection_execute_non_select_command (priv->db, pragma, NULL);
+  g_free (pragma);
+
+  gda_connection_commit_transaction (priv->db, NULL, NULL);
+}
+
+static gpointer
+open_thread (gpointer data)
+{
+  GtrGda *self = GTR_GDA (data);
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  open_database (self);
+  index_missing_words (self);
+
+  g_mutex_lock (&priv->lock);
+  g_atomic_int_set (&priv->opened, TRUE);
+  g_cond_broadcast (&priv->opened_cond);
+  g_mutex_unlock (&priv->lock);
+
+  g_object_unref (self);
+
+  return NULL;
+}
+
+/*
+ * Opening the connection, creating the tables and parsing the statements
+ * would delay the startup, so it is done on a thread of its own. Every
+ * access to the database waits for it in lock_database(), except lookups,
+ * which find nothing until it is done.
+ */
+static void
+gtr_gda_constructed (GObject * object)
+{
+  g_thread_unref (g_thread_new ("gtr-gda-open", open_thread,
+                                g_object_ref (object)));
+
+  G_OBJECT_CLASS (gtr_gda_parent_class)->constructed (object);
+}
+
+static void
+gtr_gda_init (GtrGda * self)
+{
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
   priv->max_omits = 0;
   priv->max_delta = 0;
   priv->max_items = 0;
@@ -895,6 +1717,47 @@ gtr_gda_init (GtrGda * self)
                                                           g_direct_equal,
                                                           NULL,
                                                           g_object_unref);
+
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->opened_cond);
+}
+
+static void
+gtr_gda_set_property (GObject * object,
+                      guint prop_id,
+                      const GValue * value,
+                      GParamSpec * pspec)
+{
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (GTR_GDA (object));
+
+  switch (prop_id)
+    {
+    case PROP_LANGUAGE:
+      priv->language = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gtr_gda_get_property (GObject * object,
+                      guint prop_id,
+                      GValue * value,
+                      GParamSpec * pspec)
+{
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (GTR_GDA (object));
+
+  switch (prop_id)
+    {
+    case PROP_LANGUAGE:
+      g_value_set_string (value, priv->language);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
 }
 
 static void
@@ -957,6 +1820,54 @@ gtr_gda_dispose (GObject * object)
       priv->stmt_delete_trans = NULL;
     }
 
+  if (priv->stmt_find_file != NULL)
+    {
+      g_object_unref (priv->stmt_find_file);
+      priv->stmt_find_file = NULL;
+    }
+
+  if (priv->stmt_select_file_stamp != NULL)
+    {
+      g_object_unref (priv->stmt_select_file_stamp);
+      priv->stmt_select_file_stamp = NULL;
+    }
+
+  if (priv->stmt_select_file_entries != NULL)
+    {
+      g_object_unref (priv->stmt_select_file_entries);
+      priv->stmt_select_file_entries = NULL;
+    }
+
+  if (priv->stmt_insert_file != NULL)
+    {
+      g_object_unref (priv->stmt_insert_file);
+      priv->stmt_insert_file = NULL;
+    }
+
+  if (priv->stmt_update_file != NULL)
+    {
+      g_object_unref (priv->stmt_update_file);
+      priv->stmt_update_file = NULL;
+    }
+
+  if (priv->stmt_insert_file_entry != NULL)
+    {
+      g_object_unref (priv->stmt_insert_file_entry);
+      priv->stmt_insert_file_entry = NULL;
+    }
+
+  if (priv->stmt_delete_file_entry != NULL)
+    {
+      g_object_unref (priv->stmt_delete_file_entry);
+      priv->stmt_delete_file_entry = NULL;
+    }
+
+  if (priv->stmt_select_entries != NULL)
+    {
+      g_object_unref (priv->stmt_select_entries);
+      priv->stmt_select_entries = NULL;
+    }
+
   if (priv->parser != NULL)
     {
       g_object_unref (priv->parser);
@@ -978,26 +1889,55 @@ gtr_gda_dispose (GObject * object)
   G_OBJECT_CLASS (gtr_gda_parent_class)->dispose (object);
 }
 
+static void
+gtr_gda_finalize (GObject * object)
+{
+  GtrGda *self = GTR_GDA (object);
+  GtrGdaPrivate *priv = gtr_gda_get_instance_private (self);
+
+  g_free (priv->filename);
+  g_free (priv->language);
+  g_mutex_clear (&priv->lock);
+  g_cond_clear (&priv->opened_cond);
+
+  G_OBJECT_CLASS (gtr_gda_parent_class)->finalize (object);
+}
+
 static void
 gtr_gda_class_init (GtrGdaClass * klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->constructed = gtr_gda_constructed;
+  object_class->set_property = gtr_gda_set_property;
+  object_class->get_property = gtr_gda_get_property;
   object_class->dispose = gtr_gda_dispose;
+  object_class->finalize = gtr_gda_finalize;
+
+  g_object_class_install_property (object_class,
+                                   PROP_LANGUAGE,
+                                   g_param_spec_string ("language",
+                                                        "Language",
+                                                        "Language code of the translations stored",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
 }
 
 /**
  * gtr_gda_new:
+ * @language: (nullable): language code of the translations stored
  *
- * Creates a new #GtrGda object.
+ * Creates a new #GtrGda object, using the database of @language.
  *
  * Returns: a new #GtrGda object
  */
 GtrGda *
-gtr_gda_new ()
+gtr_gda_new (const gchar *language)
 {
   GtrGda *gda;
 
-  gda = g_object_new (GTR_TYPE_GDA, NULL);
+  gda = g_object_new (GTR_TYPE_GDA, "language", language, NULL);
 
   return gda;
 }
@@ -48,7 +48,7 @@ GType                   gtr_gda_get_type                (void) G_GNUC_CONST;
 
 GType                   gtr_gda_register_type           (GTypeModule *module);
 
-GtrGda                 *gtr_gda_new                     (void);
+GtrGda                 *gtr_gda_new                     (const gchar *language);
 
 G_END_DECLS
 #endif /* __GDA_BACKEND_H__ */
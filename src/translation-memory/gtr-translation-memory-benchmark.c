@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark of the translation memory backends. A synthetic bilingual
+ * corpus is stored with gtr_translation_memory_store_list(), then some of
+ * its originals are looked up as they are and with one word replaced. The
+ * store throughput, the lookup latency percentiles and the share of
+ * lookups that find the expected translation are printed as JSON, so runs
+ * of different backends or tokenizers can be compared.
+ *
+ * The database is created in a temporary directory, the user's
+ * translation memory is never touched.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-dirs.h"
+#include "gtr-msg.h"
+#include "gtr-translation-memory.h"
+#include "gda/gtr-gda.h"
+#include "sqlite/gtr-sqlite.h"
+
+#include <gettext-po.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <json-glib/json-glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_WORDS 4
+#define MAX_WORDS 12
+
+static const gchar *source_syllables[] = {
+  "ka", "to", "mi", "re", "su", "la", "no", "pe", "di", "vo",
+  "an", "el", "is", "or", "un", "be", "ga", "hu", "je", "zo"
+};
+
+static const gchar *target_syllables[] = {
+  "ak", "ot", "im", "er", "us", "al", "on", "ep", "id", "ov",
+  "na", "le", "si", "ro", "nu", "eb", "ag", "uh", "ej", "oz"
+};
+
+static gint size = 10000;
+static gdouble duplicates = 0.1;
+static gint vocabulary = 5000;
+static gint queries = 1000;
+static gint batch_size = 1000;
+static gint seed = 1;
+static gchar *backend = NULL;
+
+static GOptionEntry entries[] = {
+  { "size", 0, 0, G_OPTION_ARG_INT, &size,
+    "Number of messages stored", "N" },
+  { "duplicates", 0, 0, G_OPTION_ARG_DOUBLE, &duplicates,
+    "Share of the messages that repeat an earlier one", "RATIO" },
+  { "vocabulary", 0, 0, G_OPTION_ARG_INT, &vocabulary,
+    "Number of distinct words", "N" },
+  { "queries", 0, 0, G_OPTION_ARG_INT, &queries,
+    "Number of lookups of each kind", "N" },
+  { "batch-size", 0, 0, G_OPTION_ARG_INT, &batch_size,
+    "Messages stored by each store_list call", "N" },
+  { "seed", 0, 0, G_OPTION_ARG_INT, &seed,
+    "Seed of the corpus generator", "N" },
+  { "backend", 0, 0, G_OPTION_ARG_STRING, &backend,
+    "gda, sqlite or sqlite-fts5 (gda by default)", "NAME" },
+  { NULL }
+};
+
+typedef struct
+{
+  gchar *original;
+  gchar *translation;
+} Entry;
+
+/* Spells @index in base 20 with @syllables, so every index is a different
+ * word and both languages get the same number of words */
+static void
+append_word (GString      *str,
+             const gchar **syllables,
+             gint          index)
+{
+  do
+    {
+      g_string_append (str, syllables[index % 20]);
+      index /= 20;
+    }
+  while (index > 0);
+}
+
+/* Word frequencies are skewed towards the first words of the vocabulary,
+ * like in real text */
+static gint
+random_word (GRand *rand)
+{
+  gdouble r = g_rand_double (rand);
+
+  return (gint) (r * r * vocabulary);
+}
+
+static Entry
+generate_entry (GRand *rand)
+{
+  GString *original = g_string_new (NULL);
+  GString *translation = g_string_new (NULL);
+  Entry entry;
+  gint n_words;
+  gint i;
+
+  n_words = g_rand_int_range (rand, MIN_WORDS, MAX_WORDS + 1);
+
+  for (i = 0; i < n_words; i++)
+    {
+      gint word = random_word (rand);
+
+      if (i > 0)
+        {
+          g_string_append_c (original, ' ');
+          g_string_append_c (translation, ' ');
+        }
+
+      append_word (original, source_syllables, word);
+      append_word (translation, target_syllables, word);
+    }
+
+  g_string_append_c (original, '.');
+  g_string_append_c (translation, '.');
+
+  entry.original = g_string_free (original, FALSE);
+  entry.translation = g_string_free (translation, FALSE);
+
+  return entry;
+}
+
+static GArray *
+generate_corpus (GRand *rand)
+{
+  GArray *corpus;
+  gint i;
+
+  corpus = g_array_sized_new (FALSE, FALSE, sizeof (Entry), size);
+
+  for (i = 0; i < size; i++)
+    {
+      Entry entry;
+
+      if (i > 0 && g_rand_double (rand) < duplicates)
+        {
+          Entry *earlier;
+
+          earlier = &g_array_index (corpus, Entry,
+                                    g_rand_int_range (rand, 0, i));
+          entry.original = g_strdup (earlier->original);
+          entry.translation = g_strdup (earlier->translation);
+        }
+      else
+        entry = generate_entry (rand);
+
+      g_array_append_val (corpus, entry);
+    }
+
+  return corpus;
+}
+
+/* Replaces one of the words of @original by another one */
+static gchar *
+perturb (GRand       *rand,
+         const gchar *original)
+{
+  gchar **words;
+  GString *word;
+  gchar *result;
+  guint n_words;
+  guint i;
+
+  words = g_strsplit (original, " ", -1);
+  n_words = g_strv_length (words);
+
+  /* The last word carries the full stop */
+  i = g_rand_int_range (rand, 0, n_words - 1);
+  word = g_string_new (NULL);
+  append_word (word, source_syllables, random_word (rand));
+  g_free (words[i]);
+  words[i] = g_string_free (word, FALSE);
+
+  result = g_strjoinv (" ", words);
+  g_strfreev (words);
+
+  return result;
+}
+
+static gdouble
+store_corpus (GtrTranslationMemory *tm,
+              GArray               *corpus)
+{
+  gint64 start;
+  guint i;
+
+  start = g_get_monotonic_time ();
+
+  for (i = 0; i < corpus->len; i += batch_size)
+    {
+      po_file_t file;
+      po_message_iterator_t iter;
+      GList *batch = NULL;
+      guint j;
+
+      /* The messages of a batch live in a scratch PO file */
+      file = po_file_create ();
+      iter = po_message_iterator (file, NULL);
+
+      for (j = i; j < corpus->len && j < i + batch_size; j++)
+        {
+          Entry *entry = &g_array_index (corpus, Entry, j);
+          po_message_t message;
+
+          message = po_message_create ();
+          po_message_set_msgid (message, entry->original);
+          po_message_set_msgstr (message, entry->translation);
+          po_message_insert (iter, message);
+
+          batch = g_list_prepend (batch, _gtr_msg_new (NULL, message));
+        }
+
+      batch = g_list_reverse (batch);
+      if (!gtr_translation_memory_store_list (tm, batch))
+        g_printerr ("Storing a batch failed\n");
+
+      g_list_free_full (batch, g_object_unref);
+      po_message_iterator_free (iter);
+      po_file_free (file);
+    }
+
+  return (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC;
+}
+
+static gint
+compare_latencies (gconstpointer a,
+                   gconstpointer b)
+{
+  gint64 la = *(const gint64 *) a;
+  gint64 lb = *(const gint64 *) b;
+
+  return (la > lb) - (la < lb);
+}
+
+/* Nearest rank percentile of the sorted @latencies */
+static gint64
+percentile (GArray *latencies,
+            guint   p)
+{
+  guint rank;
+
+  if (latencies->len == 0)
+    return 0;
+
+  rank = (latencies->len * p + 99) / 100;
+
+  return g_array_index (latencies, gint64, MAX (rank, 1) - 1);
+}
+
+static gboolean
+has_translation (GList       *matches,
+                 const gchar *translation)
+{
+  GList *l;
+
+  for (l = matches; l != NULL; l = g_list_next (l))
+    {
+      GtrTranslationMemoryMatch *match = l->data;
+
+      if (g_strcmp0 (match->match, translation) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+free_match (gpointer data)
+{
+  GtrTranslationMemoryMatch *match = data;
+
+  g_free (match->match);
+  g_slice_free (GtrTranslationMemoryMatch, match);
+}
+
+/* Looks up @queries originals of @corpus, perturbed or not, and adds the
+ * latency percentiles and the recall to @builder */
+static void
+run_lookups (GtrTranslationMemory *tm,
+             GArray               *corpus,
+             GRand                *rand,
+             gboolean              perturbed,
+             JsonBuilder          *builder)
+{
+  GArray *latencies;
+  gint64 total = 0;
+  guint found = 0;
+  gint i;
+
+  latencies = g_array_sized_new (FALSE, FALSE, sizeof (gint64), queries);
+
+  for (i = 0; i < queries; i++)
+    {
+      Entry *entry;
+      gchar *query;
+      GList *matches;
+      gint64 start, latency;
+
+      entry = &g_array_index (corpus, Entry,
+                              g_rand_int_range (rand, 0, corpus->len));
+      query = perturbed ? perturb (rand, entry->original)
+                        : g_strdup (entry->original);
+
+      start = g_get_monotonic_time ();
+      matches = gtr_translation_memory_lookup (tm, query);
+      latency = g_get_monotonic_time () - start;
+
+      g_array_append_val (latencies, latency);
+      total += latency;
+
+      if (has_translation (matches, entry->translation))
+        found++;
+
+      g_list_free_full (matches, free_match);
+      g_free (query);
+    }
+
+  g_array_sort (latencies, compare_latencies);
+
+  json_builder_begin_object (builder);
+  json_builder_set_member_name (builder, "queries");
+  json_builder_add_int_value (builder, queries);
+  json_builder_set_member_name (builder, "mean_us");
+  json_builder_add_double_value (builder, queries > 0 ? total / (gdouble) queries : 0);
+  json_builder_set_member_name (builder, "p50_us");
+  json_builder_add_int_value (builder, percentile (latencies, 50));
+  json_builder_set_member_name (builder, "p95_us");
+  json_builder_add_int_value (builder, percentile (latencies, 95));
+  json_builder_set_member_name (builder, "p99_us");
+  json_builder_add_int_value (builder, percentile (latencies, 99));
+  json_builder_set_member_name (builder, "recall");
+  json_builder_add_double_value (builder, queries > 0 ? found / (gdouble) queries : 0);
+  json_builder_end_object (builder);
+
+  g_array_free (latencies, TRUE);
+}
+
+static void
+remove_dir (const gchar *path)
+{
+  GDir *dir;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          gchar *child = g_build_filename (path, name, NULL);
+
+          if (g_file_test (child, G_FILE_TEST_IS_DIR))
+            remove_dir (child);
+          else
+            g_unlink (child);
+
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_rmdir (path);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GtrTranslationMemory *tm;
+  GRand *rand;
+  GArray *corpus;
+  JsonBuilder *builder;
+  JsonGenerator *generator;
+  JsonNode *root;
+  gchar *tmp_dir;
+  gchar *config_dir;
+  gchar *json;
+  gdouble seconds;
+  guint i;
+
+  context = g_option_context_new ("- benchmark the translation memory");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return EXIT_FAILURE;
+    }
+  g_option_context_free (context);
+
+  if (size < 1 || vocabulary < 1 || queries < 0 || batch_size < 1 ||
+      duplicates < 0 || duplicates >= 1)
+    {
+      g_printerr ("Invalid corpus parameters\n");
+      return EXIT_FAILURE;
+    }
+
+  if (backend == NULL)
+    backend = g_strdup ("gda");
+
+  /* The database goes to $XDG_CONFIG_HOME/gtranslator, it must be set
+   * before anything asks GLib for the user directories */
+  tmp_dir = g_dir_make_tmp ("gtr-tm-benchmark-XXXXXX", &error);
+  if (tmp_dir == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return EXIT_FAILURE;
+    }
+  g_setenv ("XDG_CONFIG_HOME", tmp_dir, TRUE);
+
+  gtr_dirs_init ();
+  config_dir = g_build_filename (tmp_dir, "gtranslator", NULL);
+  g_mkdir_with_parents (config_dir, 0700);
+  g_free (config_dir);
+
+  if (g_strcmp0 (backend, "gda") == 0)
+    tm = GTR_TRANSLATION_MEMORY (gtr_gda_new (NULL));
+  else if (g_strcmp0 (backend, "sqlite") == 0 ||
+           g_strcmp0 (backend, "sqlite-fts5") == 0)
+    tm = GTR_TRANSLATION_MEMORY (gtr_sqlite_new (g_strcmp0 (backend, "sqlite-fts5") == 0,
+                                                 NULL));
+  else
+    {
+      g_printerr ("Unknown backend %s\n", backend);
+      return EXIT_FAILURE;
+    }
+
+  /* Same settings as the editor windows */
+  gtr_translation_memory_set_max_omits (tm, 2);
+  gtr_translation_memory_set_max_delta (tm, 2);
+  gtr_translation_memory_set_max_items (tm, 10);
+
+  rand = g_rand_new_with_seed (seed);
+  corpus = generate_corpus (rand);
+
+  /* Stores wait for the database to be opened, the lookups come after */
+  seconds = store_corpus (tm, corpus);
+
+  builder = json_builder_new ();
+  json_builder_begin_object (builder);
+
+  json_builder_set_member_name (builder, "backend");
+  json_builder_add_string_value (builder, backend);
+
+  json_builder_set_member_name (builder, "corpus");
+  json_builder_begin_object (builder);
+  json_builder_set_member_name (builder, "size");
+  json_builder_add_int_value (builder, size);
+  json_builder_set_member_name (builder, "duplicates");
+  json_builder_add_double_value (builder, duplicates);
+  json_builder_set_member_name (builder, "vocabulary");
+  json_builder_add_int_value (builder, vocabulary);
+  json_builder_set_member_name (builder, "seed");
+  json_builder_add_int_value (builder, seed);
+  json_builder_end_object (builder);
+
+  json_builder_set_member_name (builder, "store_list");
+  json_builder_begin_object (builder);
+  json_builder_set_member_name (builder, "batch_size");
+  json_builder_add_int_value (builder, batch_size);
+  json_builder_set_member_name (builder, "seconds");
+  json_builder_add_double_value (builder, seconds);
+  json_builder_set_member_name (builder, "messages_per_second");
+  json_builder_add_double_value (builder, seconds > 0 ? size / seconds : 0);
+  json_builder_end_object (builder);
+
+  json_builder_set_member_name (builder, "lookup_exact");
+  run_lookups (tm, corpus, rand, FALSE, builder);
+
+  json_builder_set_member_name (builder, "lookup_perturbed");
+  run_lookups (tm, corpus, rand, TRUE, builder);
+
+  json_builder_end_object (builder);
+
+  root = json_builder_get_root (builder);
+  generator = json_generator_new ();
+  json_generator_set_root (generator, root);
+  json_generator_set_pretty (generator, TRUE);
+  json = json_generator_to_data (generator, NULL);
+  g_print ("%s\n", json);
+
+  g_free (json);
+  g_object_unref (generator);
+  json_node_unref (root);
+  g_object_unref (builder);
+
+  g_object_unref (tm);
+
+  for (i = 0; i < corpus->len; i++)
+    {
+      Entry *entry = &g_array_index (corpus, Entry, i);
+
+      g_free (entry->original);
+      g_free (entry->translation);
+    }
+  g_array_free (corpus, TRUE);
+  g_rand_free (rand);
+
+  remove_dir (tmp_dir);
+  g_free (tmp_dir);
+  g_free (backend);
+  gtr_dirs_shutdown ();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,678 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A translation memory that forwards everything to another one and keeps
+ * the results of the last lookups. The same messages are looked up again
+ * and again while navigating a file, and every lookup is a database query.
+ * Any store or remove may change the results, so the whole cache is dropped
+ * when the memory changes. Nothing is cached before the memory is open,
+ * as the lookups of the UI find nothing until then.
+ *
+ * A fallback memory can be set, whose matches are merged with the ones of
+ * the memory, for the translations stored before the memory was split by
+ * language. It caches its own lookups, so only the results of the memory
+ * itself are kept here. The ids of the fallback matches are negated, so
+ * removing one of them removes it from the fallback.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-translation-memory-cache.h"
+#include "gtr-debug.h"
+
+#include <string.h>
+
+typedef struct
+{
+  gchar *key;
+  GList *matches;
+} CacheEntry;
+
+typedef struct
+{
+  GtrTranslationMemory *tm;
+  GtrTranslationMemory *fallback;
+
+  GMutex lock;
+
+  /* Most recently used entries first */
+  GQueue lru;
+  /* key -> link in lru */
+  GHashTable *entries;
+  guint capacity;
+
+  /* Bumped on every invalidation, so that the results of a lookup that
+   * raced with a store are not cached */
+  guint generation;
+
+  gsize max_omits;
+  gsize max_delta;
+  gint max_items;
+
+  guint64 hits;
+  guint64 misses;
+} GtrTranslationMemoryCachePrivate;
+
+static void
+gtr_translation_memory_iface_init (GtrTranslationMemoryInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GtrTranslationMemoryCache,
+                         gtr_translation_memory_cache,
+                         G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (GtrTranslationMemoryCache)
+                         G_IMPLEMENT_INTERFACE (GTR_TYPE_TRANSLATION_MEMORY,
+                                                gtr_translation_memory_iface_init))
+
+static void
+free_match (gpointer data)
+{
+  GtrTranslationMemoryMatch *match = (GtrTranslationMemoryMatch *) data;
+
+  g_free (match->match);
+  g_slice_free (GtrTranslationMemoryMatch, match);
+}
+
+static gpointer
+copy_match (gconstpointer src,
+            gpointer      data)
+{
+  const GtrTranslationMemoryMatch *match = src;
+  GtrTranslationMemoryMatch *copy;
+
+  copy = g_slice_new (GtrTranslationMemoryMatch);
+  copy->match = g_strdup (match->match);
+  copy->level = match->level;
+  copy->id = match->id;
+
+  return copy;
+}
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+  g_free (entry->key);
+  g_list_free_full (entry->matches, free_match);
+  g_slice_free (CacheEntry, entry);
+}
+
+/* Must be called with the lock held */
+static void
+invalidate_locked (GtrTranslationMemoryCache *cache)
+{
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  priv->generation++;
+  g_hash_table_remove_all (priv->entries);
+  g_queue_foreach (&priv->lru, (GFunc) cache_entry_free, NULL);
+  g_queue_clear (&priv->lru);
+}
+
+static void
+invalidate (GtrTranslationMemoryCache *cache)
+{
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  g_mutex_lock (&priv->lock);
+  invalidate_locked (cache);
+  g_mutex_unlock (&priv->lock);
+}
+
+/* The key also holds the search parameters, they change the results */
+static gchar *
+build_key (GtrTranslationMemoryCache *cache,
+           const gchar               *phrase)
+{
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  return g_strdup_printf ("%" G_GSIZE_FORMAT ":%" G_GSIZE_FORMAT ":%d:%s",
+                          priv->max_omits, priv->max_delta,
+                          priv->max_items, phrase);
+}
+
+static gboolean
+gtr_translation_memory_cache_store (GtrTranslationMemory *tm,
+                                    GtrMsg               *msg)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+  gboolean result;
+
+  result = gtr_translation_memory_store (priv->tm, msg);
+  invalidate (cache);
+
+  return result;
+}
+
+static gboolean
+gtr_translation_memory_cache_store_list (GtrTranslationMemory *tm,
+                                         GList                *msgs)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+  gboolean result;
+
+  result = gtr_translation_memory_store_list (priv->tm, msgs);
+  invalidate (cache);
+
+  return result;
+}
+
+static void
+gtr_translation_memory_cache_remove (GtrTranslationMemory *tm,
+                                     gint                  translation_id)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  if (translation_id < 0 && priv->fallback != NULL)
+    {
+      gtr_translation_memory_remove (priv->fallback, -translation_id);
+      return;
+    }
+
+  gtr_translation_memory_remove (priv->tm, translation_id);
+  invalidate (cache);
+}
+
+static gint
+compare_level (gconstpointer a,
+               gconstpointer b)
+{
+  const GtrTranslationMemoryMatch *match_a = a;
+  const GtrTranslationMemoryMatch *match_b = b;
+
+  return match_b->level - match_a->level;
+}
+
+/* Adds the fallback @extra to @matches, skipping the translations already
+ * there, and keeps the best ones */
+static GList *
+merge_matches (GtrTranslationMemoryCache *cache,
+               GList                     *matches,
+               GList                     *extra)
+{
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+  GList *l;
+  gint max_items;
+
+  for (l = extra; l != NULL; l = g_list_next (l))
+    {
+      GtrTranslationMemoryMatch *match = l->data;
+      GList *m;
+
+      for (m = matches; m != NULL; m = g_list_next (m))
+        if (g_strcmp0 (((GtrTranslationMemoryMatch *) m->data)->match,
+                       match->match) == 0)
+          break;
+
+      if (m != NULL)
+        {
+          free_match (match);
+          continue;
+        }
+
+      match->id = -match->id;
+      matches = g_list_append (matches, match);
+    }
+  g_list_free (extra);
+
+  /* g_list_sort() is stable, the matches of the memory stay first */
+  matches = g_list_sort (matches, compare_level);
+
+  g_mutex_lock (&priv->lock);
+  max_items = priv->max_items;
+  g_mutex_unlock (&priv->lock);
+
+  if (max_items > 0 && g_list_length (matches) > (guint) max_items)
+    {
+      l = g_list_nth (matches, max_items);
+      l->prev->next = NULL;
+      l->prev = NULL;
+      g_list_free_full (l, free_match);
+    }
+
+  return matches;
+}
+
+static GList *
+lookup_cached (GtrTranslationMemoryCache *cache,
+               const gchar               *phrase)
+{
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+  GList *link;
+  GList *matches;
+  CacheEntry *entry;
+  gchar *normalized;
+  gchar *key;
+  guint generation;
+  gboolean is_open;
+
+  /* Canonically equivalent phrases share the entry */
+  normalized = g_utf8_normalize (phrase, -1, G_NORMALIZE_DEFAULT_COMPOSE);
+  if (normalized == NULL)
+    return gtr_translation_memory_lookup (priv->tm, phrase);
+
+  g_mutex_lock (&priv->lock);
+
+  key = build_key (cache, normalized);
+  link = g_hash_table_lookup (priv->entries, key);
+  if (link != NULL)
+    {
+      entry = link->data;
+
+      g_queue_unlink (&priv->lru, link);
+      g_queue_push_head_link (&priv->lru, link);
+
+      matches = g_list_copy_deep (entry->matches, copy_match, NULL);
+      priv->hits++;
+
+      g_mutex_unlock (&priv->lock);
+
+      g_free (key);
+      g_free (normalized);
+
+      return matches;
+    }
+
+  priv->misses++;
+  generation = priv->generation;
+
+  g_mutex_unlock (&priv->lock);
+
+  /* Checked first, the lookup may have run just before the open ended */
+  is_open = gtr_translation_memory_is_open (priv->tm);
+
+  /* The originals are stored as they came, so the backend gets the
+   * phrase itself for its exact matches to keep working */
+  matches = gtr_translation_memory_lookup (priv->tm, phrase);
+
+  g_mutex_lock (&priv->lock);
+
+  if (is_open && generation == priv->generation && priv->capacity > 0 &&
+      !g_hash_table_contains (priv->entries, key))
+    {
+      entry = g_slice_new (CacheEntry);
+      entry->key = key;
+      entry->matches = g_list_copy_deep (matches, copy_match, NULL);
+      key = NULL;
+
+      g_queue_push_head (&priv->lru, entry);
+      g_hash_table_insert (priv->entries, entry->key, priv->lru.head);
+
+      if (priv->lru.length > priv->capacity)
+        {
+          entry = g_queue_pop_tail (&priv->lru);
+          g_hash_table_remove (priv->entries, entry->key);
+          cache_entry_free (entry);
+        }
+    }
+
+  g_mutex_unlock (&priv->lock);
+
+  g_free (key);
+  g_free (normalized);
+
+  return matches;
+}
+
+static GList *
+gtr_translation_memory_cache_lookup (GtrTranslationMemory *tm,
+                                     const gchar          *phrase)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+  GList *matches;
+
+  matches = lookup_cached (cache, phrase);
+
+  if (priv->fallback != NULL)
+    matches = merge_matches (cache, matches,
+                             gtr_translation_memory_lookup (priv->fallback, phrase));
+
+  return matches;
+}
+
+static void
+gtr_translation_memory_cache_set_max_omits (GtrTranslationMemory *tm,
+                                            gsize                 omits)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  gtr_translation_memory_set_max_omits (priv->tm, omits);
+
+  g_mutex_lock (&priv->lock);
+  priv->max_omits = omits;
+  g_mutex_unlock (&priv->lock);
+}
+
+static void
+gtr_translation_memory_cache_set_max_delta (GtrTranslationMemory *tm,
+                                            gsize                 delta)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  gtr_translation_memory_set_max_delta (priv->tm, delta);
+
+  g_mutex_lock (&priv->lock);
+  priv->max_delta = delta;
+  g_mutex_unlock (&priv->lock);
+}
+
+static void
+gtr_translation_memory_cache_set_max_items (GtrTranslationMemory *tm,
+                                            gint                  items)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  gtr_translation_memory_set_max_items (priv->tm, items);
+
+  g_mutex_lock (&priv->lock);
+  priv->max_items = items;
+  g_mutex_unlock (&priv->lock);
+}
+
+static gboolean
+gtr_translation_memory_cache_get_file_stamp (GtrTranslationMemory  *tm,
+                                             const gchar           *path,
+                                             goffset               *size,
+                                             gint64                *mtime,
+                                             gchar                **hash)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  return gtr_translation_memory_get_file_stamp (priv->tm, path, size, mtime, hash);
+}
+
+static gboolean
+gtr_translation_memory_cache_set_file_stamp (GtrTranslationMemory *tm,
+                                             const gchar          *path,
+                                             goffset               size,
+                                             gint64                mtime,
+                                             const gchar          *hash)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  return gtr_translation_memory_set_file_stamp (priv->tm, path, size, mtime, hash);
+}
+
+static gboolean
+gtr_translation_memory_cache_store_file (GtrTranslationMemory *tm,
+                                         const gchar          *path,
+                                         goffset               size,
+                                         gint64                mtime,
+                                         const gchar          *hash,
+                                         GList                *msgs)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+  gboolean result;
+
+  result = gtr_translation_memory_store_file (priv->tm, path, size, mtime,
+                                              hash, msgs);
+  invalidate (cache);
+
+  return result;
+}
+
+static void
+gtr_translation_memory_cache_foreach (GtrTranslationMemory            *tm,
+                                      GtrTranslationMemoryForeachFunc  func,
+                                      gpointer                         user_data)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  gtr_translation_memory_foreach (priv->tm, func, user_data);
+}
+
+static gboolean
+gtr_translation_memory_cache_maintain (GtrTranslationMemory  *tm,
+                                       GCancellable          *cancellable,
+                                       gint64                *reclaimed,
+                                       GError               **error)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+  gboolean result;
+
+  /* Merged duplicates change the ids of the cached matches */
+  result = gtr_translation_memory_maintain (priv->tm, cancellable,
+                                            reclaimed, error);
+  invalidate (cache);
+
+  return result;
+}
+
+static gboolean
+gtr_translation_memory_cache_is_open (GtrTranslationMemory *tm)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (tm);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  return gtr_translation_memory_is_open (priv->tm) &&
+         (priv->fallback == NULL || gtr_translation_memory_is_open (priv->fallback));
+}
+
+static void
+gtr_translation_memory_iface_init (GtrTranslationMemoryInterface *iface)
+{
+  iface->store = gtr_translation_memory_cache_store;
+  iface->store_list = gtr_translation_memory_cache_store_list;
+  iface->remove = gtr_translation_memory_cache_remove;
+  iface->lookup = gtr_translation_memory_cache_lookup;
+  iface->set_max_omits = gtr_translation_memory_cache_set_max_omits;
+  iface->set_max_delta = gtr_translation_memory_cache_set_max_delta;
+  iface->set_max_items = gtr_translation_memory_cache_set_max_items;
+  iface->get_file_stamp = gtr_translation_memory_cache_get_file_stamp;
+  iface->set_file_stamp = gtr_translation_memory_cache_set_file_stamp;
+  iface->store_file = gtr_translation_memory_cache_store_file;
+  iface->foreach = gtr_translation_memory_cache_foreach;
+  iface->maintain = gtr_translation_memory_cache_maintain;
+  iface->is_open = gtr_translation_memory_cache_is_open;
+}
+
+static void
+gtr_translation_memory_cache_init (GtrTranslationMemoryCache *cache)
+{
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  g_mutex_init (&priv->lock);
+  g_queue_init (&priv->lru);
+  priv->entries = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+static void
+gtr_translation_memory_cache_dispose (GObject *object)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (object);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  if (priv->hits + priv->misses > 0)
+    DEBUG_PRINT ("Translation memory cache: %" G_GUINT64_FORMAT " hits, "
+                 "%" G_GUINT64_FORMAT " misses (%.1f%% hit rate)",
+                 priv->hits, priv->misses,
+                 100.0 * priv->hits / (priv->hits + priv->misses));
+
+  invalidate (cache);
+  g_clear_object (&priv->tm);
+  g_clear_object (&priv->fallback);
+
+  G_OBJECT_CLASS (gtr_translation_memory_cache_parent_class)->dispose (object);
+}
+
+static void
+gtr_translation_memory_cache_finalize (GObject *object)
+{
+  GtrTranslationMemoryCache *cache = GTR_TRANSLATION_MEMORY_CACHE (object);
+  GtrTranslationMemoryCachePrivate *priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  g_hash_table_unref (priv->entries);
+  g_mutex_clear (&priv->lock);
+
+  G_OBJECT_CLASS (gtr_translation_memory_cache_parent_class)->finalize (object);
+}
+
+static void
+gtr_translation_memory_cache_class_init (GtrTranslationMemoryCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gtr_translation_memory_cache_dispose;
+  object_class->finalize = gtr_translation_memory_cache_finalize;
+}
+
+/**
+ * gtr_translation_memory_cache_new:
+ * @tm: the #GtrTranslationMemory to forward to
+ * @capacity: maximum number of lookups to remember
+ *
+ * Creates a translation memory that remembers the results of the last
+ * @capacity lookups done on @tm. The search parameters set on the cache
+ * are forwarded to @tm.
+ *
+ * Returns: a new #GtrTranslationMemoryCache object
+ */
+GtrTranslationMemoryCache *
+gtr_translation_memory_cache_new (GtrTranslationMemory *tm,
+                                  guint                 capacity)
+{
+  GtrTranslationMemoryCache *cache;
+  GtrTranslationMemoryCachePrivate *priv;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY (tm), NULL);
+
+  cache = g_object_new (GTR_TYPE_TRANSLATION_MEMORY_CACHE, NULL);
+  priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  priv->tm = g_object_ref (tm);
+  priv->capacity = capacity;
+
+  return cache;
+}
+
+/**
+ * gtr_translation_memory_cache_get_memory:
+ * @cache: a #GtrTranslationMemoryCache
+ *
+ * Returns: (transfer none): the translation memory behind @cache
+ */
+GtrTranslationMemory *
+gtr_translation_memory_cache_get_memory (GtrTranslationMemoryCache *cache)
+{
+  GtrTranslationMemoryCachePrivate *priv;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_CACHE (cache), NULL);
+
+  priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  return priv->tm;
+}
+
+/**
+ * gtr_translation_memory_cache_set_fallback:
+ * @cache: a #GtrTranslationMemoryCache
+ * @fallback: (nullable): a #GtrTranslationMemory
+ *
+ * Sets a translation memory whose matches are added to the ones of the
+ * memory behind @cache. It must be set before @cache is shared between
+ * threads.
+ */
+void
+gtr_translation_memory_cache_set_fallback (GtrTranslationMemoryCache *cache,
+                                           GtrTranslationMemory      *fallback)
+{
+  GtrTranslationMemoryCachePrivate *priv;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY_CACHE (cache));
+  g_return_if_fail (fallback == NULL || GTR_IS_TRANSLATION_MEMORY (fallback));
+
+  priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  if (fallback != NULL)
+    g_object_ref (fallback);
+  g_clear_object (&priv->fallback);
+  priv->fallback = fallback;
+}
+
+/**
+ * gtr_translation_memory_cache_clear:
+ * @cache: a #GtrTranslationMemoryCache
+ *
+ * Forgets every remembered lookup, for when the translation memory behind
+ * @cache was changed directly.
+ */
+void
+gtr_translation_memory_cache_clear (GtrTranslationMemoryCache *cache)
+{
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY_CACHE (cache));
+
+  invalidate (cache);
+}
+
+/**
+ * gtr_translation_memory_cache_get_hits:
+ * @cache: a #GtrTranslationMemoryCache
+ *
+ * Returns: the number of lookups answered from the cache
+ */
+guint64
+gtr_translation_memory_cache_get_hits (GtrTranslationMemoryCache *cache)
+{
+  GtrTranslationMemoryCachePrivate *priv;
+  guint64 hits;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_CACHE (cache), 0);
+
+  priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  g_mutex_lock (&priv->lock);
+  hits = priv->hits;
+  g_mutex_unlock (&priv->lock);
+
+  return hits;
+}
+
+/**
+ * gtr_translation_memory_cache_get_misses:
+ * @cache: a #GtrTranslationMemoryCache
+ *
+ * Returns: the number of lookups forwarded to the translation memory
+ */
+guint64
+gtr_translation_memory_cache_get_misses (GtrTranslationMemoryCache *cache)
+{
+  GtrTranslationMemoryCachePrivate *priv;
+  guint64 misses;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_CACHE (cache), 0);
+
+  priv = gtr_translation_memory_cache_get_instance_private (cache);
+
+  g_mutex_lock (&priv->lock);
+  misses = priv->misses;
+  g_mutex_unlock (&priv->lock);
+
+  return misses;
+}
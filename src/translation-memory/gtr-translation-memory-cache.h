@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTR_TRANSLATION_MEMORY_CACHE_H__
+#define __GTR_TRANSLATION_MEMORY_CACHE_H__
+
+#include <glib-object.h>
+
+#include "gtr-translation-memory.h"
+
+G_BEGIN_DECLS
+
+#define GTR_TYPE_TRANSLATION_MEMORY_CACHE            (gtr_translation_memory_cache_get_type ())
+#define GTR_TRANSLATION_MEMORY_CACHE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTR_TYPE_TRANSLATION_MEMORY_CACHE, GtrTranslationMemoryCache))
+#define GTR_TRANSLATION_MEMORY_CACHE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GTR_TYPE_TRANSLATION_MEMORY_CACHE, GtrTranslationMemoryCacheClass))
+#define GTR_IS_TRANSLATION_MEMORY_CACHE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTR_TYPE_TRANSLATION_MEMORY_CACHE))
+#define GTR_IS_TRANSLATION_MEMORY_CACHE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GTR_TYPE_TRANSLATION_MEMORY_CACHE))
+#define GTR_TRANSLATION_MEMORY_CACHE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GTR_TYPE_TRANSLATION_MEMORY_CACHE, GtrTranslationMemoryCacheClass))
+
+typedef struct _GtrTranslationMemoryCache        GtrTranslationMemoryCache;
+typedef struct _GtrTranslationMemoryCacheClass   GtrTranslationMemoryCacheClass;
+
+struct _GtrTranslationMemoryCache
+{
+  GObject parent_instance;
+};
+
+struct _GtrTranslationMemoryCacheClass
+{
+  GObjectClass parent_class;
+};
+
+GType                       gtr_translation_memory_cache_get_type   (void) G_GNUC_CONST;
+
+GtrTranslationMemoryCache  *gtr_translation_memory_cache_new        (GtrTranslationMemory      *tm,
+                                                                     guint                      capacity);
+
+GtrTranslationMemory       *gtr_translation_memory_cache_get_memory (GtrTranslationMemoryCache *cache);
+
+void                        gtr_translation_memory_cache_set_fallback (GtrTranslationMemoryCache *cache,
+                                                                       GtrTranslationMemory      *fallback);
+
+void                        gtr_translation_memory_cache_clear      (GtrTranslationMemoryCache *cache);
+
+guint64                     gtr_translation_memory_cache_get_hits   (GtrTranslationMemoryCache *cache);
+
+guint64                     gtr_translation_memory_cache_get_misses (GtrTranslationMemoryCache *cache);
+
+G_END_DECLS
+
+#endif /* __GTR_TRANSLATION_MEMORY_CACHE_H__ */
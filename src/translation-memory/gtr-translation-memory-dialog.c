@@ -17,6 +17,9 @@
 
 #include "gtr-translation-memory-dialog.h"
 #include "gtr-profile-manager.h"
+#include "gtr-translation-memory-importer.h"
+#include "gtr-translation-memory-maintenance.h"
+#include "gtr-translation-memory-tmx.h"
 #include "gtr-translation-memory-utils.h"
 #include "gtr-po.h"
 
@@ -31,10 +34,21 @@ typedef struct
   GtkWidget *search_button;
   GtkWidget *add_database_button;
   GtkWidget *add_database_progressbar;
+  GtkWidget *import_tmx_button;
+  GtkWidget *export_tmx_button;
+  GtkWidget *clean_database_button;
   GtkWidget *tm_lang_entry;
   GtkWidget *use_lang_profile_in_tm;
 
   GtrTranslationMemory *translation_memory;
+
+  /* Language of the active profile, used for the TMX files */
+  gchar *language_code;
+
+  GtrTranslationMemoryImporter *importer;
+  GCancellable *cancellable;
+  GString *import_errors;
+  guint n_import_errors;
 } GtrTranslationMemoryDialogPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtrTranslationMemoryDialog, gtr_translation_memory_dialog, GTK_TYPE_DIALOG)
@@ -42,6 +56,12 @@ G_DEFINE_TYPE_WITH_PRIVATE (GtrTranslationMemoryDialog, gtr_translation_memory_d
 static void
 gtr_translation_memory_dialog_finalize (GObject *object)
 {
+  GtrTranslationMemoryDialog *dlg = GTR_TRANSLATION_MEMORY_DIALOG (object);
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+
+  g_string_free (priv->import_errors, TRUE);
+  g_free (priv->language_code);
+
   G_OBJECT_CLASS (gtr_translation_memory_dialog_parent_class)->finalize (object);
 }
 
@@ -53,6 +73,16 @@ gtr_translation_memory_dialog_dispose (GObject *object)
 
   g_clear_object (&priv->tm_settings);
 
+  if (priv->cancellable != NULL)
+    g_cancellable_cancel (priv->cancellable);
+  g_clear_object (&priv->cancellable);
+
+  if (priv->importer != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (priv->importer, dlg);
+      g_clear_object (&priv->importer);
+    }
+
   G_OBJECT_CLASS (gtr_translation_memory_dialog_parent_class)->dispose (object);
 }
 
@@ -98,84 +128,156 @@ on_search_button_clicked (GtkButton                  *button,
   g_object_unref (native);
 }
 
-typedef struct _IdleData
-{
-  GSList *list;
-  GtkProgressBar *progress;
-  GtrTranslationMemory *tm;
-  GtkWindow *parent;
-  GtkWidget *add_database_button;
-} IdleData;
-
-static gboolean
-add_to_database (gpointer data_pointer)
+/* While an import, export or clean up runs only its button is sensitive, to stop it */
+static void
+set_busy (GtrTranslationMemoryDialog *dlg,
+          GtkWidget                  *stop_button)
 {
-  IdleData *data = (IdleData *) data_pointer;
-  static GSList *l = NULL;
-  gdouble percentage;
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
 
-  if (l == NULL)
-    l = data->list;
-  else
-    l = g_slist_next (l);
+  gtk_widget_set_sensitive (priv->add_database_button,
+                            stop_button == NULL || stop_button == priv->add_database_button);
+  gtk_widget_set_sensitive (priv->import_tmx_button,
+                            stop_button == NULL || stop_button == priv->import_tmx_button);
+  gtk_widget_set_sensitive (priv->export_tmx_button,
+                            stop_button == NULL || stop_button == priv->export_tmx_button);
+  gtk_widget_set_sensitive (priv->clean_database_button,
+                            stop_button == NULL || stop_button == priv->clean_database_button);
 
-  if (l)
+  if (stop_button != NULL)
     {
-      GList *msg_list = NULL;
-      GFile *location;
-      GError *error = NULL;
-      GtrPo *po;
+      gtk_progress_bar_set_text (GTK_PROGRESS_BAR (priv->add_database_progressbar), NULL);
+      gtk_progress_bar_pulse (GTK_PROGRESS_BAR (priv->add_database_progressbar));
+      gtk_widget_show (priv->add_database_progressbar);
 
-      po = gtr_po_new ();
-      location = (GFile *) l->data;
+      gtk_button_set_label (GTK_BUTTON (stop_button), _("Stop"));
+      return;
+    }
 
-      gtr_po_parse (po, location, &error);
-      if (error)
-        return TRUE;
+  gtk_widget_hide (priv->add_database_progressbar);
+  gtk_button_set_label (GTK_BUTTON (priv->add_database_button),
+                        _("Add to Database"));
+  gtk_button_set_label (GTK_BUTTON (priv->import_tmx_button),
+                        _("Import TMX…"));
+  gtk_button_set_label (GTK_BUTTON (priv->export_tmx_button),
+                        _("Export TMX…"));
+  gtk_button_set_label (GTK_BUTTON (priv->clean_database_button),
+                        _("Clean Up Database"));
+}
 
-      msg_list = gtr_po_get_messages (po);
+static void
+import_finish (GtrTranslationMemoryDialog *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
 
-      gtr_translation_memory_store_list (data->tm, msg_list);
+  g_clear_object (&priv->cancellable);
 
-      g_object_unref (po);
-    }
-  else
+  if (priv->importer != NULL)
     {
-      gtk_widget_set_sensitive (data->add_database_button, TRUE);
-      return FALSE;
+      g_signal_handlers_disconnect_by_data (priv->importer, dlg);
+      g_clear_object (&priv->importer);
     }
 
-  percentage =
-    (gdouble) g_slist_position (data->list,
-                                l) / (gdouble) g_slist_length (data->list);
+  set_busy (dlg, NULL);
+}
 
-  /*
-   * Set the progress only if the values are reasonable.
-   */
-  if (percentage > 0.0 && percentage < 1.0)
+static void
+show_import_errors (GtrTranslationMemoryDialog *dlg,
+                    guint                       n_failed)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GtkWidget *dialog;
+
+  dialog = gtk_message_dialog_new (GTK_WINDOW (dlg),
+                                   GTK_DIALOG_DESTROY_WITH_PARENT,
+                                   GTK_MESSAGE_WARNING,
+                                   GTK_BUTTONS_CLOSE,
+                                   ngettext ("%u file could not be added to the translation memory",
+                                             "%u files could not be added to the translation memory",
+                                             n_failed),
+                                   n_failed);
+  gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+                                            "%s", priv->import_errors->str);
+  g_signal_connect (dialog, "response",
+                    G_CALLBACK (gtk_widget_destroy), NULL);
+  gtk_widget_show (dialog);
+}
+
+static void
+import_progress_cb (GtrTranslationMemoryImporter *importer,
+                    guint                         done,
+                    guint                         total,
+                    GtrTranslationMemoryDialog   *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GtkProgressBar *progress = GTK_PROGRESS_BAR (priv->add_database_progressbar);
+  gchar *text;
+
+  if (total == 0)
     {
-      /* Set the progressbar status. */
-      gtk_progress_bar_set_fraction (data->progress, percentage);
+      gtk_progress_bar_pulse (progress);
+      return;
     }
 
-  return TRUE;
+  text = g_strdup_printf (_("%u of %u files"), done, total);
+  gtk_progress_bar_set_text (progress, text);
+  gtk_progress_bar_set_fraction (progress, (gdouble) done / (gdouble) total);
+  g_free (text);
 }
 
+#define MAX_REPORTED_ERRORS 10
+
 static void
-destroy_idle_data (gpointer data)
+import_file_failed_cb (GtrTranslationMemoryImporter *importer,
+                       GFile                        *location,
+                       const gchar                  *message,
+                       GtrTranslationMemoryDialog   *dlg)
 {
-  IdleData *d = (IdleData *) data;
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  gchar *path;
 
-  gtk_widget_hide (GTK_WIDGET (d->progress));
+  if (priv->n_import_errors++ >= MAX_REPORTED_ERRORS)
+    return;
 
-  g_slist_free_full (d->list, g_object_unref);
-  g_free (d);
+  path = g_file_get_parse_name (location);
+  g_string_append_printf (priv->import_errors, "%s: %s\n", path, message);
+  g_free (path);
+}
+
+static void
+import_ready_cb (GtrTranslationMemoryImporter *importer,
+                 GAsyncResult                 *result,
+                 GtrTranslationMemoryDialog   *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GError *error = NULL;
+  guint n_failed;
+
+  gtr_translation_memory_importer_run_finish (importer, result, &error);
+  n_failed = gtr_translation_memory_importer_get_n_failed (importer);
+
+  /* The dialog was closed while importing */
+  if (priv->importer != importer)
+    {
+      g_clear_error (&error);
+      g_object_unref (dlg);
+      return;
+    }
+
+  import_finish (dlg);
+
+  if (error == NULL && n_failed > 0)
+    show_import_errors (dlg, n_failed);
+
+  g_clear_error (&error);
+  g_object_unref (dlg);
 }
 
 typedef struct
 {
   GFile *dir;
   gchar *restriction;
+  GtrTranslationMemoryImporter *importer;
 } ScanDirTaskData;
 
 static void
@@ -184,31 +286,31 @@ task_data_destroy (ScanDirTaskData *data)
   if (data->restriction)
     g_free (data->restriction);
   g_object_unref (data->dir);
+  g_object_unref (data->importer);
 
   g_free (data);
 }
 
 static void
-scan_dir_task_func (GTask                      *task,
-                    GtrTranslationMemoryDialog *dlg,
-                    ScanDirTaskData            *data,
-                    GCancellable               *cancellable)
+add_scanned_file (GFile                        *file,
+                  GtrTranslationMemoryImporter *importer)
 {
-  GSList *list = NULL;
-  gtr_scan_dir (data->dir, &list, data->restriction);
-  g_task_return_pointer (task, list, (GDestroyNotify)g_slist_free);
+  gtr_translation_memory_importer_add_file (importer, file);
 }
 
 static void
-scan_dir_task_ready_cb (GtrTranslationMemoryDialog *dlg,
-                        GTask                      *task,
-                        IdleData                   *data)
+scan_dir_task_func (GTask                      *task,
+                    GtrTranslationMemoryDialog *dlg,
+                    ScanDirTaskData            *data,
+                    GCancellable               *cancellable)
 {
-  data->list = g_task_propagate_pointer (task, NULL);
+  /* The files are imported while the rest of the tree is scanned */
+  gtr_scan_dir_foreach (data->dir, data->restriction, cancellable,
+                        (GtrScanDirFunc) add_scanned_file,
+                        data->importer);
+  gtr_translation_memory_importer_close (data->importer);
 
-  g_idle_add_full (G_PRIORITY_HIGH_IDLE + 30,
-                   (GSourceFunc) add_to_database,
-                   data, (GDestroyNotify) destroy_idle_data);
+  g_task_return_boolean (task, TRUE);
 }
 
 static void
@@ -216,34 +318,32 @@ launch_gtr_scan_dir_task (GtrTranslationMemoryDialog *dlg,
                           ScanDirTaskData            *data)
 {
   GTask *task;
-  GCancellable *cancellable;
-  IdleData *idata;
   GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
 
-  cancellable = g_cancellable_new ();
-  // TODO: connect cancellable cancel signal
+  priv->cancellable = g_cancellable_new ();
+  priv->importer = gtr_translation_memory_importer_new (priv->translation_memory);
+  g_string_truncate (priv->import_errors, 0);
+  priv->n_import_errors = 0;
 
-  idata = g_new0 (IdleData, 1);
-  idata->list = NULL;
-  idata->tm = priv->translation_memory;
-  idata->progress = GTK_PROGRESS_BAR (priv->add_database_progressbar);
-  idata->parent = GTK_WINDOW (dlg);
-  idata->add_database_button = priv->add_database_button;
+  g_signal_connect (priv->importer, "progress",
+                    G_CALLBACK (import_progress_cb), dlg);
+  g_signal_connect (priv->importer, "file-failed",
+                    G_CALLBACK (import_file_failed_cb), dlg);
 
-  gtk_progress_bar_pulse (idata->progress);
-  gtk_widget_show (priv->add_database_progressbar);
+  data->importer = g_object_ref (priv->importer);
 
-  gtk_widget_set_sensitive (priv->add_database_button, FALSE);
+  set_busy (dlg, priv->add_database_button);
 
-  task = g_task_new (dlg,
-                     cancellable,
-                     (GAsyncReadyCallback)scan_dir_task_ready_cb,
-                     idata);
+  gtr_translation_memory_importer_run_async (priv->importer,
+                                             priv->cancellable,
+                                             (GAsyncReadyCallback) import_ready_cb,
+                                             g_object_ref (dlg));
 
+  task = g_task_new (dlg, priv->cancellable, NULL, NULL);
   g_task_set_task_data (task, data, (GDestroyNotify)task_data_destroy);
-
   g_task_run_in_thread (task,
                         (GTaskThreadFunc) scan_dir_task_func);
+  g_object_unref (task);
 }
 
 static void
@@ -254,6 +354,13 @@ on_add_database_button_clicked (GtkButton                  *button,
   GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
   ScanDirTaskData *scan_dir_data;
 
+  /* The button stops the import while it is running */
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      return;
+    }
+
   dir_name = g_settings_get_string (priv->tm_settings,
                                     "po-directory");
 
@@ -277,6 +384,292 @@ on_add_database_button_clicked (GtkButton                  *button,
   launch_gtr_scan_dir_task (dlg, scan_dir_data);
 }
 
+/***************TMX files****************/
+static void
+show_tmx_result (GtrTranslationMemoryDialog *dlg,
+                 GtkMessageType              type,
+                 const gchar                *primary,
+                 const gchar                *secondary)
+{
+  GtkWidget *dialog;
+
+  dialog = gtk_message_dialog_new (GTK_WINDOW (dlg),
+                                   GTK_DIALOG_DESTROY_WITH_PARENT,
+                                   type,
+                                   GTK_BUTTONS_CLOSE,
+                                   "%s", primary);
+  if (secondary != NULL)
+    gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+                                              "%s", secondary);
+  g_signal_connect (dialog, "response",
+                    G_CALLBACK (gtk_widget_destroy), NULL);
+  gtk_widget_show (dialog);
+}
+
+static GFile *
+choose_tmx_file (GtrTranslationMemoryDialog *dlg,
+                 GtkFileChooserAction        action)
+{
+  GtkFileChooserNative *native;
+  GtkFileFilter *filter;
+  GFile *file = NULL;
+
+  native = gtk_file_chooser_native_new (action == GTK_FILE_CHOOSER_ACTION_SAVE ?
+                                        _("Export Translation Memory") :
+                                        _("Import Translation Memory"),
+                                        GTK_WINDOW (dlg),
+                                        action,
+                                        action == GTK_FILE_CHOOSER_ACTION_SAVE ?
+                                        _("_Export") : _("_Import"),
+                                        _("_Cancel"));
+
+  filter = gtk_file_filter_new ();
+  gtk_file_filter_set_name (filter, _("TMX files"));
+  gtk_file_filter_add_pattern (filter, "*.tmx");
+  gtk_file_chooser_add_filter (GTK_FILE_CHOOSER (native), filter);
+
+  if (action == GTK_FILE_CHOOSER_ACTION_SAVE)
+    {
+      gtk_file_chooser_set_do_overwrite_confirmation (GTK_FILE_CHOOSER (native), TRUE);
+      gtk_file_chooser_set_current_name (GTK_FILE_CHOOSER (native),
+                                         "translation-memory.tmx");
+    }
+
+  if (gtk_native_dialog_run (GTK_NATIVE_DIALOG (native)) == GTK_RESPONSE_ACCEPT)
+    file = gtk_file_chooser_get_file (GTK_FILE_CHOOSER (native));
+
+  g_object_unref (native);
+
+  return file;
+}
+
+static void
+import_tmx_progress_cb (goffset  current,
+                        goffset  total,
+                        gpointer user_data)
+{
+  GtrTranslationMemoryDialog *dlg = GTR_TRANSLATION_MEMORY_DIALOG (user_data);
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GtkProgressBar *progress = GTK_PROGRESS_BAR (priv->add_database_progressbar);
+
+  if (total <= 0)
+    {
+      gtk_progress_bar_pulse (progress);
+      return;
+    }
+
+  gtk_progress_bar_set_fraction (progress, (gdouble) current / (gdouble) total);
+}
+
+static void
+export_tmx_progress_cb (goffset  current,
+                        goffset  total,
+                        gpointer user_data)
+{
+  GtrTranslationMemoryDialog *dlg = GTR_TRANSLATION_MEMORY_DIALOG (user_data);
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GtkProgressBar *progress = GTK_PROGRESS_BAR (priv->add_database_progressbar);
+  gchar *text;
+
+  text = g_strdup_printf (ngettext ("%u translation", "%u translations", (guint) current),
+                          (guint) current);
+  gtk_progress_bar_set_text (progress, text);
+  gtk_progress_bar_pulse (progress);
+  g_free (text);
+}
+
+static void
+tmx_finish (GtrTranslationMemoryDialog *dlg,
+            GError                     *error,
+            const gchar                *error_message,
+            const gchar                *done_message)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+
+  g_clear_object (&priv->cancellable);
+  set_busy (dlg, NULL);
+
+  if (error == NULL)
+    show_tmx_result (dlg, GTK_MESSAGE_INFO, done_message, NULL);
+  else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    show_tmx_result (dlg, GTK_MESSAGE_WARNING, error_message, error->message);
+}
+
+static void
+import_tmx_ready_cb (GtrTranslationMemory       *tm,
+                     GAsyncResult               *result,
+                     GtrTranslationMemoryDialog *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GError *error = NULL;
+  gchar *message;
+  guint n_units;
+
+  gtr_translation_memory_import_tmx_finish (tm, result, &n_units, &error);
+
+  /* The cancellable is dropped when the dialog is closed */
+  if (priv->cancellable != NULL)
+    {
+      message = g_strdup_printf (ngettext ("%u translation was added to the translation memory",
+                                           "%u translations were added to the translation memory",
+                                           n_units),
+                                 n_units);
+      tmx_finish (dlg, error,
+                  _("The TMX file could not be added to the translation memory"),
+                  message);
+      g_free (message);
+    }
+
+  g_clear_error (&error);
+  g_object_unref (dlg);
+}
+
+static void
+export_tmx_ready_cb (GtrTranslationMemory       *tm,
+                     GAsyncResult               *result,
+                     GtrTranslationMemoryDialog *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GError *error = NULL;
+  gchar *message;
+  guint n_units;
+
+  gtr_translation_memory_export_tmx_finish (tm, result, &n_units, &error);
+
+  /* The cancellable is dropped when the dialog is closed */
+  if (priv->cancellable != NULL)
+    {
+      message = g_strdup_printf (ngettext ("%u translation was exported",
+                                           "%u translations were exported",
+                                           n_units),
+                                 n_units);
+      tmx_finish (dlg, error,
+                  _("The translation memory could not be exported"),
+                  message);
+      g_free (message);
+    }
+
+  g_clear_error (&error);
+  g_object_unref (dlg);
+}
+
+static void
+on_import_tmx_button_clicked (GtkButton                  *button,
+                              GtrTranslationMemoryDialog *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GFile *file;
+
+  /* The button stops the import while it is running */
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      return;
+    }
+
+  file = choose_tmx_file (dlg, GTK_FILE_CHOOSER_ACTION_OPEN);
+  if (file == NULL)
+    return;
+
+  priv->cancellable = g_cancellable_new ();
+  set_busy (dlg, priv->import_tmx_button);
+
+  gtr_translation_memory_import_tmx_async (priv->translation_memory,
+                                           file,
+                                           priv->language_code,
+                                           priv->cancellable,
+                                           import_tmx_progress_cb,
+                                           dlg,
+                                           (GAsyncReadyCallback) import_tmx_ready_cb,
+                                           g_object_ref (dlg));
+  g_object_unref (file);
+}
+
+static void
+on_export_tmx_button_clicked (GtkButton                  *button,
+                              GtrTranslationMemoryDialog *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GFile *file;
+
+  /* The button stops the export while it is running */
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      return;
+    }
+
+  file = choose_tmx_file (dlg, GTK_FILE_CHOOSER_ACTION_SAVE);
+  if (file == NULL)
+    return;
+
+  priv->cancellable = g_cancellable_new ();
+  set_busy (dlg, priv->export_tmx_button);
+
+  gtr_translation_memory_export_tmx_async (priv->translation_memory,
+                                           file,
+                                           priv->language_code,
+                                           priv->cancellable,
+                                           export_tmx_progress_cb,
+                                           dlg,
+                                           (GAsyncReadyCallback) export_tmx_ready_cb,
+                                           g_object_ref (dlg));
+  g_object_unref (file);
+}
+
+static void
+maintain_ready_cb (GtrTranslationMemory       *tm,
+                   GAsyncResult               *result,
+                   GtrTranslationMemoryDialog *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+  GError *error = NULL;
+  gint64 reclaimed = 0;
+  gchar *size;
+  gchar *message;
+
+  gtr_translation_memory_maintain_finish (tm, result, &reclaimed, &error);
+
+  /* The cancellable is dropped when the dialog is closed */
+  if (priv->cancellable != NULL)
+    {
+      size = g_format_size (reclaimed);
+      /* Translators: %s is a size, like "12.5 MB" */
+      message = g_strdup_printf (_("The translation memory was cleaned up, %s reclaimed"),
+                                 size);
+      tmx_finish (dlg, error,
+                  _("The translation memory could not be cleaned up"),
+                  message);
+      g_free (message);
+      g_free (size);
+    }
+
+  g_clear_error (&error);
+  g_object_unref (dlg);
+}
+
+static void
+on_clean_database_button_clicked (GtkButton                  *button,
+                                  GtrTranslationMemoryDialog *dlg)
+{
+  GtrTranslationMemoryDialogPrivate *priv = gtr_translation_memory_dialog_get_instance_private (dlg);
+
+  /* The button stops the clean up while it is running */
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      return;
+    }
+
+  priv->cancellable = g_cancellable_new ();
+  set_busy (dlg, priv->clean_database_button);
+
+  gtr_translation_memory_maintain_async (priv->translation_memory,
+                                         priv->cancellable,
+                                         (GAsyncReadyCallback) maintain_ready_cb,
+                                         g_object_ref (dlg));
+}
+
 static void
 gtr_translation_memory_dialog_init (GtrTranslationMemoryDialog *dlg)
 {
@@ -294,6 +687,7 @@ gtr_translation_memory_dialog_init (GtrTranslationMemoryDialog *dlg)
   };
 
   priv->tm_settings = g_settings_new ("org.gnome.gtranslator.plugins.translation-memory");
+  priv->import_errors = g_string_new (NULL);
 
   gtk_dialog_add_buttons (GTK_DIALOG (dlg),
                           _("_Close"),
@@ -321,6 +715,9 @@ gtr_translation_memory_dialog_init (GtrTranslationMemoryDialog *dlg)
   priv->search_button = GTK_WIDGET (gtk_builder_get_object (builder, "search-button"));
   priv->add_database_button = GTK_WIDGET (gtk_builder_get_object (builder, "add-database-button"));
   priv->add_database_progressbar = GTK_WIDGET (gtk_builder_get_object (builder, "add-database-progressbar"));
+  priv->import_tmx_button = GTK_WIDGET (gtk_builder_get_object (builder, "import-tmx-button"));
+  priv->export_tmx_button = GTK_WIDGET (gtk_builder_get_object (builder, "export-tmx-button"));
+  priv->clean_database_button = GTK_WIDGET (gtk_builder_get_object (builder, "clean-database-button"));
   priv->use_lang_profile_in_tm = GTK_WIDGET (gtk_builder_get_object (builder, "use-lang-profile-in-tm"));
   priv->tm_lang_entry = GTK_WIDGET (gtk_builder_get_object (builder, "tm-lang-entry"));
   g_object_unref (builder);
@@ -335,6 +732,7 @@ gtr_translation_memory_dialog_init (GtrTranslationMemoryDialog *dlg)
     {
       language_code = gtr_profile_get_language_code (profile);
       filename = g_strconcat (language_code, ".po", NULL);
+      priv->language_code = g_strdup (language_code);
 
       gtk_entry_set_text (GTK_ENTRY (priv->tm_lang_entry), filename);
     }
@@ -368,6 +766,15 @@ gtr_translation_memory_dialog_init (GtrTranslationMemoryDialog *dlg)
 
   g_signal_connect (GTK_BUTTON (priv->add_database_button), "clicked",
                     G_CALLBACK (on_add_database_button_clicked), dlg);
+
+  g_signal_connect (GTK_BUTTON (priv->import_tmx_button), "clicked",
+                    G_CALLBACK (on_import_tmx_button_clicked), dlg);
+
+  g_signal_connect (GTK_BUTTON (priv->export_tmx_button), "clicked",
+                    G_CALLBACK (on_export_tmx_button_clicked), dlg);
+
+  g_signal_connect (GTK_BUTTON (priv->clean_database_button), "clicked",
+                    G_CALLBACK (on_clean_database_button_clicked), dlg);
 }
 
 GtkWidget *
@@ -0,0 +1,679 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-translation-memory-importer.h"
+#include "gtr-po.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+
+/*
+ * The import is a producer/consumer pipeline: a pool of threads parses
+ * the PO files and queues the results, and a single writer thread pops
+ * them and stores the messages in the translation memory. The queue is
+ * bounded so a slow database does not keep every parsed file in memory.
+ *
+ * Files whose stamp matches the one recorded by the translation memory
+ * in a previous import are not parsed at all.
+ */
+#define MAX_PARSED_PENDING 16
+
+typedef enum
+{
+  FILE_STATE_PARSED,
+  /* Same size and modification time as in the last import */
+  FILE_STATE_UNCHANGED,
+  /* Touched since the last import, but with the same content */
+  FILE_STATE_TOUCHED
+} FileState;
+
+typedef struct
+{
+  GFile *location;
+  GtrPo *po;
+  GError *error;
+
+  FileState state;
+  gchar *path;
+  goffset size;
+  gint64 mtime;
+  gchar *hash;
+} ParsedFile;
+
+typedef struct
+{
+  GFile *location;
+  gchar *message;
+} FailedFile;
+
+typedef struct
+{
+  GtrTranslationMemory *tm;
+
+  GMutex lock;
+  GCond cond;
+
+  /* Files added before the import was started */
+  GQueue pending;
+  /* Parsed files waiting for the writer */
+  GQueue parsed;
+  /* Failures waiting to be reported in the main context */
+  GQueue failed;
+
+  GThreadPool *parse_pool;
+
+  GCancellable *cancellable;
+  gulong cancelled_id;
+  GMainContext *context;
+  guint dispatch_source;
+
+  guint n_added;
+  guint n_done;
+  guint n_failed;
+
+  guint closed : 1;
+  guint running : 1;
+} GtrTranslationMemoryImporterPrivate;
+
+enum
+{
+  PROGRESS,
+  FILE_FAILED,
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtrTranslationMemoryImporter,
+                            gtr_translation_memory_importer,
+                            G_TYPE_OBJECT)
+
+static void
+parsed_file_free (ParsedFile *parsed)
+{
+  g_clear_object (&parsed->location);
+  g_clear_object (&parsed->po);
+  g_clear_error (&parsed->error);
+  g_free (parsed->path);
+  g_free (parsed->hash);
+  g_slice_free (ParsedFile, parsed);
+}
+
+static void
+failed_file_free (FailedFile *failed)
+{
+  g_object_unref (failed->location);
+  g_free (failed->message);
+  g_slice_free (FailedFile, failed);
+}
+
+static gboolean
+dispatch_updates (gpointer data)
+{
+  GtrTranslationMemoryImporter *importer = GTR_TRANSLATION_MEMORY_IMPORTER (data);
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+  GQueue failed = G_QUEUE_INIT;
+  FailedFile *f;
+  guint done, total;
+
+  g_mutex_lock (&priv->lock);
+  priv->dispatch_source = 0;
+  done = priv->n_done;
+  total = priv->n_added;
+  failed = priv->failed;
+  g_queue_init (&priv->failed);
+  g_mutex_unlock (&priv->lock);
+
+  while ((f = g_queue_pop_head (&failed)) != NULL)
+    {
+      g_signal_emit (importer, signals[FILE_FAILED], 0, f->location, f->message);
+      failed_file_free (f);
+    }
+
+  g_signal_emit (importer, signals[PROGRESS], 0, done, total);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Must be called with the lock held */
+static void
+schedule_dispatch (GtrTranslationMemoryImporter *importer)
+{
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+  GSource *source;
+
+  if (priv->dispatch_source != 0)
+    return;
+
+  source = g_idle_source_new ();
+  g_source_set_priority (source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (source, dispatch_updates,
+                         g_object_ref (importer), g_object_unref);
+  priv->dispatch_source = g_source_attach (source, priv->context);
+  g_source_unref (source);
+}
+
+static gboolean
+query_file_stamp (ParsedFile *parsed)
+{
+  GFileInfo *info;
+
+  parsed->path = g_file_get_path (parsed->location);
+  if (parsed->path == NULL)
+    return FALSE;
+
+  info = g_file_query_info (parsed->location,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL, NULL);
+  if (info == NULL)
+    return FALSE;
+
+  parsed->size = g_file_info_get_size (info);
+  parsed->mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+                  g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  g_object_unref (info);
+
+  return TRUE;
+}
+
+static gchar *
+compute_file_hash (const gchar *path)
+{
+  GMappedFile *mapped;
+  gchar *hash;
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  if (mapped == NULL)
+    return NULL;
+
+  hash = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                      (const guchar *) g_mapped_file_get_contents (mapped),
+                                      g_mapped_file_get_length (mapped));
+  g_mapped_file_unref (mapped);
+
+  return hash;
+}
+
+/*
+ * Compares the file with the stamp recorded in the translation memory,
+ * the size and modification time are checked first so unchanged files
+ * are skipped without reading them.
+ */
+static void
+check_file_stamp (GtrTranslationMemoryImporter *importer,
+                  ParsedFile                   *parsed)
+{
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+  goffset old_size;
+  gint64 old_mtime;
+  gchar *old_hash = NULL;
+  gboolean known;
+
+  if (!query_file_stamp (parsed))
+    return;
+
+  known = gtr_translation_memory_get_file_stamp (priv->tm, parsed->path,
+                                                 &old_size, &old_mtime,
+                                                 &old_hash);
+
+  if (known && old_size == parsed->size && old_mtime == parsed->mtime)
+    parsed->state = FILE_STATE_UNCHANGED;
+  else
+    {
+      parsed->hash = compute_file_hash (parsed->path);
+
+      if (known && g_strcmp0 (parsed->hash, old_hash) == 0)
+        parsed->state = FILE_STATE_TOUCHED;
+    }
+
+  g_free (old_hash);
+}
+
+static void
+parse_file_func (gpointer data,
+                 gpointer user_data)
+{
+  GtrTranslationMemoryImporter *importer = GTR_TRANSLATION_MEMORY_IMPORTER (user_data);
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+  ParsedFile *parsed;
+
+  parsed = g_slice_new0 (ParsedFile);
+  parsed->location = G_FILE (data);
+  parsed->state = FILE_STATE_PARSED;
+
+  if (!g_cancellable_is_cancelled (priv->cancellable))
+    check_file_stamp (importer, parsed);
+
+  if (parsed->state == FILE_STATE_PARSED &&
+      !g_cancellable_is_cancelled (priv->cancellable))
+    {
+      parsed->po = gtr_po_new ();
+
+      /* gtr_po_parse drops the object on failure */
+      if (!gtr_po_parse (parsed->po, parsed->location, &parsed->error))
+        parsed->po = NULL;
+      else
+        g_clear_error (&parsed->error);
+    }
+
+  g_mutex_lock (&priv->lock);
+
+  while (priv->parsed.length >= MAX_PARSED_PENDING &&
+         !g_cancellable_is_cancelled (priv->cancellable))
+    g_cond_wait (&priv->cond, &priv->lock);
+
+  g_queue_push_tail (&priv->parsed, parsed);
+  g_cond_broadcast (&priv->cond);
+
+  g_mutex_unlock (&priv->lock);
+}
+
+static void
+store_parsed_file (GtrTranslationMemoryImporter *importer,
+                   ParsedFile                   *parsed)
+{
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+  gchar *message = NULL;
+  gboolean stored = TRUE;
+
+  if (parsed->state == FILE_STATE_TOUCHED)
+    gtr_translation_memory_set_file_stamp (priv->tm, parsed->path,
+                                           parsed->size, parsed->mtime,
+                                           parsed->hash);
+  else if (parsed->po != NULL)
+    {
+      GList *msgs = gtr_po_get_messages (parsed->po);
+
+      if (parsed->hash != NULL)
+        stored = gtr_translation_memory_store_file (priv->tm, parsed->path,
+                                                    parsed->size, parsed->mtime,
+                                                    parsed->hash, msgs);
+      else
+        stored = gtr_translation_memory_store_list (priv->tm, msgs);
+
+      if (!stored)
+        message = g_strdup (_("Could not store the messages in the translation memory"));
+    }
+  else if (parsed->error != NULL)
+    message = g_strdup (parsed->error->message);
+
+  g_mutex_lock (&priv->lock);
+
+  priv->n_done++;
+
+  if (message != NULL)
+    {
+      FailedFile *failed = g_slice_new (FailedFile);
+
+      failed->location = g_object_ref (parsed->location);
+      failed->message = message;
+      g_queue_push_tail (&priv->failed, failed);
+      priv->n_failed++;
+    }
+
+  schedule_dispatch (importer);
+  g_cond_broadcast (&priv->cond);
+
+  g_mutex_unlock (&priv->lock);
+}
+
+static void
+writer_thread_func (GTask                        *task,
+                    GtrTranslationMemoryImporter *importer,
+                    gpointer                      task_data,
+                    GCancellable                 *cancellable)
+{
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+  GThreadPool *parse_pool;
+  ParsedFile *parsed;
+
+  while (TRUE)
+    {
+      g_mutex_lock (&priv->lock);
+
+      while (priv->parsed.length == 0 &&
+             !(priv->closed && priv->n_done == priv->n_added) &&
+             !g_cancellable_is_cancelled (cancellable))
+        g_cond_wait (&priv->cond, &priv->lock);
+
+      parsed = g_queue_pop_head (&priv->parsed);
+      g_cond_broadcast (&priv->cond);
+
+      g_mutex_unlock (&priv->lock);
+
+      if (parsed == NULL || g_cancellable_is_cancelled (cancellable))
+        break;
+
+      store_parsed_file (importer, parsed);
+      parsed_file_free (parsed);
+    }
+
+  if (parsed != NULL)
+    parsed_file_free (parsed);
+
+  g_mutex_lock (&priv->lock);
+  parse_pool = priv->parse_pool;
+  priv->parse_pool = NULL;
+  g_mutex_unlock (&priv->lock);
+
+  /* Once cancelled the parsers skip the files still queued */
+  g_thread_pool_free (parse_pool, FALSE, TRUE);
+
+  g_mutex_lock (&priv->lock);
+  g_queue_free_full (&priv->parsed, (GDestroyNotify) parsed_file_free);
+  g_queue_init (&priv->parsed);
+  priv->running = FALSE;
+  schedule_dispatch (importer);
+  g_mutex_unlock (&priv->lock);
+
+  if (!g_task_return_error_if_cancelled (task))
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+on_cancelled (GCancellable                 *cancellable,
+              GtrTranslationMemoryImporter *importer)
+{
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  /* Wake up the writer and the parsers waiting for room in the queue */
+  g_mutex_lock (&priv->lock);
+  g_cond_broadcast (&priv->cond);
+  g_mutex_unlock (&priv->lock);
+}
+
+static void
+gtr_translation_memory_importer_dispose (GObject *object)
+{
+  GtrTranslationMemoryImporter *importer = GTR_TRANSLATION_MEMORY_IMPORTER (object);
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_disconnect (priv->cancellable, priv->cancelled_id);
+      priv->cancelled_id = 0;
+      g_clear_object (&priv->cancellable);
+    }
+
+  g_clear_object (&priv->tm);
+  g_clear_pointer (&priv->context, g_main_context_unref);
+
+  G_OBJECT_CLASS (gtr_translation_memory_importer_parent_class)->dispose (object);
+}
+
+static void
+gtr_translation_memory_importer_finalize (GObject *object)
+{
+  GtrTranslationMemoryImporter *importer = GTR_TRANSLATION_MEMORY_IMPORTER (object);
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  g_queue_free_full (&priv->pending, g_object_unref);
+  g_queue_free_full (&priv->parsed, (GDestroyNotify) parsed_file_free);
+  g_queue_free_full (&priv->failed, (GDestroyNotify) failed_file_free);
+
+  g_mutex_clear (&priv->lock);
+  g_cond_clear (&priv->cond);
+
+  G_OBJECT_CLASS (gtr_translation_memory_importer_parent_class)->finalize (object);
+}
+
+static void
+gtr_translation_memory_importer_class_init (GtrTranslationMemoryImporterClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gtr_translation_memory_importer_dispose;
+  object_class->finalize = gtr_translation_memory_importer_finalize;
+
+  signals[PROGRESS] =
+    g_signal_new ("progress",
+                  G_OBJECT_CLASS_TYPE (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (GtrTranslationMemoryImporterClass, progress),
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_UINT);
+
+  signals[FILE_FAILED] =
+    g_signal_new ("file-failed",
+                  G_OBJECT_CLASS_TYPE (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (GtrTranslationMemoryImporterClass, file_failed),
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2, G_TYPE_FILE, G_TYPE_STRING);
+}
+
+static void
+gtr_translation_memory_importer_init (GtrTranslationMemoryImporter *importer)
+{
+  GtrTranslationMemoryImporterPrivate *priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->cond);
+  g_queue_init (&priv->pending);
+  g_queue_init (&priv->parsed);
+  g_queue_init (&priv->failed);
+}
+
+/**
+ * gtr_translation_memory_importer_new:
+ * @tm: the #GtrTranslationMemory to store the messages in
+ *
+ * Creates a new #GtrTranslationMemoryImporter. @tm must be safe to use
+ * from a thread other than the main one.
+ *
+ * Returns: a new #GtrTranslationMemoryImporter
+ */
+GtrTranslationMemoryImporter *
+gtr_translation_memory_importer_new (GtrTranslationMemory *tm)
+{
+  GtrTranslationMemoryImporter *importer;
+  GtrTranslationMemoryImporterPrivate *priv;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY (tm), NULL);
+
+  importer = g_object_new (GTR_TYPE_TRANSLATION_MEMORY_IMPORTER, NULL);
+  priv = gtr_translation_memory_importer_get_instance_private (importer);
+  priv->tm = g_object_ref (tm);
+
+  return importer;
+}
+
+/**
+ * gtr_translation_memory_importer_add_file:
+ * @importer: a #GtrTranslationMemoryImporter
+ * @location: a PO file
+ *
+ * Queues @location to be imported. It can be called from any thread,
+ * before or while the import is running, until
+ * gtr_translation_memory_importer_close() is called.
+ */
+void
+gtr_translation_memory_importer_add_file (GtrTranslationMemoryImporter *importer,
+                                          GFile                        *location)
+{
+  GtrTranslationMemoryImporterPrivate *priv;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY_IMPORTER (importer));
+  g_return_if_fail (G_IS_FILE (location));
+
+  priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  g_mutex_lock (&priv->lock);
+
+  g_warn_if_fail (!priv->closed);
+
+  priv->n_added++;
+  if (priv->parse_pool != NULL)
+    g_thread_pool_push (priv->parse_pool, g_object_ref (location), NULL);
+  else if (!priv->running)
+    g_queue_push_tail (&priv->pending, g_object_ref (location));
+
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gtr_translation_memory_importer_close:
+ * @importer: a #GtrTranslationMemoryImporter
+ *
+ * Tells @importer that no more files will be added, the import finishes
+ * once every added file has been stored. It can be called from any thread.
+ */
+void
+gtr_translation_memory_importer_close (GtrTranslationMemoryImporter *importer)
+{
+  GtrTranslationMemoryImporterPrivate *priv;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY_IMPORTER (importer));
+
+  priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  g_mutex_lock (&priv->lock);
+  priv->closed = TRUE;
+  g_cond_broadcast (&priv->cond);
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gtr_translation_memory_importer_run_async:
+ * @importer: a #GtrTranslationMemoryImporter
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: called when every file has been imported
+ * @user_data: data for @callback
+ *
+ * Starts importing the added files. The #GtrTranslationMemoryImporter::progress
+ * and #GtrTranslationMemoryImporter::file-failed signals are emitted in the
+ * thread-default main context of the caller.
+ */
+void
+gtr_translation_memory_importer_run_async (GtrTranslationMemoryImporter *importer,
+                                           GCancellable                 *cancellable,
+                                           GAsyncReadyCallback           callback,
+                                           gpointer                      user_data)
+{
+  GtrTranslationMemoryImporterPrivate *priv;
+  GFile *location;
+  GTask *task;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY_IMPORTER (importer));
+
+  priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  g_return_if_fail (!priv->running && priv->cancellable == NULL);
+
+  priv->context = g_main_context_ref_thread_default ();
+  priv->cancellable = cancellable ? g_object_ref (cancellable) : g_cancellable_new ();
+  priv->cancelled_id = g_cancellable_connect (priv->cancellable,
+                                              G_CALLBACK (on_cancelled),
+                                              importer, NULL);
+
+  task = g_task_new (importer, priv->cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_translation_memory_importer_run_async);
+
+  g_mutex_lock (&priv->lock);
+
+  priv->running = TRUE;
+  priv->parse_pool = g_thread_pool_new (parse_file_func,
+                                        importer,
+                                        g_get_num_processors (),
+                                        FALSE,
+                                        NULL);
+
+  while ((location = g_queue_pop_head (&priv->pending)) != NULL)
+    g_thread_pool_push (priv->parse_pool, location, NULL);
+
+  g_mutex_unlock (&priv->lock);
+
+  g_task_run_in_thread (task, (GTaskThreadFunc) writer_thread_func);
+  g_object_unref (task);
+}
+
+/**
+ * gtr_translation_memory_importer_run_finish:
+ * @importer: a #GtrTranslationMemoryImporter
+ * @result: the #GAsyncResult
+ * @error: a #GError or %NULL
+ *
+ * Finishes an import started with gtr_translation_memory_importer_run_async().
+ * Files that could not be parsed or stored do not make the import fail, they
+ * are reported with the #GtrTranslationMemoryImporter::file-failed signal.
+ *
+ * Returns: %FALSE if the import was cancelled
+ */
+gboolean
+gtr_translation_memory_importer_run_finish (GtrTranslationMemoryImporter  *importer,
+                                            GAsyncResult                  *result,
+                                            GError                       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, importer), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * gtr_translation_memory_importer_get_n_done:
+ * @importer: a #GtrTranslationMemoryImporter
+ *
+ * Returns: the number of files processed so far
+ */
+guint
+gtr_translation_memory_importer_get_n_done (GtrTranslationMemoryImporter *importer)
+{
+  GtrTranslationMemoryImporterPrivate *priv;
+  guint n;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_IMPORTER (importer), 0);
+
+  priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  g_mutex_lock (&priv->lock);
+  n = priv->n_done;
+  g_mutex_unlock (&priv->lock);
+
+  return n;
+}
+
+/**
+ * gtr_translation_memory_importer_get_n_failed:
+ * @importer: a #GtrTranslationMemoryImporter
+ *
+ * Returns: the number of files that could not be imported
+ */
+guint
+gtr_translation_memory_importer_get_n_failed (GtrTranslationMemoryImporter *importer)
+{
+  GtrTranslationMemoryImporterPrivate *priv;
+  guint n;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_IMPORTER (importer), 0);
+
+  priv = gtr_translation_memory_importer_get_instance_private (importer);
+
+  g_mutex_lock (&priv->lock);
+  n = priv->n_failed;
+  g_mutex_unlock (&priv->lock);
+
+  return n;
+}
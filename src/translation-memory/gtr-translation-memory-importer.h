@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTR_TRANSLATION_MEMORY_IMPORTER_H__
+#define __GTR_TRANSLATION_MEMORY_IMPORTER_H__
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "gtr-translation-memory.h"
+
+G_BEGIN_DECLS
+
+#define GTR_TYPE_TRANSLATION_MEMORY_IMPORTER            (gtr_translation_memory_importer_get_type ())
+#define GTR_TRANSLATION_MEMORY_IMPORTER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTR_TYPE_TRANSLATION_MEMORY_IMPORTER, GtrTranslationMemoryImporter))
+#define GTR_TRANSLATION_MEMORY_IMPORTER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GTR_TYPE_TRANSLATION_MEMORY_IMPORTER, GtrTranslationMemoryImporterClass))
+#define GTR_IS_TRANSLATION_MEMORY_IMPORTER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTR_TYPE_TRANSLATION_MEMORY_IMPORTER))
+#define GTR_IS_TRANSLATION_MEMORY_IMPORTER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GTR_TYPE_TRANSLATION_MEMORY_IMPORTER))
+#define GTR_TRANSLATION_MEMORY_IMPORTER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GTR_TYPE_TRANSLATION_MEMORY_IMPORTER, GtrTranslationMemoryImporterClass))
+
+typedef struct _GtrTranslationMemoryImporter        GtrTranslationMemoryImporter;
+typedef struct _GtrTranslationMemoryImporterClass   GtrTranslationMemoryImporterClass;
+
+struct _GtrTranslationMemoryImporter
+{
+  GObject parent_instance;
+};
+
+struct _GtrTranslationMemoryImporterClass
+{
+  GObjectClass parent_class;
+
+  /* Signals */
+  void (*progress)    (GtrTranslationMemoryImporter *importer,
+                       guint                         done,
+                       guint                         total);
+  void (*file_failed) (GtrTranslationMemoryImporter *importer,
+                       GFile                        *location,
+                       const gchar                  *message);
+};
+
+GType                          gtr_translation_memory_importer_get_type     (void) G_GNUC_CONST;
+
+GtrTranslationMemoryImporter  *gtr_translation_memory_importer_new          (GtrTranslationMemory          *tm);
+
+void                           gtr_translation_memory_importer_add_file     (GtrTranslationMemoryImporter  *importer,
+                                                                             GFile                         *location);
+
+void                           gtr_translation_memory_importer_close        (GtrTranslationMemoryImporter  *importer);
+
+void                           gtr_translation_memory_importer_run_async    (GtrTranslationMemoryImporter  *importer,
+                                                                             GCancellable                  *cancellable,
+                                                                             GAsyncReadyCallback            callback,
+                                                                             gpointer                       user_data);
+
+gboolean                       gtr_translation_memory_importer_run_finish   (GtrTranslationMemoryImporter  *importer,
+                                                                             GAsyncResult                  *result,
+                                                                             GError                       **error);
+
+guint                          gtr_translation_memory_importer_get_n_done   (GtrTranslationMemoryImporter  *importer);
+
+guint                          gtr_translation_memory_importer_get_n_failed (GtrTranslationMemoryImporter  *importer);
+
+G_END_DECLS
+
+#endif /* __GTR_TRANSLATION_MEMORY_IMPORTER_H__ */
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-translation-memory-maintenance.h"
+#include "gtr-translation-memory-partitions.h"
+#include "gtr-debug.h"
+
+/* Seconds after startup before the scheduled maintenance is checked, so
+ * it does not compete with loading the first files */
+#define MAINTENANCE_DELAY 300
+
+#define SECONDS_PER_DAY (24 * 60 * 60)
+
+/* Every window shares the same database, only one maintenance runs */
+G_LOCK_DEFINE_STATIC (maintenance);
+
+typedef struct
+{
+  GtrTranslationMemoryPartitions *partitions;
+  GSettings *settings;
+} IdleMaintenance;
+
+static void
+idle_maintenance_free (IdleMaintenance *idle)
+{
+  g_object_unref (idle->partitions);
+  g_object_unref (idle->settings);
+  g_slice_free (IdleMaintenance, idle);
+}
+
+static void
+maintain_thread (GTask                *task,
+                 GtrTranslationMemory *tm,
+                 gint64               *reclaimed,
+                 GCancellable         *cancellable)
+{
+  GError *error = NULL;
+  gboolean result;
+
+  G_LOCK (maintenance);
+  result = gtr_translation_memory_maintain (tm, cancellable, reclaimed, &error);
+  G_UNLOCK (maintenance);
+
+  if (result)
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_error (task, error);
+}
+
+/**
+ * gtr_translation_memory_maintain_async:
+ * @tm: a #GtrTranslationMemory
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: called when the maintenance finishes
+ * @user_data: data for @callback
+ *
+ * Runs gtr_translation_memory_maintain() on a worker thread.
+ */
+void
+gtr_translation_memory_maintain_async (GtrTranslationMemory *tm,
+                                       GCancellable         *cancellable,
+                                       GAsyncReadyCallback   callback,
+                                       gpointer              user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY (tm));
+
+  task = g_task_new (tm, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_translation_memory_maintain_async);
+  g_task_set_task_data (task, g_new0 (gint64, 1), g_free);
+  g_task_run_in_thread (task, (GTaskThreadFunc) maintain_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gtr_translation_memory_maintain_finish:
+ * @tm: a #GtrTranslationMemory
+ * @result: the #GAsyncResult
+ * @reclaimed: (out) (optional): return location for the bytes reclaimed
+ * @error: a #GError or %NULL
+ *
+ * Finishes a maintenance started with gtr_translation_memory_maintain_async().
+ *
+ * Returns: %TRUE if the maintenance succeeded
+ */
+gboolean
+gtr_translation_memory_maintain_finish (GtrTranslationMemory  *tm,
+                                        GAsyncResult          *result,
+                                        gint64                *reclaimed,
+                                        GError               **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, tm), FALSE);
+
+  if (reclaimed != NULL)
+    *reclaimed = *(gint64 *) g_task_get_task_data (G_TASK (result));
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Maintains every partition in turn, the ones that failed are reported
+ * and the others still maintained */
+static void
+maintain_partitions_thread (GTask        *task,
+                            gpointer      source_object,
+                            GPtrArray    *memories,
+                            GCancellable *cancellable)
+{
+  gint64 total = 0;
+  gchar *size;
+  guint i;
+
+  for (i = 0; i < memories->len; i++)
+    {
+      GtrTranslationMemory *tm = g_ptr_array_index (memories, i);
+      GError *error = NULL;
+      gint64 reclaimed = 0;
+      gboolean result;
+
+      G_LOCK (maintenance);
+      result = gtr_translation_memory_maintain (tm, cancellable, &reclaimed, &error);
+      G_UNLOCK (maintenance);
+
+      if (result)
+        total += reclaimed;
+      else
+        {
+          g_warning ("Translation memory maintenance failed: %s", error->message);
+          g_error_free (error);
+        }
+    }
+
+  size = g_format_size (total);
+  DEBUG_PRINT ("Translation memory maintenance reclaimed %s", size);
+  g_free (size);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+maintenance_timeout_cb (gpointer user_data)
+{
+  IdleMaintenance *idle = user_data;
+  GSettings *settings = idle->settings;
+  gint64 now, last;
+  gint interval;
+
+  interval = g_settings_get_int (settings, "maintenance-interval");
+  last = g_settings_get_int64 (settings, "last-maintenance");
+  now = g_get_real_time () / G_USEC_PER_SEC;
+
+  if (interval > 0 && now - last >= (gint64) interval * SECONDS_PER_DAY)
+    {
+      GPtrArray *memories;
+      GTask *task;
+      gchar **languages;
+      gint i;
+
+      /* Recorded first so other windows don't start it again */
+      g_settings_set_int64 (settings, "last-maintenance", now);
+
+      /* Every database on disk, not only the ones opened so far */
+      memories = g_ptr_array_new_with_free_func (g_object_unref);
+      languages = gtr_translation_memory_partitions_list_languages (idle->partitions);
+      for (i = 0; languages[i] != NULL; i++)
+        g_ptr_array_add (memories,
+                         g_object_ref (gtr_translation_memory_partitions_get (idle->partitions,
+                                                                              languages[i])));
+      g_strfreev (languages);
+
+      task = g_task_new (NULL, NULL, NULL, NULL);
+      g_task_set_source_tag (task, maintenance_timeout_cb);
+      g_task_set_task_data (task, memories, (GDestroyNotify) g_ptr_array_unref);
+      g_task_run_in_thread (task, (GTaskThreadFunc) maintain_partitions_thread);
+      g_object_unref (task);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gtr_translation_memory_maintain_when_idle:
+ * @partitions: a #GtrTranslationMemoryPartitions
+ * @settings: the translation memory #GSettings
+ *
+ * Schedules a background maintenance of the database of every language
+ * of @partitions a few minutes from now, at low priority, if the last one
+ * is older than the maintenance-interval setting.
+ *
+ * Returns: the id of the source, to remove it if @partitions goes away before
+ */
+guint
+gtr_translation_memory_maintain_when_idle (GtrTranslationMemoryPartitions *partitions,
+                                           GSettings                      *settings)
+{
+  IdleMaintenance *idle;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_PARTITIONS (partitions), 0);
+  g_return_val_if_fail (G_IS_SETTINGS (settings), 0);
+
+  idle = g_slice_new (IdleMaintenance);
+  idle->partitions = g_object_ref (partitions);
+  idle->settings = g_object_ref (settings);
+
+  return g_timeout_add_seconds_full (G_PRIORITY_LOW, MAINTENANCE_DELAY,
+                                     maintenance_timeout_cb, idle,
+                                     (GDestroyNotify) idle_maintenance_free);
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The translation memory is split by target language, each language in its
+ * own database file, so the suggestions never come from another language
+ * and every lookup searches a smaller index. The databases are opened the
+ * first time a file in their language needs them.
+ *
+ * The database of the messages without a known language is the one that
+ * held every language before the split. Its translations can't be sorted
+ * by language, so its matches are merged with the ones of each language,
+ * ranked below them on the same level.
+ *
+ * There is a single instance for the whole application, so every window
+ * shares the same connections and prepared statements.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-translation-memory-partitions.h"
+#include "gtr-translation-memory-cache.h"
+#include "gtr-translation-memory-utils.h"
+#include "gtr-debug.h"
+#include "gtr-dirs.h"
+#include "gda/gtr-gda.h"
+#include "sqlite/gtr-sqlite.h"
+
+#include <string.h>
+
+/* Number of lookups remembered for each language */
+#define CACHE_SIZE 256
+
+/* Matches shown for a message */
+#define MAX_ITEMS 10
+
+/* Key of the partition of the messages without a known language */
+#define NO_LANGUAGE ""
+
+#define DATABASE_PREFIX "translation-memory"
+#define DATABASE_SUFFIX ".db"
+
+typedef struct
+{
+  GSettings *settings;
+
+  GMutex lock;
+  /* language code -> GtrTranslationMemory */
+  GHashTable *partitions;
+} GtrTranslationMemoryPartitionsPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtrTranslationMemoryPartitions,
+                            gtr_translation_memory_partitions,
+                            G_TYPE_OBJECT)
+
+static GtrTranslationMemory *get_locked (GtrTranslationMemoryPartitions *partitions,
+                                         const gchar                    *language);
+
+/* Whether the database of @language was created, before it is opened */
+static gboolean
+database_exists (const gchar *language)
+{
+  gchar *name;
+  gchar *basename;
+  gchar *filename;
+  gboolean exists;
+
+  name = gtr_translation_memory_utils_database_name (language);
+  basename = g_strconcat (name, DATABASE_SUFFIX, NULL);
+  filename = g_build_filename (gtr_dirs_get_user_config_dir (), basename, NULL);
+
+  exists = g_file_test (filename, G_FILE_TEST_IS_REGULAR);
+
+  g_free (filename);
+  g_free (basename);
+  g_free (name);
+
+  return exists;
+}
+
+static GtrTranslationMemory *
+open_partition (GtrTranslationMemoryPartitions *partitions,
+                const gchar                    *language)
+{
+  GtrTranslationMemoryPartitionsPrivate *priv = gtr_translation_memory_partitions_get_instance_private (partitions);
+  GtrTranslationMemory *tm;
+  GtrTranslationMemory *cache;
+  gchar *backend;
+
+  backend = g_settings_get_string (priv->settings, "backend");
+  if (g_strcmp0 (backend, "gda") == 0)
+    tm = GTR_TRANSLATION_MEMORY (gtr_gda_new (language));
+  else
+    tm = GTR_TRANSLATION_MEMORY (gtr_sqlite_new (g_strcmp0 (backend, "sqlite-fts5") == 0,
+                                                 language));
+  g_free (backend);
+
+  /* The same messages are looked up every time they are shown */
+  cache = GTR_TRANSLATION_MEMORY (gtr_translation_memory_cache_new (tm, CACHE_SIZE));
+  g_object_unref (tm);
+
+  gtr_translation_memory_set_max_omits (cache,
+                                        g_settings_get_int (priv->settings,
+                                                            "max-missing-words"));
+  gtr_translation_memory_set_max_delta (cache,
+                                        g_settings_get_int (priv->settings,
+                                                            "max-length-diff"));
+  gtr_translation_memory_set_max_items (cache, MAX_ITEMS);
+
+  if (language != NULL && database_exists (NULL))
+    gtr_translation_memory_cache_set_fallback (GTR_TRANSLATION_MEMORY_CACHE (cache),
+                                               get_locked (partitions, NO_LANGUAGE));
+
+  DEBUG_PRINT ("Opened the translation memory of '%s'", language);
+
+  return cache;
+}
+
+/* Must be called with priv->lock held */
+static GtrTranslationMemory *
+get_locked (GtrTranslationMemoryPartitions *partitions,
+            const gchar                    *language)
+{
+  GtrTranslationMemoryPartitionsPrivate *priv = gtr_translation_memory_partitions_get_instance_private (partitions);
+  GtrTranslationMemory *tm;
+
+  tm = g_hash_table_lookup (priv->partitions, language);
+  if (tm == NULL)
+    {
+      tm = open_partition (partitions, *language != '\0' ? language : NULL);
+      g_hash_table_insert (priv->partitions, g_strdup (language), tm);
+    }
+
+  return tm;
+}
+
+static void
+gtr_translation_memory_partitions_init (GtrTranslationMemoryPartitions *partitions)
+{
+  GtrTranslationMemoryPartitionsPrivate *priv = gtr_translation_memory_partitions_get_instance_private (partitions);
+
+  g_mutex_init (&priv->lock);
+  priv->partitions = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free, g_object_unref);
+}
+
+static void
+gtr_translation_memory_partitions_dispose (GObject *object)
+{
+  GtrTranslationMemoryPartitions *partitions = GTR_TRANSLATION_MEMORY_PARTITIONS (object);
+  GtrTranslationMemoryPartitionsPrivate *priv = gtr_translation_memory_partitions_get_instance_private (partitions);
+
+  if (priv->partitions != NULL)
+    {
+      g_hash_table_unref (priv->partitions);
+      priv->partitions = NULL;
+    }
+
+  g_clear_object (&priv->settings);
+
+  G_OBJECT_CLASS (gtr_translation_memory_partitions_parent_class)->dispose (object);
+}
+
+static void
+gtr_translation_memory_partitions_finalize (GObject *object)
+{
+  GtrTranslationMemoryPartitions *partitions = GTR_TRANSLATION_MEMORY_PARTITIONS (object);
+  GtrTranslationMemoryPartitionsPrivate *priv = gtr_translation_memory_partitions_get_instance_private (partitions);
+
+  g_mutex_clear (&priv->lock);
+
+  G_OBJECT_CLASS (gtr_translation_memory_partitions_parent_class)->finalize (object);
+}
+
+static void
+gtr_translation_memory_partitions_class_init (GtrTranslationMemoryPartitionsClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gtr_translation_memory_partitions_dispose;
+  object_class->finalize = gtr_translation_memory_partitions_finalize;
+}
+
+/**
+ * gtr_translation_memory_partitions_new:
+ * @settings: the translation memory #GSettings
+ *
+ * Creates a new #GtrTranslationMemoryPartitions, which opens the translation
+ * memory of each language with the backend chosen in @settings.
+ *
+ * Returns: a new #GtrTranslationMemoryPartitions object
+ */
+GtrTranslationMemoryPartitions *
+gtr_translation_memory_partitions_new (GSettings *settings)
+{
+  GtrTranslationMemoryPartitions *partitions;
+  GtrTranslationMemoryPartitionsPrivate *priv;
+
+  g_return_val_if_fail (G_IS_SETTINGS (settings), NULL);
+
+  partitions = g_object_new (GTR_TYPE_TRANSLATION_MEMORY_PARTITIONS, NULL);
+  priv = gtr_translation_memory_partitions_get_instance_private (partitions);
+
+  priv->settings = g_object_ref (settings);
+
+  return partitions;
+}
+
+/**
+ * gtr_translation_memory_partitions_get_default:
+ *
+ * Gets the translation memories shared by all the windows, creating them
+ * the first time.
+ *
+ * Returns: (transfer full): the default #GtrTranslationMemoryPartitions
+ */
+GtrTranslationMemoryPartitions *
+gtr_translation_memory_partitions_get_default (void)
+{
+  static GtrTranslationMemoryPartitions *partitions = NULL;
+  GSettings *settings;
+
+  if (partitions != NULL)
+    return g_object_ref (partitions);
+
+  settings = g_settings_new ("org.gnome.gtranslator.plugins.translation-memory");
+  partitions = gtr_translation_memory_partitions_new (settings);
+  g_object_add_weak_pointer (G_OBJECT (partitions), (gpointer *) &partitions);
+  g_object_unref (settings);
+
+  return partitions;
+}
+
+/**
+ * gtr_translation_memory_partitions_get:
+ * @partitions: a #GtrTranslationMemoryPartitions
+ * @language: (nullable): a language code, like "pt_BR"
+ *
+ * Gets the translation memory of @language, opening its database if it is
+ * the first time it is used. When @language is %NULL or empty, the memory
+ * of the messages without a known language is returned.
+ *
+ * Returns: (transfer none): the #GtrTranslationMemory of @language
+ */
+GtrTranslationMemory *
+gtr_translation_memory_partitions_get (GtrTranslationMemoryPartitions *partitions,
+                                       const gchar                    *language)
+{
+  GtrTranslationMemoryPartitionsPrivate *priv;
+  GtrTranslationMemory *tm;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_PARTITIONS (partitions), NULL);
+
+  priv = gtr_translation_memory_partitions_get_instance_private (partitions);
+
+  if (language == NULL)
+    language = NO_LANGUAGE;
+
+  g_mutex_lock (&priv->lock);
+  tm = get_locked (partitions, language);
+  g_mutex_unlock (&priv->lock);
+
+  return tm;
+}
+
+/**
+ * gtr_translation_memory_partitions_list_languages:
+ * @partitions: a #GtrTranslationMemoryPartitions
+ *
+ * Lists the languages whose database exists, opened or not. The messages
+ * without a known language are listed as an empty string.
+ *
+ * Returns: (transfer full): a %NULL-terminated array of language codes
+ */
+gchar **
+gtr_translation_memory_partitions_list_languages (GtrTranslationMemoryPartitions *partitions)
+{
+  GPtrArray *languages;
+  GDir *dir;
+  const gchar *name;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY_PARTITIONS (partitions), NULL);
+
+  languages = g_ptr_array_new ();
+
+  dir = g_dir_open (gtr_dirs_get_user_config_dir (), 0, NULL);
+  while (dir != NULL && (name = g_dir_read_name (dir)) != NULL)
+    {
+      if (!g_str_has_prefix (name, DATABASE_PREFIX) ||
+          !g_str_has_suffix (name, DATABASE_SUFFIX))
+        continue;
+
+      /* translation-memory.db or translation-memory-<language>.db */
+      name += strlen (DATABASE_PREFIX);
+      if (strcmp (name, DATABASE_SUFFIX) == 0)
+        g_ptr_array_add (languages, g_strdup (NO_LANGUAGE));
+      else if (*name == '-' && strlen (name + 1) > strlen (DATABASE_SUFFIX))
+        g_ptr_array_add (languages,
+                         g_strndup (name + 1,
+                                    strlen (name + 1) - strlen (DATABASE_SUFFIX)));
+    }
+
+  if (dir != NULL)
+    g_dir_close (dir);
+
+  g_ptr_array_add (languages, NULL);
+
+  return (gchar **) g_ptr_array_free (languages, FALSE);
+}
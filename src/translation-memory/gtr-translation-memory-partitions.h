@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTR_TRANSLATION_MEMORY_PARTITIONS_H__
+#define __GTR_TRANSLATION_MEMORY_PARTITIONS_H__
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "gtr-translation-memory.h"
+
+G_BEGIN_DECLS
+
+#define GTR_TYPE_TRANSLATION_MEMORY_PARTITIONS            (gtr_translation_memory_partitions_get_type ())
+#define GTR_TRANSLATION_MEMORY_PARTITIONS(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTR_TYPE_TRANSLATION_MEMORY_PARTITIONS, GtrTranslationMemoryPartitions))
+#define GTR_TRANSLATION_MEMORY_PARTITIONS_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GTR_TYPE_TRANSLATION_MEMORY_PARTITIONS, GtrTranslationMemoryPartitionsClass))
+#define GTR_IS_TRANSLATION_MEMORY_PARTITIONS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTR_TYPE_TRANSLATION_MEMORY_PARTITIONS))
+#define GTR_IS_TRANSLATION_MEMORY_PARTITIONS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GTR_TYPE_TRANSLATION_MEMORY_PARTITIONS))
+#define GTR_TRANSLATION_MEMORY_PARTITIONS_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GTR_TYPE_TRANSLATION_MEMORY_PARTITIONS, GtrTranslationMemoryPartitionsClass))
+
+typedef struct _GtrTranslationMemoryPartitions        GtrTranslationMemoryPartitions;
+typedef struct _GtrTranslationMemoryPartitionsClass   GtrTranslationMemoryPartitionsClass;
+
+struct _GtrTranslationMemoryPartitions
+{
+  GObject parent_instance;
+};
+
+struct _GtrTranslationMemoryPartitionsClass
+{
+  GObjectClass parent_class;
+};
+
+GType                            gtr_translation_memory_partitions_get_type (void) G_GNUC_CONST;
+
+GtrTranslationMemoryPartitions  *gtr_translation_memory_partitions_new      (GSettings                      *settings);
+
+GtrTranslationMemoryPartitions  *gtr_translation_memory_partitions_get_default (void);
+
+GtrTranslationMemory            *gtr_translation_memory_partitions_get      (GtrTranslationMemoryPartitions *partitions,
+                                                                             const gchar                    *language);
+
+gchar                          **gtr_translation_memory_partitions_list_languages (GtrTranslationMemoryPartitions *partitions);
+
+G_END_DECLS
+
+#endif /* __GTR_TRANSLATION_MEMORY_PARTITIONS_H__ */
@@ -0,0 +1,425 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-translation-memory-pretranslate.h"
+#include "gtr-msg.h"
+#include "gtr-po.h"
+
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+
+/* Messages looked up by a worker at a time */
+#define LOOKUP_CHUNK 64
+
+#define CHANGES_DATA "GtrPretranslationChanges"
+
+typedef struct
+{
+  GtrTranslationMemory *tm;
+  GtrTab *tab;
+  gulong destroy_id;
+  GCancellable *cancellable;
+  gint min_score;
+
+  /* The untranslated messages and their msgids, the msgids are copied
+   * on the main thread so the workers never touch the catalog */
+  GPtrArray *msgs;
+  gchar **msgids;
+
+  /* Best match of each message, NULL if none reached min_score */
+  gchar **translations;
+  gint *levels;
+} Pretranslation;
+
+/* A message filled by the pre-translation, to undo it */
+typedef struct
+{
+  GtrMsg *msg;
+  gchar *translation;
+  gboolean fuzzy;
+} Change;
+
+static void
+free_match (gpointer data)
+{
+  GtrTranslationMemoryMatch *match = (GtrTranslationMemoryMatch *) data;
+
+  g_free (match->match);
+  g_slice_free (GtrTranslationMemoryMatch, match);
+}
+
+static void
+change_free (Change *change)
+{
+  g_object_unref (change->msg);
+  g_free (change->translation);
+  g_slice_free (Change, change);
+}
+
+static void
+changes_free (GList *changes)
+{
+  g_list_free_full (changes, (GDestroyNotify) change_free);
+}
+
+static void
+pretranslation_free (Pretranslation *pt)
+{
+  guint i;
+
+  if (pt->tab != NULL)
+    {
+      g_signal_handler_disconnect (pt->tab, pt->destroy_id);
+      g_object_remove_weak_pointer (G_OBJECT (pt->tab), (gpointer *) &pt->tab);
+    }
+
+  for (i = 0; i < pt->msgs->len; i++)
+    g_free (pt->translations[i]);
+  g_free (pt->translations);
+  g_free (pt->levels);
+  g_strfreev (pt->msgids);
+  g_ptr_array_unref (pt->msgs);
+
+  g_object_unref (pt->cancellable);
+  g_object_unref (pt->tm);
+
+  g_slice_free (Pretranslation, pt);
+}
+
+static void
+lookup_chunk (gpointer data,
+              gpointer user_data)
+{
+  Pretranslation *pt = user_data;
+  guint start = GPOINTER_TO_UINT (data) - 1;
+  guint end = MIN (start + LOOKUP_CHUNK, pt->msgs->len);
+  guint i;
+
+  for (i = start; i < end; i++)
+    {
+      GtrTranslationMemoryMatch *best;
+      GList *matches;
+
+      if (g_cancellable_is_cancelled (pt->cancellable))
+        return;
+
+      /* The matches are sorted by level */
+      matches = gtr_translation_memory_lookup (pt->tm, pt->msgids[i]);
+      if (matches == NULL)
+        continue;
+
+      best = matches->data;
+      if (best->level >= pt->min_score)
+        {
+          pt->translations[i] = g_strdup (best->match);
+          pt->levels[i] = best->level;
+        }
+
+      g_list_free_full (matches, free_match);
+    }
+}
+
+static void
+pretranslate_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancellable)
+{
+  Pretranslation *pt = task_data;
+  GThreadPool *pool;
+  guint i;
+
+  pool = g_thread_pool_new (lookup_chunk, pt, g_get_num_processors (),
+                            FALSE, NULL);
+
+  /* The index is shifted by one, NULL can't be pushed */
+  for (i = 0; i < pt->msgs->len; i += LOOKUP_CHUNK)
+    g_thread_pool_push (pool, GUINT_TO_POINTER (i + 1), NULL);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  if (!g_task_return_error_if_cancelled (task))
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+refresh_current_message (GtrTab *tab)
+{
+  gtr_tab_message_go_to (tab, gtr_tab_get_msg (tab), FALSE, GTR_TAB_MOVE_NONE);
+}
+
+static void
+undo_changes (GtrTab *tab,
+              GList  *changes)
+{
+  GList *l;
+
+  for (l = changes; l != NULL; l = g_list_next (l))
+    {
+      Change *change = l->data;
+
+      /* Leave alone the messages edited after the pre-translation */
+      if (g_strcmp0 (gtr_msg_get_msgstr (change->msg), change->translation) != 0)
+        continue;
+
+      gtr_msg_set_msgstr (change->msg, "");
+      gtr_msg_set_fuzzy (change->msg, change->fuzzy);
+      g_signal_emit_by_name (tab, "message_changed", change->msg);
+    }
+
+  refresh_current_message (tab);
+}
+
+static void
+summary_response_cb (GtkInfoBar *infobar,
+                     gint        response_id,
+                     GtrTab     *tab)
+{
+  if (response_id == GTK_RESPONSE_REJECT)
+    undo_changes (tab, g_object_get_data (G_OBJECT (infobar), CHANGES_DATA));
+
+  gtr_tab_set_info_bar (tab, NULL);
+}
+
+static void
+progress_response_cb (GtkInfoBar   *infobar,
+                      gint          response_id,
+                      GCancellable *cancellable)
+{
+  g_cancellable_cancel (cancellable);
+}
+
+static GtkWidget *
+create_info_bar (const gchar *text)
+{
+  GtkWidget *infobar;
+  GtkWidget *label;
+
+  infobar = gtk_info_bar_new ();
+  gtk_info_bar_set_message_type (GTK_INFO_BAR (infobar), GTK_MESSAGE_INFO);
+
+  label = gtk_label_new (text);
+  gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+  gtk_label_set_xalign (GTK_LABEL (label), 0.0);
+  gtk_container_add (GTK_CONTAINER (gtk_info_bar_get_content_area (GTK_INFO_BAR (infobar))),
+                     label);
+  gtk_widget_show (label);
+
+  return infobar;
+}
+
+static void
+show_summary (GtrTab *tab,
+              guint   n_untranslated,
+              guint   n_exact,
+              guint   n_fuzzy,
+              GList  *changes)
+{
+  GtkWidget *infobar;
+  gchar *applied;
+  gchar *text;
+
+  if (changes == NULL)
+    {
+      text = g_strdup_printf (ngettext ("No match found in the translation memory "
+                                        "for the %u untranslated message.",
+                                        "No match found in the translation memory "
+                                        "for the %u untranslated messages.",
+                                        n_untranslated),
+                              n_untranslated);
+    }
+  else
+    {
+      applied = g_strdup_printf (ngettext ("%u of %u untranslated message was "
+                                           "pre-translated from the translation memory",
+                                           "%u of %u untranslated messages were "
+                                           "pre-translated from the translation memory",
+                                           n_untranslated),
+                                 n_exact + n_fuzzy, n_untranslated);
+      text = g_strdup_printf (ngettext ("%s, %u of them is marked as fuzzy.",
+                                        "%s, %u of them are marked as fuzzy.",
+                                        n_fuzzy),
+                              applied, n_fuzzy);
+      g_free (applied);
+    }
+
+  infobar = create_info_bar (text);
+  g_free (text);
+
+  if (changes != NULL)
+    {
+      gtk_info_bar_add_button (GTK_INFO_BAR (infobar), _("_Undo"),
+                               GTK_RESPONSE_REJECT);
+      g_object_set_data_full (G_OBJECT (infobar), CHANGES_DATA, changes,
+                              (GDestroyNotify) changes_free);
+    }
+  gtk_info_bar_add_button (GTK_INFO_BAR (infobar), _("_Close"),
+                           GTK_RESPONSE_CLOSE);
+
+  g_signal_connect (infobar, "response",
+                    G_CALLBACK (summary_response_cb), tab);
+
+  gtk_widget_show (infobar);
+  gtr_tab_set_info_bar (tab, infobar);
+}
+
+static void
+apply_matches (Pretranslation *pt)
+{
+  GList *changes = NULL;
+  guint n_exact = 0;
+  guint n_fuzzy = 0;
+  guint i;
+
+  for (i = 0; i < pt->msgs->len; i++)
+    {
+      GtrMsg *msg = g_ptr_array_index (pt->msgs, i);
+      Change *change;
+
+      if (pt->translations[i] == NULL)
+        continue;
+
+      /* Translated by hand while the lookups were running */
+      if (gtr_msg_is_translated (msg))
+        continue;
+
+      change = g_slice_new (Change);
+      change->msg = g_object_ref (msg);
+      change->translation = g_strdup (pt->translations[i]);
+      change->fuzzy = gtr_msg_is_fuzzy (msg);
+      changes = g_list_prepend (changes, change);
+
+      gtr_msg_set_msgstr (msg, pt->translations[i]);
+      gtr_msg_set_fuzzy (msg, pt->levels[i] < 100);
+
+      if (pt->levels[i] < 100)
+        n_fuzzy++;
+      else
+        n_exact++;
+
+      g_signal_emit_by_name (pt->tab, "message_changed", msg);
+    }
+
+  if (changes != NULL)
+    {
+      gtr_po_set_state (gtr_tab_get_po (pt->tab), GTR_PO_STATE_MODIFIED);
+      refresh_current_message (pt->tab);
+    }
+
+  show_summary (pt->tab, pt->msgs->len, n_exact, n_fuzzy, changes);
+}
+
+static void
+pretranslate_ready_cb (GObject      *source_object,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+  Pretranslation *pt = g_task_get_task_data (G_TASK (result));
+  GError *error = NULL;
+
+  /* The tab was closed */
+  if (pt->tab == NULL)
+    return;
+
+  gtr_tab_set_info_bar (pt->tab, NULL);
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      g_error_free (error);
+      return;
+    }
+
+  apply_matches (pt);
+}
+
+/**
+ * gtr_translation_memory_pretranslate:
+ * @tm: a #GtrTranslationMemory
+ * @tab: the #GtrTab with the catalog to pre-translate
+ * @min_score: minimum level of the matches to apply
+ *
+ * Looks up every untranslated message of the catalog in @tab in @tm, in
+ * parallel, and fills it with the best match if its level is at least
+ * @min_score. Matches below 100 are marked as fuzzy. A summary is shown in
+ * @tab when it finishes, allowing to undo all the changes at once.
+ */
+void
+gtr_translation_memory_pretranslate (GtrTranslationMemory *tm,
+                                     GtrTab               *tab,
+                                     gint                  min_score)
+{
+  Pretranslation *pt;
+  GPtrArray *msgids;
+  GtkWidget *infobar;
+  GTask *task;
+  GList *l;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY (tm));
+  g_return_if_fail (GTR_IS_TAB (tab));
+
+  pt = g_slice_new0 (Pretranslation);
+  pt->tm = g_object_ref (tm);
+  pt->cancellable = g_cancellable_new ();
+  pt->min_score = min_score;
+  pt->msgs = g_ptr_array_new_with_free_func (g_object_unref);
+  msgids = g_ptr_array_new ();
+
+  for (l = gtr_po_get_messages (gtr_tab_get_po (tab)); l != NULL; l = g_list_next (l))
+    {
+      GtrMsg *msg = GTR_MSG (l->data);
+      const gchar *msgid = gtr_msg_get_msgid (msg);
+
+      /* The memory only holds singular messages */
+      if (gtr_msg_is_translated (msg) ||
+          gtr_msg_get_msgid_plural (msg) != NULL ||
+          msgid == NULL || *msgid == '\0')
+        continue;
+
+      g_ptr_array_add (pt->msgs, g_object_ref (msg));
+      g_ptr_array_add (msgids, g_strdup (msgid));
+    }
+  g_ptr_array_add (msgids, NULL);
+
+  pt->msgids = (gchar **) g_ptr_array_free (msgids, FALSE);
+  pt->translations = g_new0 (gchar *, pt->msgs->len);
+  pt->levels = g_new0 (gint, pt->msgs->len);
+
+  pt->tab = tab;
+  g_object_add_weak_pointer (G_OBJECT (tab), (gpointer *) &pt->tab);
+  pt->destroy_id = g_signal_connect_swapped (tab, "destroy",
+                                             G_CALLBACK (g_cancellable_cancel),
+                                             pt->cancellable);
+
+  infobar = create_info_bar (_("Pre-translating the untranslated messages "
+                               "from the translation memory…"));
+  gtk_info_bar_add_button (GTK_INFO_BAR (infobar), _("_Stop"),
+                           GTK_RESPONSE_CANCEL);
+  g_signal_connect_object (infobar, "response",
+                           G_CALLBACK (progress_response_cb),
+                           pt->cancellable, 0);
+  gtk_widget_show (infobar);
+  gtr_tab_set_info_bar (tab, infobar);
+
+  task = g_task_new (NULL, pt->cancellable, pretranslate_ready_cb, NULL);
+  g_task_set_task_data (task, pt, (GDestroyNotify) pretranslation_free);
+  g_task_run_in_thread (task, pretranslate_thread);
+  g_object_unref (task);
+}
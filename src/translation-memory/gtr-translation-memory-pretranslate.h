@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTR_TRANSLATION_MEMORY_PRETRANSLATE_H__
+#define __GTR_TRANSLATION_MEMORY_PRETRANSLATE_H__
+
+#include <glib.h>
+
+#include "gtr-tab.h"
+#include "gtr-translation-memory.h"
+
+G_BEGIN_DECLS
+
+void    gtr_translation_memory_pretranslate     (GtrTranslationMemory *tm,
+                                                 GtrTab               *tab,
+                                                 gint                  min_score);
+
+G_END_DECLS
+
+#endif /* __GTR_TRANSLATION_MEMORY_PRETRANSLATE_H__ */
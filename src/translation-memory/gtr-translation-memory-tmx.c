@@ -0,0 +1,877 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gtr-translation-memory-tmx.h"
+#include "gtr-msg.h"
+
+#include <glib/gi18n.h>
+#include <string.h>
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
+
+/*
+ * TMX files are read with an xmlTextReader and written with an
+ * xmlTextWriter on top of GIO streams, so only the translation unit
+ * being processed is kept in memory whatever the size of the file.
+ *
+ * The imported units are stored in batches with
+ * gtr_translation_memory_store_list(), one transaction per batch.
+ */
+#define IMPORT_BATCH_SIZE 1000
+
+/* Exported units between progress reports */
+#define EXPORT_PROGRESS_INTERVAL 256
+
+/* The msgids of the PO files are in English */
+#define SOURCE_LANGUAGE "en"
+
+typedef struct
+{
+  GFile *file;
+  gchar *language;
+
+  GTask *task;
+  GCancellable *cancellable;
+  GError *error;
+
+  guint n_units;
+
+  /* Progress, reported in the main context of the caller */
+  GMainContext *context;
+  GFileProgressCallback progress_callback;
+  gpointer progress_data;
+  GMutex lock;
+  goffset current;
+  goffset total;
+  guint progress_source;
+  guint finished : 1;
+
+  /* Import */
+  GInputStream *input;
+  goffset n_read;
+  goffset size;
+  gchar *srclang;
+  gchar *unit_srclang;
+  gchar *variant_lang;
+  GPtrArray *variant_langs;
+  GPtrArray *variant_segs;
+
+  po_file_t batch_file;
+  po_message_iterator_t batch_iter;
+  GList *batch;
+  guint batch_len;
+
+  /* Export */
+  GOutputStream *output;
+  xmlTextWriterPtr writer;
+} TmxData;
+
+static void
+tmx_data_free (TmxData *data)
+{
+  g_object_unref (data->file);
+  g_free (data->language);
+  g_clear_error (&data->error);
+
+  g_clear_pointer (&data->context, g_main_context_unref);
+  g_mutex_clear (&data->lock);
+
+  g_clear_object (&data->input);
+  g_free (data->srclang);
+  g_free (data->unit_srclang);
+  g_free (data->variant_lang);
+  g_ptr_array_unref (data->variant_langs);
+  g_ptr_array_unref (data->variant_segs);
+
+  g_list_free_full (data->batch, g_object_unref);
+  if (data->batch_iter != NULL)
+    po_message_iterator_free (data->batch_iter);
+  if (data->batch_file != NULL)
+    po_file_free (data->batch_file);
+
+  g_clear_object (&data->output);
+
+  g_slice_free (TmxData, data);
+}
+
+static TmxData *
+tmx_data_new (GFile                 *file,
+              const gchar           *language,
+              GFileProgressCallback  progress_callback,
+              gpointer               progress_data)
+{
+  TmxData *data;
+
+  data = g_slice_new0 (TmxData);
+  data->file = g_object_ref (file);
+  data->language = g_strdup (language);
+  data->context = g_main_context_ref_thread_default ();
+  data->progress_callback = progress_callback;
+  data->progress_data = progress_data;
+  g_mutex_init (&data->lock);
+  data->variant_langs = g_ptr_array_new_with_free_func (g_free);
+  data->variant_segs = g_ptr_array_new_with_free_func (g_free);
+
+  return data;
+}
+
+static gboolean
+dispatch_progress (gpointer user_data)
+{
+  TmxData *data = g_task_get_task_data (G_TASK (user_data));
+  goffset current, total;
+  gboolean finished;
+
+  g_mutex_lock (&data->lock);
+  data->progress_source = 0;
+  current = data->current;
+  total = data->total;
+  finished = data->finished;
+  g_mutex_unlock (&data->lock);
+
+  /* The caller may be gone once the result is delivered */
+  if (!finished)
+    data->progress_callback (current, total, data->progress_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Can be called from any thread, the reports are coalesced until the
+ * main context of the caller dispatches them */
+static void
+report_progress (TmxData *data,
+                 goffset  current,
+                 goffset  total)
+{
+  GSource *source;
+
+  if (data->progress_callback == NULL)
+    return;
+
+  g_mutex_lock (&data->lock);
+
+  data->current = current;
+  data->total = total;
+
+  if (data->progress_source == 0)
+    {
+      source = g_idle_source_new ();
+      g_source_set_priority (source, G_PRIORITY_DEFAULT);
+      g_source_set_callback (source, dispatch_progress,
+                             g_object_ref (data->task), g_object_unref);
+      data->progress_source = g_source_attach (source, data->context);
+      g_source_unref (source);
+    }
+
+  g_mutex_unlock (&data->lock);
+}
+
+static void
+return_result (TmxData *data)
+{
+  g_mutex_lock (&data->lock);
+  data->finished = TRUE;
+  g_mutex_unlock (&data->lock);
+
+  if (data->error != NULL)
+    {
+      g_task_return_error (data->task, data->error);
+      data->error = NULL;
+    }
+  else if (!g_task_return_error_if_cancelled (data->task))
+    g_task_return_boolean (data->task, TRUE);
+}
+
+/*
+ * Compares two language tags, "pt_BR" and "pt-BR" being the same. If
+ * @primary is %TRUE only the primary language subtags are compared.
+ */
+static gboolean
+language_equal (const gchar *a,
+                const gchar *b,
+                gboolean     primary)
+{
+  for (;; a++, b++)
+    {
+      gchar ca = *a == '_' ? '-' : g_ascii_tolower (*a);
+      gchar cb = *b == '_' ? '-' : g_ascii_tolower (*b);
+      gboolean end_a = ca == '\0' || ca == '@' || (primary && ca == '-');
+      gboolean end_b = cb == '\0' || cb == '@' || (primary && cb == '-');
+
+      if (end_a || end_b)
+        return end_a && end_b;
+
+      if (ca != cb)
+        return FALSE;
+    }
+}
+
+/* 2 if @lang is @wanted, 1 if only the primary language is the same or
+ * any language is wanted, 0 otherwise */
+static gint
+language_score (const gchar *lang,
+                const gchar *wanted)
+{
+  if (wanted == NULL || *wanted == '\0' ||
+      g_ascii_strcasecmp (wanted, "*all*") == 0)
+    return 1;
+
+  if (lang == NULL)
+    return 0;
+
+  if (language_equal (lang, wanted, FALSE))
+    return 2;
+
+  return language_equal (lang, wanted, TRUE) ? 1 : 0;
+}
+
+/***************************** Import ***********************************/
+
+static gchar *
+get_attribute (xmlTextReaderPtr  reader,
+               const gchar      *name)
+{
+  xmlChar *value;
+  gchar *result;
+
+  value = xmlTextReaderGetAttribute (reader, BAD_CAST name);
+  result = g_strdup ((const gchar *) value);
+  xmlFree (value);
+
+  return result;
+}
+
+/* TMX 1.1 used a lang attribute instead of xml:lang */
+static gchar *
+get_language (xmlTextReaderPtr reader)
+{
+  xmlChar *value;
+  gchar *result;
+
+  value = xmlTextReaderGetAttributeNs (reader, BAD_CAST "lang", XML_XML_NAMESPACE);
+  if (value == NULL)
+    return get_attribute (reader, "lang");
+
+  result = g_strdup ((const gchar *) value);
+  xmlFree (value);
+
+  return result;
+}
+
+/* Returns the text of the segment the reader is at, including the native
+ * codes of the inline elements, and leaves the reader at its end */
+static gchar *
+read_segment (xmlTextReaderPtr reader)
+{
+  GString *text;
+  gint depth;
+
+  text = g_string_new (NULL);
+
+  if (xmlTextReaderIsEmptyElement (reader))
+    return g_string_free (text, FALSE);
+
+  depth = xmlTextReaderDepth (reader);
+
+  while (xmlTextReaderRead (reader) == 1)
+    {
+      gint type = xmlTextReaderNodeType (reader);
+
+      if (type == XML_READER_TYPE_END_ELEMENT &&
+          xmlTextReaderDepth (reader) == depth)
+        break;
+
+      if (type == XML_READER_TYPE_TEXT ||
+          type == XML_READER_TYPE_CDATA ||
+          type == XML_READER_TYPE_WHITESPACE ||
+          type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE)
+        g_string_append (text, (const gchar *) xmlTextReaderConstValue (reader));
+    }
+
+  return g_string_free (text, FALSE);
+}
+
+static gboolean
+flush_batch (GtrTranslationMemory *tm,
+             TmxData              *data)
+{
+  gboolean stored;
+
+  if (data->batch == NULL)
+    return TRUE;
+
+  data->batch = g_list_reverse (data->batch);
+  stored = gtr_translation_memory_store_list (tm, data->batch);
+  if (stored)
+    data->n_units += data->batch_len;
+  else if (data->error == NULL)
+    g_set_error_literal (&data->error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                         _("Could not store the messages in the translation memory"));
+
+  g_list_free_full (data->batch, g_object_unref);
+  data->batch = NULL;
+  data->batch_len = 0;
+
+  po_message_iterator_free (data->batch_iter);
+  data->batch_iter = NULL;
+  po_file_free (data->batch_file);
+  data->batch_file = NULL;
+
+  return stored;
+}
+
+static void
+add_unit (GtrTranslationMemory *tm,
+          TmxData              *data,
+          const gchar          *original,
+          const gchar          *translation)
+{
+  po_message_t message;
+
+  /* The messages of a batch live in a scratch PO file */
+  if (data->batch_file == NULL)
+    {
+      data->batch_file = po_file_create ();
+      data->batch_iter = po_message_iterator (data->batch_file, NULL);
+    }
+
+  message = po_message_create ();
+  po_message_set_msgid (message, original);
+  po_message_set_msgstr (message, translation);
+  po_message_insert (data->batch_iter, message);
+
+  data->batch = g_list_prepend (data->batch, _gtr_msg_new (NULL, message));
+
+  if (++data->batch_len >= IMPORT_BATCH_SIZE)
+    flush_batch (tm, data);
+}
+
+static void
+begin_unit (TmxData          *data,
+            xmlTextReaderPtr  reader)
+{
+  g_free (data->unit_srclang);
+  data->unit_srclang = get_attribute (reader, "srclang");
+
+  g_ptr_array_set_size (data->variant_langs, 0);
+  g_ptr_array_set_size (data->variant_segs, 0);
+}
+
+/*
+ * Picks the source variant, in the language of the unit or the header,
+ * and the variant closest to the target language.
+ */
+static void
+end_unit (GtrTranslationMemory *tm,
+          TmxData              *data)
+{
+  const gchar *srclang;
+  gint source = -1;
+  gint target = -1;
+  gint best = 0;
+  guint i;
+
+  if (data->variant_segs->len < 2)
+    return;
+
+  srclang = data->unit_srclang != NULL ? data->unit_srclang : data->srclang;
+
+  for (i = 0; i < data->variant_langs->len && source < 0; i++)
+    if (language_score (g_ptr_array_index (data->variant_langs, i), srclang) > 0)
+      source = i;
+
+  if (source < 0)
+    source = 0;
+
+  for (i = 0; i < data->variant_langs->len; i++)
+    {
+      gint score;
+
+      if ((gint) i == source)
+        continue;
+
+      score = language_score (g_ptr_array_index (data->variant_langs, i),
+                              data->language);
+      if (score > best)
+        {
+          best = score;
+          target = i;
+        }
+    }
+
+  if (target < 0 ||
+      *(const gchar *) g_ptr_array_index (data->variant_segs, source) == '\0' ||
+      *(const gchar *) g_ptr_array_index (data->variant_segs, target) == '\0')
+    return;
+
+  add_unit (tm, data,
+            g_ptr_array_index (data->variant_segs, source),
+            g_ptr_array_index (data->variant_segs, target));
+}
+
+static int
+read_cb (void *context,
+         char *buffer,
+         int   len)
+{
+  TmxData *data = context;
+  gssize n_read;
+
+  if (data->error != NULL)
+    return -1;
+
+  n_read = g_input_stream_read (data->input, buffer, len,
+                                data->cancellable, &data->error);
+  if (n_read < 0)
+    return -1;
+
+  data->n_read += n_read;
+  report_progress (data, data->n_read, data->size);
+
+  return n_read;
+}
+
+static int
+close_cb (void *context)
+{
+  /* The streams are closed by their owner */
+  return 0;
+}
+
+static void
+reader_error_cb (void                   *arg,
+                 const char             *msg,
+                 xmlParserSeverities     severity,
+                 xmlTextReaderLocatorPtr locator)
+{
+  TmxData *data = arg;
+  gchar *message;
+
+  if (data->error != NULL ||
+      (severity != XML_PARSER_SEVERITY_ERROR &&
+       severity != XML_PARSER_SEVERITY_VALIDITY_ERROR))
+    return;
+
+  message = g_strchomp (g_strdup (msg));
+  g_set_error (&data->error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+               _("Line %d: %s"),
+               xmlTextReaderLocatorLineNumber (locator), message);
+  g_free (message);
+}
+
+static void
+import_thread (GTask                *task,
+               GtrTranslationMemory *tm,
+               TmxData              *data,
+               GCancellable         *cancellable)
+{
+  xmlTextReaderPtr reader;
+  GFileInfo *info;
+  gboolean seen_root = FALSE;
+  gchar *uri;
+  gint ret = 1;
+
+  data->input = G_INPUT_STREAM (g_file_read (data->file, cancellable,
+                                             &data->error));
+  if (data->input == NULL)
+    {
+      return_result (data);
+      return;
+    }
+
+  info = g_file_input_stream_query_info (G_FILE_INPUT_STREAM (data->input),
+                                         G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                         cancellable, NULL);
+  if (info != NULL)
+    {
+      data->size = g_file_info_get_size (info);
+      g_object_unref (info);
+    }
+
+  uri = g_file_get_uri (data->file);
+  reader = xmlReaderForIO (read_cb, close_cb, data, uri, NULL, XML_PARSE_NONET);
+  g_free (uri);
+
+  if (reader == NULL)
+    {
+      g_set_error_literal (&data->error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           _("Could not read the TMX file"));
+      g_input_stream_close (data->input, NULL, NULL);
+      return_result (data);
+      return;
+    }
+
+  xmlTextReaderSetErrorHandler (reader, reader_error_cb, data);
+
+  while (data->error == NULL &&
+         !g_cancellable_is_cancelled (cancellable) &&
+         (ret = xmlTextReaderRead (reader)) == 1)
+    {
+      gint type = xmlTextReaderNodeType (reader);
+      const gchar *name = (const gchar *) xmlTextReaderConstLocalName (reader);
+
+      if (type == XML_READER_TYPE_ELEMENT)
+        {
+          if (!seen_root)
+            {
+              seen_root = TRUE;
+
+              if (g_strcmp0 (name, "tmx") != 0)
+                g_set_error_literal (&data->error, G_IO_ERROR,
+                                     G_IO_ERROR_INVALID_DATA,
+                                     _("The file is not a TMX document"));
+            }
+          else if (g_strcmp0 (name, "header") == 0)
+            {
+              g_free (data->srclang);
+              data->srclang = get_attribute (reader, "srclang");
+            }
+          else if (g_strcmp0 (name, "tu") == 0)
+            begin_unit (data, reader);
+          else if (g_strcmp0 (name, "tuv") == 0)
+            {
+              g_free (data->variant_lang);
+              data->variant_lang = get_language (reader);
+            }
+          else if (g_strcmp0 (name, "seg") == 0)
+            {
+              g_ptr_array_add (data->variant_langs, g_strdup (data->variant_lang));
+              g_ptr_array_add (data->variant_segs, read_segment (reader));
+            }
+        }
+      else if (type == XML_READER_TYPE_END_ELEMENT &&
+               g_strcmp0 (name, "tu") == 0)
+        end_unit (tm, data);
+    }
+
+  if (ret < 0 && data->error == NULL && !g_cancellable_is_cancelled (cancellable))
+    g_set_error_literal (&data->error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                         _("The TMX file is not well formed"));
+
+  /* A cancelled import keeps the batches already stored */
+  if (data->error == NULL && !g_cancellable_is_cancelled (cancellable))
+    flush_batch (tm, data);
+
+  xmlFreeTextReader (reader);
+  g_input_stream_close (data->input, NULL, NULL);
+
+  return_result (data);
+}
+
+/**
+ * gtr_translation_memory_import_tmx_async:
+ * @tm: a #GtrTranslationMemory
+ * @file: the TMX file to import
+ * @language: (nullable): the language of the translations to import
+ * @cancellable: (nullable): a #GCancellable
+ * @progress_callback: (nullable): function called with the bytes read
+ * @progress_data: data for @progress_callback
+ * @callback: called when the import finishes
+ * @user_data: data for @callback
+ *
+ * Stores the translation units of @file in @tm. The variant in the source
+ * language of the file is used as original and the variant in @language,
+ * or the first other variant if @language is %NULL, as translation.
+ *
+ * The file is parsed as a stream, so its size does not matter. The
+ * progress is reported in the thread-default main context of the caller.
+ */
+void
+gtr_translation_memory_import_tmx_async (GtrTranslationMemory  *tm,
+                                         GFile                 *file,
+                                         const gchar           *language,
+                                         GCancellable          *cancellable,
+                                         GFileProgressCallback  progress_callback,
+                                         gpointer               progress_data,
+                                         GAsyncReadyCallback    callback,
+                                         gpointer               user_data)
+{
+  TmxData *data;
+  GTask *task;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY (tm));
+  g_return_if_fail (G_IS_FILE (file));
+
+  task = g_task_new (tm, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_translation_memory_import_tmx_async);
+
+  data = tmx_data_new (file, language, progress_callback, progress_data);
+  data->task = task;
+  data->cancellable = cancellable;
+  g_task_set_task_data (task, data, (GDestroyNotify) tmx_data_free);
+
+  g_task_run_in_thread (task, (GTaskThreadFunc) import_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gtr_translation_memory_import_tmx_finish:
+ * @tm: a #GtrTranslationMemory
+ * @result: the #GAsyncResult
+ * @n_units: (out) (optional): return location for the number of units stored
+ * @error: a #GError or %NULL
+ *
+ * Finishes an import started with gtr_translation_memory_import_tmx_async().
+ * The units stored before an error or a cancellation are kept, and counted
+ * in @n_units.
+ *
+ * Returns: %TRUE if the whole file was imported
+ */
+gboolean
+gtr_translation_memory_import_tmx_finish (GtrTranslationMemory  *tm,
+                                          GAsyncResult          *result,
+                                          guint                 *n_units,
+                                          GError               **error)
+{
+  TmxData *data;
+
+  g_return_val_if_fail (g_task_is_valid (result, tm), FALSE);
+
+  data = g_task_get_task_data (G_TASK (result));
+  if (n_units != NULL)
+    *n_units = data->n_units;
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/***************************** Export ***********************************/
+
+/* xml:lang wants a BCP 47 tag, "pt-BR" instead of "pt_BR" */
+static gchar *
+language_tag (const gchar *language)
+{
+  gchar *tag;
+  gchar *p;
+
+  if (language == NULL || *language == '\0')
+    return g_strdup ("und");
+
+  tag = g_strdup (language);
+  g_strdelimit (tag, "_", '-');
+
+  p = strchr (tag, '@');
+  if (p != NULL)
+    *p = '\0';
+
+  return tag;
+}
+
+static int
+write_cb (void       *context,
+          const char *buffer,
+          int         len)
+{
+  TmxData *data = context;
+
+  if (data->error != NULL)
+    return -1;
+
+  if (!g_output_stream_write_all (data->output, buffer, len, NULL,
+                                  data->cancellable, &data->error))
+    return -1;
+
+  return len;
+}
+
+static gboolean
+write_variant (xmlTextWriterPtr  writer,
+               const gchar      *language,
+               const gchar      *text)
+{
+  return xmlTextWriterStartElement (writer, BAD_CAST "tuv") >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "xml:lang",
+                                      BAD_CAST language) >= 0 &&
+         xmlTextWriterWriteElement (writer, BAD_CAST "seg", BAD_CAST text) >= 0 &&
+         xmlTextWriterEndElement (writer) >= 0;
+}
+
+static gboolean
+export_unit (const gchar *original,
+             const gchar *translation,
+             gpointer     user_data)
+{
+  TmxData *data = user_data;
+
+  if (data->error != NULL || g_cancellable_is_cancelled (data->cancellable))
+    return FALSE;
+
+  if (xmlTextWriterStartElement (data->writer, BAD_CAST "tu") < 0 ||
+      !write_variant (data->writer, SOURCE_LANGUAGE, original) ||
+      !write_variant (data->writer, data->language, translation) ||
+      xmlTextWriterEndElement (data->writer) < 0)
+    {
+      if (data->error == NULL)
+        g_set_error_literal (&data->error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             _("Could not write the TMX file"));
+      return FALSE;
+    }
+
+  if (++data->n_units % EXPORT_PROGRESS_INTERVAL == 0)
+    report_progress (data, data->n_units, 0);
+
+  return TRUE;
+}
+
+static gboolean
+write_header (xmlTextWriterPtr writer)
+{
+  return xmlTextWriterStartDocument (writer, NULL, "UTF-8", NULL) >= 0 &&
+         xmlTextWriterStartElement (writer, BAD_CAST "tmx") >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "version", BAD_CAST "1.4") >= 0 &&
+         xmlTextWriterStartElement (writer, BAD_CAST "header") >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "creationtool", BAD_CAST "Gtranslator") >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "creationtoolversion", BAD_CAST PACKAGE_VERSION) >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "segtype", BAD_CAST "sentence") >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "o-tmf", BAD_CAST "Gtranslator") >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "adminlang", BAD_CAST SOURCE_LANGUAGE) >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "srclang", BAD_CAST SOURCE_LANGUAGE) >= 0 &&
+         xmlTextWriterWriteAttribute (writer, BAD_CAST "datatype", BAD_CAST "PlainText") >= 0 &&
+         xmlTextWriterEndElement (writer) >= 0 &&
+         xmlTextWriterStartElement (writer, BAD_CAST "body") >= 0;
+}
+
+static void
+export_thread (GTask                *task,
+               GtrTranslationMemory *tm,
+               TmxData              *data,
+               GCancellable         *cancellable)
+{
+  xmlOutputBufferPtr buffer;
+  gboolean written;
+
+  data->output = G_OUTPUT_STREAM (g_file_replace (data->file, NULL, FALSE,
+                                                  G_FILE_CREATE_NONE,
+                                                  cancellable, &data->error));
+  if (data->output == NULL)
+    {
+      return_result (data);
+      return;
+    }
+
+  buffer = xmlOutputBufferCreateIO (write_cb, close_cb, data, NULL);
+  data->writer = xmlNewTextWriter (buffer);
+  xmlTextWriterSetIndent (data->writer, 1);
+  xmlTextWriterSetIndentString (data->writer, BAD_CAST "  ");
+
+  written = write_header (data->writer);
+  if (written)
+    gtr_translation_memory_foreach (tm, export_unit, data);
+
+  written = written &&
+            data->error == NULL &&
+            !g_cancellable_is_cancelled (cancellable) &&
+            xmlTextWriterEndDocument (data->writer) >= 0;
+
+  /* Also flushes and closes the buffer */
+  xmlFreeTextWriter (data->writer);
+  data->writer = NULL;
+
+  if (!written && data->error == NULL && !g_cancellable_is_cancelled (cancellable))
+    g_set_error_literal (&data->error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                         _("Could not write the TMX file"));
+
+  if (data->error == NULL && !g_cancellable_is_cancelled (cancellable))
+    g_output_stream_close (data->output, cancellable, &data->error);
+  else
+    {
+      GCancellable *abort = g_cancellable_new ();
+
+      /* Closing a cancelled stream leaves the previous file in place */
+      g_cancellable_cancel (abort);
+      g_output_stream_close (data->output, abort, NULL);
+      g_object_unref (abort);
+    }
+
+  return_result (data);
+}
+
+/**
+ * gtr_translation_memory_export_tmx_async:
+ * @tm: a #GtrTranslationMemory
+ * @file: the TMX file to write
+ * @language: (nullable): the language of the translations in @tm
+ * @cancellable: (nullable): a #GCancellable
+ * @progress_callback: (nullable): function called with the units written
+ * @progress_data: data for @progress_callback
+ * @callback: called when the export finishes
+ * @user_data: data for @callback
+ *
+ * Writes every translation stored in @tm to @file, as TMX 1.4 units with
+ * an English variant and one in @language. The entries are streamed from
+ * the database to the file, and @file is only replaced if the export
+ * succeeds. The total passed to @progress_callback is always 0.
+ */
+void
+gtr_translation_memory_export_tmx_async (GtrTranslationMemory  *tm,
+                                         GFile                 *file,
+                                         const gchar           *language,
+                                         GCancellable          *cancellable,
+                                         GFileProgressCallback  progress_callback,
+                                         gpointer               progress_data,
+                                         GAsyncReadyCallback    callback,
+                                         gpointer               user_data)
+{
+  TmxData *data;
+  GTask *task;
+
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY (tm));
+  g_return_if_fail (G_IS_FILE (file));
+
+  task = g_task_new (tm, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtr_translation_memory_export_tmx_async);
+
+  data = tmx_data_new (file, NULL, progress_callback, progress_data);
+  data->language = language_tag (language);
+  data->task = task;
+  data->cancellable = cancellable;
+  g_task_set_task_data (task, data, (GDestroyNotify) tmx_data_free);
+
+  g_task_run_in_thread (task, (GTaskThreadFunc) export_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gtr_translation_memory_export_tmx_finish:
+ * @tm: a #GtrTranslationMemory
+ * @result: the #GAsyncResult
+ * @n_units: (out) (optional): return location for the number of units written
+ * @error: a #GError or %NULL
+ *
+ * Finishes an export started with gtr_translation_memory_export_tmx_async().
+ *
+ * Returns: %TRUE if the file was written
+ */
+gboolean
+gtr_translation_memory_export_tmx_finish (GtrTranslationMemory  *tm,
+                                          GAsyncResult          *result,
+                                          guint                 *n_units,
+                                          GError               **error)
+{
+  TmxData *data;
+
+  g_return_val_if_fail (g_task_is_valid (result, tm), FALSE);
+
+  data = g_task_get_task_data (G_TASK (result));
+  if (n_units != NULL)
+    *n_units = data->n_units;
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTR_TRANSLATION_MEMORY_TMX_H__
+#define __GTR_TRANSLATION_MEMORY_TMX_H__
+
+#include <gio/gio.h>
+
+#include "gtr-translation-memory.h"
+
+G_BEGIN_DECLS
+
+void            gtr_translation_memory_import_tmx_async  (GtrTranslationMemory   *tm,
+                                                          GFile                  *file,
+                                                          const gchar            *language,
+                                                          GCancellable           *cancellable,
+                                                          GFileProgressCallback   progress_callback,
+                                                          gpointer                progress_data,
+                                                          GAsyncReadyCallback     callback,
+                                                          gpointer                user_data);
+
+gboolean        gtr_translation_memory_import_tmx_finish (GtrTranslationMemory   *tm,
+                                                          GAsyncResult           *result,
+                                                          guint                  *n_units,
+                                                          GError                **error);
+
+void            gtr_translation_memory_export_tmx_async  (GtrTranslationMemory   *tm,
+                                                          GFile                  *file,
+                                                          const gchar            *language,
+                                                          GCancellable           *cancellable,
+                                                          GFileProgressCallback   progress_callback,
+                                                          gpointer                progress_data,
+                                                          GAsyncReadyCallback     callback,
+                                                          gpointer                user_data);
+
+gboolean        gtr_translation_memory_export_tmx_finish (GtrTranslationMemory   *tm,
+                                                          GAsyncResult           *result,
+                                                          guint                  *n_units,
+                                                          GError                **error);
+
+G_END_DECLS
+
+#endif /* __GTR_TRANSLATION_MEMORY_TMX_H__ */
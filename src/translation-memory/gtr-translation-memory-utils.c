@@ -31,6 +31,202 @@
 #include <gtk/gtk.h>
 
 
+#define SCAN_DIR_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                            G_FILE_ATTRIBUTE_ID_FILE
+
+typedef struct
+{
+  GThreadPool *pool;
+
+  GMutex lock;
+  GCond cond;
+
+  /* Directories queued or being walked */
+  guint pending;
+  /* Identifiers of the directories already queued, to break symlink loops */
+  GHashTable *visited;
+
+  gchar *suffix;
+  GCancellable *cancellable;
+  GtrScanDirFunc func;
+  gpointer user_data;
+} ScanDir;
+
+/* Must be called with the lock held */
+static gboolean
+scan_dir_mark_visited (ScanDir     *scan,
+                       const gchar *id)
+{
+  /* Not every backend provides an identifier */
+  if (id == NULL)
+    return TRUE;
+
+  if (g_hash_table_contains (scan->visited, id))
+    return FALSE;
+
+  g_hash_table_add (scan->visited, g_strdup (id));
+  return TRUE;
+}
+
+static void
+scan_dir_job (gpointer data,
+              gpointer user_data)
+{
+  GFile *dir = G_FILE (data);
+  ScanDir *scan = (ScanDir *) user_data;
+  GFileEnumerator *enumerator;
+  GFileInfo *info;
+  GError *error = NULL;
+
+  enumerator = g_file_enumerate_children (dir,
+                                          SCAN_DIR_ATTRIBUTES,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          scan->cancellable, &error);
+  if (enumerator)
+    {
+      while ((info = g_file_enumerator_next_file (enumerator,
+                                                  scan->cancellable,
+                                                  &error)) != NULL)
+        {
+          const gchar *name = g_file_info_get_name (info);
+          GFile *child;
+
+          switch (g_file_info_get_file_type (info))
+            {
+            case G_FILE_TYPE_DIRECTORY:
+              g_mutex_lock (&scan->lock);
+              if (scan_dir_mark_visited (scan,
+                                         g_file_info_get_attribute_string (info,
+                                                                           G_FILE_ATTRIBUTE_ID_FILE)))
+                {
+                  scan->pending++;
+                  g_thread_pool_push (scan->pool, g_file_get_child (dir, name), NULL);
+                }
+              g_mutex_unlock (&scan->lock);
+              break;
+
+            case G_FILE_TYPE_REGULAR:
+              if (g_str_has_suffix (name, scan->suffix))
+                {
+                  child = g_file_get_child (dir, name);
+
+                  g_mutex_lock (&scan->lock);
+                  scan->func (child, scan->user_data);
+                  g_mutex_unlock (&scan->lock);
+
+                  g_object_unref (child);
+                }
+              break;
+
+            default:
+              break;
+            }
+
+          g_object_unref (info);
+        }
+
+      g_file_enumerator_close (enumerator, NULL, NULL);
+      g_object_unref (enumerator);
+    }
+
+  if (error)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("%s", error->message);
+      g_error_free (error);
+    }
+
+  g_object_unref (dir);
+
+  g_mutex_lock (&scan->lock);
+  if (--scan->pending == 0)
+    g_cond_signal (&scan->cond);
+  g_mutex_unlock (&scan->lock);
+}
+
+/**
+ * gtr_scan_dir_foreach:
+ * @dir: the dir to parse
+ * @po_name: the name of the specific po file to search or %NULL.
+ * @cancellable: (nullable): a #GCancellable
+ * @func: function called for each file found
+ * @user_data: data for @func
+ *
+ * Scans the directory and subdirectories of @dir looking for filenames ended
+ * with .po or files that matches @po_name. The subdirectories are walked
+ * concurrently and @func is called as soon as a file is found, from one of
+ * the scanning threads; calls to @func are serialized. Symbolic links to
+ * directories are followed once. This function blocks until the whole tree
+ * has been walked or @cancellable is cancelled.
+ */
+void
+gtr_scan_dir_foreach (GFile          *dir,
+                      const gchar    *po_name,
+                      GCancellable   *cancellable,
+                      GtrScanDirFunc  func,
+                      gpointer        user_data)
+{
+  ScanDir scan;
+  GFileInfo *info;
+
+  g_return_if_fail (G_IS_FILE (dir));
+  g_return_if_fail (func != NULL);
+
+  if (po_name != NULL)
+    {
+      if (g_str_has_suffix (po_name, ".po"))
+        scan.suffix = g_strdup (po_name);
+      else
+        scan.suffix = g_strconcat (po_name, ".po", NULL);
+    }
+  else
+    scan.suffix = g_strdup (".po");
+
+  g_mutex_init (&scan.lock);
+  g_cond_init (&scan.cond);
+  scan.visited = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  scan.cancellable = cancellable;
+  scan.func = func;
+  scan.user_data = user_data;
+
+  info = g_file_query_info (dir, G_FILE_ATTRIBUTE_ID_FILE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (info != NULL)
+    {
+      scan_dir_mark_visited (&scan,
+                             g_file_info_get_attribute_string (info,
+                                                               G_FILE_ATTRIBUTE_ID_FILE));
+      g_object_unref (info);
+    }
+
+  scan.pool = g_thread_pool_new (scan_dir_job, &scan,
+                                 g_get_num_processors (),
+                                 FALSE, NULL);
+
+  g_mutex_lock (&scan.lock);
+  scan.pending = 1;
+  g_thread_pool_push (scan.pool, g_object_ref (dir), NULL);
+
+  while (scan.pending > 0)
+    g_cond_wait (&scan.cond, &scan.lock);
+  g_mutex_unlock (&scan.lock);
+
+  g_thread_pool_free (scan.pool, FALSE, TRUE);
+
+  g_hash_table_unref (scan.visited);
+  g_mutex_clear (&scan.lock);
+  g_cond_clear (&scan.cond);
+  g_free (scan.suffix);
+}
+
+static void
+prepend_file (GFile  *file,
+              GSList **list)
+{
+  *list = g_slist_prepend (*list, g_object_ref (file));
+}
+
 /**
  * gtr_scan_dir:
  * @dir: the dir to parse
@@ -44,53 +240,66 @@
 void
 gtr_scan_dir (GFile * dir, GSList ** list, const gchar * po_name)
 {
-  GFileInfo *info;
-  GError *error;
-  GFile *file;
-  GFileEnumerator *enumerator;
+  gtr_scan_dir_foreach (dir, po_name, NULL,
+                        (GtrScanDirFunc) prepend_file, list);
+}
 
-  error = NULL;
-  enumerator = g_file_enumerate_children (dir,
-                                          G_FILE_ATTRIBUTE_STANDARD_NAME,
-                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                          NULL, &error);
-  if (enumerator)
-    {
-      error = NULL;
+/**
+ * gtr_translation_memory_utils_entry_digest:
+ * @original: the original message
+ * @translation: its translation
+ *
+ * Computes a digest identifying the pair @original, @translation. It is used
+ * to remember which entries of an imported file are already stored.
+ *
+ * Returns: a newly allocated string
+ */
+gchar *
+gtr_translation_memory_utils_entry_digest (const gchar *original,
+                                           const gchar *translation)
+{
+  GChecksum *checksum;
+  gchar *digest;
 
-      while ((info =
-              g_file_enumerator_next_file (enumerator, NULL, &error)) != NULL)
-        {
-          const gchar *name;
-          gchar *filename;
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  g_checksum_update (checksum, (const guchar *) original, -1);
+  g_checksum_update (checksum, (const guchar *) "\004", 1);
+  g_checksum_update (checksum, (const guchar *) translation, -1);
+  digest = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
 
-          name = g_file_info_get_name (info);
-          file = g_file_get_child (dir, name);
+  return digest;
+}
 
-          if (po_name != NULL)
-            {
-              if (g_str_has_suffix (po_name, ".po"))
-                filename = g_strdup (po_name);
-              else
-                filename = g_strconcat (po_name, ".po", NULL);
-            }
-          else
-            filename = g_strdup (".po");
+/**
+ * gtr_translation_memory_utils_database_name:
+ * @language: (nullable): a language code, like "pt_BR"
+ *
+ * Gets the name, without extension, of the database file holding the
+ * translations to @language. Each language is kept in its own database so
+ * the lookups only search the translations to the language being edited.
+ * The translations without a known language are kept in the database that
+ * was shared by every language before, whose matches are still shown for
+ * every language.
+ *
+ * Returns: a newly allocated string
+ */
+gchar *
+gtr_translation_memory_utils_database_name (const gchar *language)
+{
+  gchar *canon;
+  gchar *name;
 
-          if (g_str_has_suffix (name, filename))
-            *list = g_slist_prepend (*list, file);
-          g_free (filename);
+  if (language == NULL || *language == '\0')
+    return g_strdup ("translation-memory");
 
-          gtr_scan_dir (file, list, po_name);
-          g_object_unref (info);
-        }
-      g_file_enumerator_close (enumerator, NULL, NULL);
-      g_object_unref (enumerator);
+  /* Language codes are like "sr@latin", anything else can't be in a path */
+  canon = g_strcanon (g_strdup (language),
+                      "abcdefghijklmnopqrstuvwxyz"
+                      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                      "0123456789_@-", '_');
+  name = g_strconcat ("translation-memory-", canon, NULL);
+  g_free (canon);
 
-      if (error)
-        {
-          g_warning ("%s", error->message);
-        }
-    }
+  return name;
 }
-
@@ -26,8 +26,27 @@
 #include <gtk/gtk.h>
 #include <gio/gio.h>
 
-void    gtr_scan_dir    (GFile         *dir,
-                         GSList       **list,
-                         const gchar   *po_name);
+/* Stored in the user_version of a database once every original has its
+ * words indexed. GtrSqlite resets it while it writes in full text search
+ * mode, which doesn't maintain the word tables. */
+#define GTR_TRANSLATION_MEMORY_WORD_INDEX_VERSION 1
+
+typedef void (*GtrScanDirFunc) (GFile    *file,
+                                gpointer  user_data);
+
+void    gtr_scan_dir            (GFile          *dir,
+                                 GSList        **list,
+                                 const gchar    *po_name);
+
+void    gtr_scan_dir_foreach    (GFile          *dir,
+                                 const gchar    *po_name,
+                                 GCancellable   *cancellable,
+                                 GtrScanDirFunc  func,
+                                 gpointer        user_data);
+
+gchar  *gtr_translation_memory_utils_entry_digest (const gchar *original,
+                                                   const gchar *translation);
+
+gchar  *gtr_translation_memory_utils_database_name (const gchar *language);
 
 #endif
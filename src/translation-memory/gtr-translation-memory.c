@@ -107,6 +107,9 @@ gtr_translation_memory_remove_default (GtrTranslationMemory * obj,
  * @phrase: the unstranslated text to search for translations.
  *
  * Looks for the @phrase in the database and gets a list of the #GtrTranslationMemoryMatch.
+ * On the thread running the default main context nothing is found until
+ * the database is open, see gtr_translation_memory_is_open(), other threads
+ * wait for it.
  *
  * Returns: a list of #GtrTranslationMemoryMatch.
  */
@@ -188,6 +191,212 @@ gtr_translation_memory_set_max_items_default (GtrTranslationMemory * obj, gint i
   g_return_if_reached ();
 }
 
+/**
+ * gtr_translation_memory_get_file_stamp:
+ * @obj: a #GtrTranslationMemory
+ * @path: the path of a PO file
+ * @size: (out): return location for the size of the file
+ * @mtime: (out): return location for the modification time of the file
+ * @hash: (out): return location for the content hash of the file
+ *
+ * Gets the stamp recorded the last time @path was imported with
+ * gtr_translation_memory_store_file(). @hash must be freed with g_free().
+ *
+ * Returns: %TRUE if @path was imported before
+ */
+gboolean
+gtr_translation_memory_get_file_stamp (GtrTranslationMemory * obj,
+                                       const gchar * path,
+                                       goffset * size,
+                                       gint64 * mtime,
+                                       gchar ** hash)
+{
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY (obj), FALSE);
+  return GTR_TRANSLATION_MEMORY_GET_IFACE (obj)->get_file_stamp (obj, path,
+                                                                 size, mtime,
+                                                                 hash);
+}
+
+/* Default implementation */
+static gboolean
+gtr_translation_memory_get_file_stamp_default (GtrTranslationMemory * obj,
+                                               const gchar * path,
+                                               goffset * size,
+                                               gint64 * mtime,
+                                               gchar ** hash)
+{
+  return FALSE;
+}
+
+/**
+ * gtr_translation_memory_set_file_stamp:
+ * @obj: a #GtrTranslationMemory
+ * @path: the path of a PO file
+ * @size: the size of the file
+ * @mtime: the modification time of the file
+ * @hash: the content hash of the file
+ *
+ * Updates the stamp of an already imported file whose content did not
+ * change, so the next import can skip it without hashing it.
+ */
+gboolean
+gtr_translation_memory_set_file_stamp (GtrTranslationMemory * obj,
+                                       const gchar * path,
+                                       goffset size,
+                                       gint64 mtime,
+                                       const gchar * hash)
+{
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY (obj), FALSE);
+  return GTR_TRANSLATION_MEMORY_GET_IFACE (obj)->set_file_stamp (obj, path,
+                                                                 size, mtime,
+                                                                 hash);
+}
+
+/* Default implementation */
+static gboolean
+gtr_translation_memory_set_file_stamp_default (GtrTranslationMemory * obj,
+                                               const gchar * path,
+                                               goffset size,
+                                               gint64 mtime,
+                                               const gchar * hash)
+{
+  return FALSE;
+}
+
+/**
+ * gtr_translation_memory_store_file:
+ * @obj: a #GtrTranslationMemory
+ * @path: the path of the PO file the messages come from
+ * @size: the size of the file
+ * @mtime: the modification time of the file
+ * @hash: the content hash of the file
+ * @msgs: list of messages (#GtrMsg)
+ *
+ * Stores the messages of the PO file at @path and records its stamp.
+ * Backends that remember which entries came from @path only store the
+ * translated entries that were not there in the previous import.
+ */
+gboolean
+gtr_translation_memory_store_file (GtrTranslationMemory * obj,
+                                   const gchar * path,
+                                   goffset size,
+                                   gint64 mtime,
+                                   const gchar * hash,
+                                   GList * msgs)
+{
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY (obj), FALSE);
+  return GTR_TRANSLATION_MEMORY_GET_IFACE (obj)->store_file (obj, path,
+                                                             size, mtime,
+                                                             hash, msgs);
+}
+
+/* Default implementation */
+static gboolean
+gtr_translation_memory_store_file_default (GtrTranslationMemory * obj,
+                                           const gchar * path,
+                                           goffset size,
+                                           gint64 mtime,
+                                           const gchar * hash,
+                                           GList * msgs)
+{
+  return gtr_translation_memory_store_list (obj, msgs);
+}
+
+/**
+ * gtr_translation_memory_foreach:
+ * @obj: a #GtrTranslationMemory
+ * @func: (scope call): function called for every stored translation
+ * @user_data: data for @func
+ *
+ * Calls @func for every pair of original and translation in the
+ * database, until it returns %FALSE. The entries are read in small pages,
+ * so the memory used does not depend on the size of the database and
+ * other threads can use @obj in between.
+ */
+void
+gtr_translation_memory_foreach (GtrTranslationMemory * obj,
+                                GtrTranslationMemoryForeachFunc func,
+                                gpointer user_data)
+{
+  g_return_if_fail (GTR_IS_TRANSLATION_MEMORY (obj));
+  g_return_if_fail (func != NULL);
+  GTR_TRANSLATION_MEMORY_GET_IFACE (obj)->foreach (obj, func, user_data);
+}
+
+/* Default implementation */
+static void
+gtr_translation_memory_foreach_default (GtrTranslationMemory * obj,
+                                        GtrTranslationMemoryForeachFunc func,
+                                        gpointer user_data)
+{
+}
+
+/**
+ * gtr_translation_memory_maintain:
+ * @obj: a #GtrTranslationMemory
+ * @cancellable: (nullable): a #GCancellable
+ * @reclaimed: (out) (optional): return location for the bytes reclaimed
+ * @error: a #GError or %NULL
+ *
+ * Cleans up the database: removes the originals, words and links left
+ * behind by removed translations, merges duplicated translations,
+ * rebuilds the indexes and gives the free space back to the file system.
+ * It can take a while, so it should be called from a worker thread.
+ *
+ * Returns: %TRUE if the maintenance succeeded
+ */
+gboolean
+gtr_translation_memory_maintain (GtrTranslationMemory * obj,
+                                 GCancellable * cancellable,
+                                 gint64 * reclaimed,
+                                 GError ** error)
+{
+  gint64 bytes = 0;
+  gboolean result;
+
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY (obj), FALSE);
+
+  result = GTR_TRANSLATION_MEMORY_GET_IFACE (obj)->maintain (obj, cancellable,
+                                                             &bytes, error);
+  if (reclaimed != NULL)
+    *reclaimed = bytes;
+
+  return result;
+}
+
+/* Default implementation */
+static gboolean
+gtr_translation_memory_maintain_default (GtrTranslationMemory * obj,
+                                         GCancellable * cancellable,
+                                         gint64 * reclaimed,
+                                         GError ** error)
+{
+  return TRUE;
+}
+
+/**
+ * gtr_translation_memory_is_open:
+ * @obj: a #GtrTranslationMemory
+ *
+ * Checks whether the database has been opened, as it is done in the
+ * background. Until then the lookups done by the UI find nothing.
+ *
+ * Returns: %TRUE if the database is open, or failed to open
+ */
+gboolean
+gtr_translation_memory_is_open (GtrTranslationMemory * obj)
+{
+  g_return_val_if_fail (GTR_IS_TRANSLATION_MEMORY (obj), FALSE);
+  return GTR_TRANSLATION_MEMORY_GET_IFACE (obj)->is_open (obj);
+}
+
+/* Default implementation */
+static gboolean
+gtr_translation_memory_is_open_default (GtrTranslationMemory * obj)
+{
+  return TRUE;
+}
+
 static void
 gtr_translation_memory_default_init (GtrTranslationMemoryInterface *iface)
 {
@@ -200,6 +409,12 @@ gtr_translation_memory_default_init (GtrTranslationMemoryInterface *iface)
   iface->set_max_omits = gtr_translation_memory_set_max_omits_default;
   iface->set_max_delta = gtr_translation_memory_set_max_delta_default;
   iface->set_max_items = gtr_translation_memory_set_max_items_default;
+  iface->get_file_stamp = gtr_translation_memory_get_file_stamp_default;
+  iface->set_file_stamp = gtr_translation_memory_set_file_stamp_default;
+  iface->store_file = gtr_translation_memory_store_file_default;
+  iface->foreach = gtr_translation_memory_foreach_default;
+  iface->maintain = gtr_translation_memory_maintain_default;
+  iface->is_open = gtr_translation_memory_is_open_default;
 
   if (!initialized)
     initialized = TRUE;
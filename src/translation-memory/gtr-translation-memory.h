@@ -19,6 +19,7 @@
 #define _GTR_TRANSLATION_MEMORY_H_
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include "gtr-msg.h"
 
 G_BEGIN_DECLS
@@ -30,6 +31,10 @@ G_BEGIN_DECLS
 typedef struct _GtrTranslationMemory GtrTranslationMemory;
 typedef struct _GtrTranslationMemoryInterface GtrTranslationMemoryInterface;
 
+typedef gboolean (*GtrTranslationMemoryForeachFunc) (const gchar *original,
+                                                     const gchar *translation,
+                                                     gpointer     user_data);
+
 struct _GtrTranslationMemoryInterface
 {
   GTypeInterface g_iface;
@@ -43,6 +48,31 @@ struct _GtrTranslationMemoryInterface
   void (*set_max_omits) (GtrTranslationMemory * obj, gsize omits);
   void (*set_max_delta) (GtrTranslationMemory * obj, gsize delta);
   void (*set_max_items) (GtrTranslationMemory * obj, gint items);
+
+  gboolean (*get_file_stamp) (GtrTranslationMemory *obj,
+                              const gchar          *path,
+                              goffset              *size,
+                              gint64               *mtime,
+                              gchar               **hash);
+  gboolean (*set_file_stamp) (GtrTranslationMemory *obj,
+                              const gchar          *path,
+                              goffset               size,
+                              gint64                mtime,
+                              const gchar          *hash);
+  gboolean (*store_file) (GtrTranslationMemory *obj,
+                          const gchar          *path,
+                          goffset               size,
+                          gint64                mtime,
+                          const gchar          *hash,
+                          GList                *msgs);
+  void (*foreach) (GtrTranslationMemory            *obj,
+                   GtrTranslationMemoryForeachFunc  func,
+                   gpointer                         user_data);
+  gboolean (*maintain) (GtrTranslationMemory  *obj,
+                        GCancellable          *cancellable,
+                        gint64                *reclaimed,
+                        GError               **error);
+  gboolean (*is_open) (GtrTranslationMemory *obj);
 };
 
 typedef struct _GtrTranslationMemoryMatch GtrTranslationMemoryMatch;
@@ -76,5 +106,35 @@ void            gtr_translation_memory_set_max_delta    (GtrTranslationMemory
 void            gtr_translation_memory_set_max_items    (GtrTranslationMemory   *obj,
                                                          gint                    items);
 
+gboolean        gtr_translation_memory_get_file_stamp   (GtrTranslationMemory   *obj,
+                                                         const gchar            *path,
+                                                         goffset                *size,
+                                                         gint64                 *mtime,
+                                                         gchar                 **hash);
+
+gboolean        gtr_translation_memory_set_file_stamp   (GtrTranslationMemory   *obj,
+                                                         const gchar            *path,
+                                                         goffset                 size,
+                                                         gint64                  mtime,
+                                                         const gchar            *hash);
+
+gboolean        gtr_translation_memory_store_file       (GtrTranslationMemory   *obj,
+                                                         const gchar            *path,
+                                                         goffset                 size,
+                                                         gint64                  mtime,
+                                                         const gchar            *hash,
+                                                         GList                  *msgs);
+
+void            gtr_translation_memory_foreach          (GtrTranslationMemory   *obj,
+                                                         GtrTranslationMemoryForeachFunc func,
+                                                         gpointer                user_data);
+
+gboolean        gtr_translation_memory_maintain         (GtrTranslationMemory   *obj,
+                                                         GCancellable           *cancellable,
+                                                         gint64                 *reclaimed,
+                                                         GError                **error);
+
+gboolean        gtr_translation_memory_is_open          (GtrTranslationMemory   *obj);
+
 G_END_DECLS
 #endif
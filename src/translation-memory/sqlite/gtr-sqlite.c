@@ -0,0 +1,2131 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Translation memory backend talking to SQLite directly. It uses the same
+ * database file and schema as GtrGda, so both backends can be switched
+ * without losing the stored translations, but it keeps every statement
+ * compiled for the lifetime of the connection and reads the rows straight
+ * from them instead of materializing data models.
+ *
+ * With the full text search schema the originals are also indexed by an
+ * FTS5 table using the trigram tokenizer, kept up to date by triggers on
+ * ORIG, the best bm25 candidates are retrieved from it and then scored in
+ * memory with the same word overlap metric as the word tables. The WORD and
+ * WORD_ORIG_LINK tables are not written in this mode, so imports only pay
+ * for one index. Instead, the word index is marked as incomplete, and when
+ * the database is opened without full text search, here or by GtrGda, the
+ * words of the originals stored meanwhile are added. The triggers are
+ * dropped when the database is opened without full text search, as they
+ * need FTS5, and the full text index is rebuilt when it is opened with it
+ * again.
+ *
+ * All the writes go through a single connection, serialized by priv->lock,
+ * while lookups take a connection from a small pool of readers. With the
+ * write ahead log the readers see the last committed state, so a long
+ * import never makes the lookups wait.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sqlite3.h>
+#include "gtr-sqlite.h"
+#include "gtr-translation-memory.h"
+#include "gtr-translation-memory-utils.h"
+#include "gtr-debug.h"
+#include "gtr-dirs.h"
+#include "gda/gda-utils.h"
+
+#include <glib.h>
+#include <glib-object.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define GTR_SQLITE_ERROR gtr_sqlite_error_quark ()
+
+/* Size of the memory mapped region of the database file */
+#define MMAP_SIZE (256 * 1024 * 1024)
+
+/* Full text search candidates scored for each requested match */
+#define FTS_CANDIDATES_PER_ITEM 8
+#define FTS_MIN_CANDIDATES 64
+
+/* The trigram tokenizer can only match terms of at least 3 characters */
+#define FTS_MIN_TERM_LENGTH 3
+
+/* Entries read at a time by gtr_sqlite_foreach() */
+#define FOREACH_PAGE_SIZE 512
+
+/* Connections opened at most for the lookups */
+#define MAX_READERS 4
+
+typedef enum
+{
+  STMT_BEGIN,
+  STMT_COMMIT,
+  STMT_ROLLBACK,
+
+  STMT_FIND_ORIG,
+  STMT_SELECT_WORD,
+  STMT_FIND_TRANS,
+
+  STMT_INSERT_ORIG,
+  STMT_INSERT_WORD,
+  STMT_INSERT_LINK,
+  STMT_INSERT_TRANS,
+
+  STMT_DELETE_TRANS,
+
+  STMT_FIND_FILE,
+  STMT_SELECT_FILE_STAMP,
+  STMT_SELECT_FILE_ENTRIES,
+  STMT_INSERT_FILE,
+  STMT_UPDATE_FILE,
+  STMT_INSERT_FILE_ENTRY,
+  STMT_DELETE_FILE_ENTRY,
+
+  STMT_SELECT_EXACT,
+  STMT_SELECT_TRANS,
+  STMT_SELECT_CANDIDATES,
+  STMT_SELECT_ENTRIES,
+
+  N_STATEMENTS
+} GtrSqliteStatement;
+
+static const gchar *statements_sql[N_STATEMENTS] = {
+  [STMT_BEGIN] = "begin immediate",
+  [STMT_COMMIT] = "commit",
+  [STMT_ROLLBACK] = "rollback",
+
+  [STMT_FIND_ORIG] = "select ID from ORIG where VALUE=?1",
+  [STMT_SELECT_WORD] = "select ID from WORD where VALUE=?1",
+  [STMT_FIND_TRANS] = "select ID from TRANS where ORIG_ID=?1 and VALUE=?2",
+
+  [STMT_INSERT_ORIG] = "insert into ORIG (VALUE, SENTENCE_SIZE) values (?1, ?2)",
+  [STMT_INSERT_WORD] = "insert into WORD (VALUE) values (?1)",
+  [STMT_INSERT_LINK] = "insert or ignore into WORD_ORIG_LINK (WORD_ID, ORIG_ID) "
+                       "values (?1, ?2)",
+  [STMT_INSERT_TRANS] = "insert into TRANS (ORIG_ID, VALUE) values (?1, ?2)",
+
+  [STMT_DELETE_TRANS] = "delete from TRANS where ID=?1",
+
+  [STMT_FIND_FILE] = "select ID from FILE where PATH=?1",
+  [STMT_SELECT_FILE_STAMP] = "select SIZE, MTIME, HASH from FILE where PATH=?1",
+  [STMT_SELECT_FILE_ENTRIES] = "select DIGEST from FILE_ENTRY where FILE_ID=?1",
+  [STMT_INSERT_FILE] = "insert into FILE (PATH, SIZE, MTIME, HASH) "
+                       "values (?1, ?2, ?3, ?4)",
+  [STMT_UPDATE_FILE] = "update FILE set SIZE=?2, MTIME=?3, HASH=?4 where PATH=?1",
+  [STMT_INSERT_FILE_ENTRY] = "insert or ignore into FILE_ENTRY (FILE_ID, DIGEST) "
+                             "values (?1, ?2)",
+  [STMT_DELETE_FILE_ENTRY] = "delete from FILE_ENTRY where FILE_ID=?1 and DIGEST=?2",
+
+  [STMT_SELECT_EXACT] = "select TRANS.VALUE, TRANS.ID from TRANS, ORIG "
+                        "where ORIG.ID=TRANS.ORIG_ID and ORIG.VALUE=?1",
+  [STMT_SELECT_TRANS] = "select VALUE, ID from TRANS where ORIG_ID=?1",
+  [STMT_SELECT_CANDIDATES] = "select ORIG.ID, ORIG.VALUE from ORIG_FTS, ORIG "
+                             "where ORIG_FTS match ?1 "
+                             "and ORIG.ID=ORIG_FTS.rowid "
+                             "and ORIG.VALUE<>?2 "
+                             "and ORIG.SENTENCE_SIZE between ?3 and ?4 "
+                             "order by bm25(ORIG_FTS) "
+                             "limit ?5",
+  [STMT_SELECT_ENTRIES] = "select TRANS.ID, ORIG.VALUE, TRANS.VALUE from TRANS, ORIG "
+                          "where ORIG.ID=TRANS.ORIG_ID and TRANS.ID>?1 "
+                          "order by TRANS.ID "
+                          "limit ?2",
+};
+
+static const gchar *schema_sql[] = {
+  "create table if not exists WORD ("
+  "ID integer primary key autoincrement,"
+  "VALUE text unique)",
+
+  "create table if not exists WORD_ORIG_LINK ("
+  "WORD_ID integer,"
+  "ORIG_ID integer,"
+  "primary key (WORD_ID, ORIG_ID))",
+
+  "create table if not exists ORIG ("
+  "ID integer primary key autoincrement,"
+  "VALUE text unique,"
+  "SENTENCE_SIZE integer)",
+
+  "create table if not exists TRANS ("
+  "ID integer primary key autoincrement,"
+  "ORIG_ID integer,"
+  "VALUE text)",
+
+  "create index if not exists IDX_TRANS_ORIG_ID on TRANS (ORIG_ID)",
+  "create index if not exists IDX_WORD_ORIG_LINK_ORIG_ID on WORD_ORIG_LINK (ORIG_ID)",
+  "create index if not exists IDX_ORIG_SENTENCE_SIZE on ORIG (SENTENCE_SIZE)",
+
+  "create table if not exists FILE ("
+  "ID integer primary key autoincrement,"
+  "PATH text unique,"
+  "SIZE int64,"
+  "MTIME int64,"
+  "HASH text)",
+
+  "create table if not exists FILE_ENTRY ("
+  "FILE_ID integer,"
+  "DIGEST text,"
+  "primary key (FILE_ID, DIGEST))",
+
+  NULL
+};
+
+/* Run by gtr_sqlite_maintain() in a single transaction, in this order */
+static const gchar *maintenance_sql[] = {
+  /* translations whose original is gone */
+  "delete from TRANS where not exists "
+  "(select 1 from ORIG where ORIG.ID=TRANS.ORIG_ID)",
+
+  /* identical translations of the same original, the first one is kept */
+  "delete from TRANS where ID not in "
+  "(select min(ID) from TRANS group by ORIG_ID, VALUE)",
+
+  /* originals left without translations by gtr_sqlite_remove() */
+  "delete from ORIG where not exists "
+  "(select 1 from TRANS where TRANS.ORIG_ID=ORIG.ID)",
+
+  "delete from WORD_ORIG_LINK where not exists "
+  "(select 1 from ORIG where ORIG.ID=WORD_ORIG_LINK.ORIG_ID)",
+
+  "delete from WORD where not exists "
+  "(select 1 from WORD_ORIG_LINK where WORD_ORIG_LINK.WORD_ID=WORD.ID)",
+
+  NULL
+};
+
+static const gchar *fts_drop_sql[] = {
+  "drop trigger if exists ORIG_FTS_INSERT",
+  "drop trigger if exists ORIG_FTS_DELETE",
+  "drop trigger if exists ORIG_FTS_UPDATE",
+  NULL
+};
+
+static const gchar *fts_schema_sql[] = {
+  "create trigger if not exists ORIG_FTS_INSERT after insert on ORIG begin "
+  "insert into ORIG_FTS (rowid, VALUE) values (new.ID, new.VALUE); "
+  "end",
+
+  "create trigger if not exists ORIG_FTS_DELETE after delete on ORIG begin "
+  "insert into ORIG_FTS (ORIG_FTS, rowid, VALUE) values ('delete', old.ID, old.VALUE); "
+  "end",
+
+  "create trigger if not exists ORIG_FTS_UPDATE after update on ORIG begin "
+  "insert into ORIG_FTS (ORIG_FTS, rowid, VALUE) values ('delete', old.ID, old.VALUE); "
+  "insert into ORIG_FTS (rowid, VALUE) values (new.ID, new.VALUE); "
+  "end",
+
+  NULL
+};
+
+enum
+{
+  PROP_0,
+  PROP_FULL_TEXT_SEARCH,
+  PROP_LANGUAGE
+};
+
+typedef struct
+{
+  gint64 orig_id;
+  gint score;
+} Candidate;
+
+static void
+gtr_translation_memory_iface_init (GtrTranslationMemoryInterface * iface);
+
+typedef struct
+{
+  sqlite3 *db;
+
+  /* prepared statements, kept for the lifetime of the connection */
+  sqlite3_stmt *statements[N_STATEMENTS];
+
+  /* word count -> lookup statement */
+  GHashTable *lookup_query_cache;
+
+  /* lookup settings the cached statements were built for */
+  guint generation;
+  guint max_omits;
+  guint max_delta;
+  gint max_items;
+} GtrSqliteConnection;
+
+typedef struct
+{
+  GtrSqliteConnection *writer;
+  gchar *filename;
+  gchar *language;
+
+  /* whether the originals are searched with the FTS5 index */
+  guint full_text_search : 1;
+
+  /* Serializes access to the writer, the importer stores from a worker
+   * thread while the UI keeps doing lookups */
+  GMutex lock;
+
+  /* Set once open_thread() is done, whether it succeeded or not */
+  gint opened;
+  GCond opened_cond;
+
+  /* Idle reader connections, more are opened up to MAX_READERS when
+   * every one is busy. pool_lock also guards the lookup settings. */
+  GMutex pool_lock;
+  GCond pool_cond;
+  GQueue readers;
+  guint n_readers;
+
+  guint max_omits;
+  guint max_delta;
+  gint max_items;
+  /* bumped when the lookup settings change */
+  guint generation;
+} GtrSqlitePrivate;
+
+G_DEFINE_TYPE_WITH_CODE (GtrSqlite,
+                         gtr_sqlite,
+                         G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (GtrSqlite)
+                         G_IMPLEMENT_INTERFACE (GTR_TYPE_TRANSLATION_MEMORY,
+                                                gtr_translation_memory_iface_init))
+
+G_DEFINE_QUARK (gtr-sqlite-error-quark, gtr_sqlite_error)
+
+static void
+set_error (GtrSqliteConnection *conn,
+           GError             **error)
+{
+  g_set_error_literal (error, GTR_SQLITE_ERROR,
+                       sqlite3_extended_errcode (conn->db),
+                       sqlite3_errmsg (conn->db));
+}
+
+static sqlite3_stmt *
+get_statement (GtrSqliteConnection *conn,
+               GtrSqliteStatement   id)
+{
+  return conn->statements[id];
+}
+
+/* Runs @stmt, which must not return rows, and resets it */
+static gboolean
+execute (GtrSqliteConnection *conn,
+         sqlite3_stmt        *stmt,
+         GError             **error)
+{
+  gboolean result = TRUE;
+
+  if (sqlite3_step (stmt) != SQLITE_DONE)
+    {
+      set_error (conn, error);
+      result = FALSE;
+    }
+
+  sqlite3_reset (stmt);
+  sqlite3_clear_bindings (stmt);
+
+  return result;
+}
+
+/* Returns the integer in the first column of the first row of @stmt,
+ * or 0 if there are no rows */
+static gint64
+select_integer (GtrSqliteConnection *conn,
+                sqlite3_stmt        *stmt,
+                GError             **error)
+{
+  gint64 result = 0;
+
+  switch (sqlite3_step (stmt))
+    {
+    case SQLITE_ROW:
+      result = sqlite3_column_int64 (stmt, 0);
+      break;
+    case SQLITE_DONE:
+      break;
+    default:
+      set_error (conn, error);
+      break;
+    }
+
+  sqlite3_reset (stmt);
+  sqlite3_clear_bindings (stmt);
+
+  return result;
+}
+
+static gint64
+insert_row (GtrSqliteConnection *conn,
+            sqlite3_stmt        *stmt,
+            GError             **error)
+{
+  if (!execute (conn, stmt, error))
+    return 0;
+
+  return sqlite3_last_insert_rowid (conn->db);
+}
+
+static gboolean
+begin_transaction (GtrSqliteConnection *conn)
+{
+  GError *error = NULL;
+
+  if (!execute (conn, get_statement (conn, STMT_BEGIN), &error))
+    {
+      g_warning ("starting transaction failed: %s", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+end_transaction (GtrSqliteConnection *conn,
+                 gboolean             commit)
+{
+  GError *error = NULL;
+
+  if (commit &&
+      execute (conn, get_statement (conn, STMT_COMMIT), &error))
+    return;
+
+  if (error)
+    {
+      g_warning ("committing transaction failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  execute (conn, get_statement (conn, STMT_ROLLBACK), NULL);
+}
+
+static GtrSqliteConnection *connection_open  (GtrSqlite           *self,
+                                              gboolean             reader);
+static void                 connection_close (GtrSqliteConnection *conn);
+
+/* Waits for the database to be opened and takes the writer lock. Returns
+ * %FALSE, without the lock, if the database could not be opened. */
+static gboolean
+lock_writer (GtrSqlite *self)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_mutex_lock (&priv->lock);
+
+  while (!priv->opened)
+    g_cond_wait (&priv->opened_cond, &priv->lock);
+
+  if (priv->writer == NULL)
+    {
+      g_mutex_unlock (&priv->lock);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Waits for the database to be opened, without taking the writer lock
+ * once it is, so the readers never wait for a transaction */
+static gboolean
+wait_until_open (GtrSqlite *self)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  if (!g_atomic_int_get (&priv->opened))
+    {
+      g_mutex_lock (&priv->lock);
+      while (!priv->opened)
+        g_cond_wait (&priv->opened_cond, &priv->lock);
+      g_mutex_unlock (&priv->lock);
+    }
+
+  return priv->writer != NULL;
+}
+
+/* Takes an idle reader, opening a new one or waiting for one to be
+ * released when all of them are busy */
+static GtrSqliteConnection *
+acquire_reader (GtrSqlite *self)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  GtrSqliteConnection *conn;
+
+  g_mutex_lock (&priv->pool_lock);
+
+  while ((conn = g_queue_pop_head (&priv->readers)) == NULL &&
+         priv->n_readers >= MAX_READERS)
+    g_cond_wait (&priv->pool_cond, &priv->pool_lock);
+
+  if (conn == NULL)
+    {
+      priv->n_readers++;
+      g_mutex_unlock (&priv->pool_lock);
+
+      conn = connection_open (self, TRUE);
+
+      g_mutex_lock (&priv->pool_lock);
+
+      if (conn == NULL)
+        {
+          priv->n_readers--;
+          g_cond_signal (&priv->pool_cond);
+          g_mutex_unlock (&priv->pool_lock);
+          return NULL;
+        }
+    }
+
+  /* The lookup statements embed the settings */
+  if (conn->generation != priv->generation)
+    {
+      g_hash_table_remove_all (conn->lookup_query_cache);
+      conn->max_omits = priv->max_omits;
+      conn->max_delta = priv->max_delta;
+      conn->max_items = priv->max_items;
+      conn->generation = priv->generation;
+    }
+
+  g_mutex_unlock (&priv->pool_lock);
+
+  return conn;
+}
+
+static void
+release_reader (GtrSqlite           *self,
+                GtrSqliteConnection *conn)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_mutex_lock (&priv->pool_lock);
+  g_queue_push_head (&priv->readers, conn);
+  g_cond_signal (&priv->pool_cond);
+  g_mutex_unlock (&priv->pool_lock);
+}
+
+static void
+gtr_sqlite_words_append (GtrSqliteConnection *conn,
+                         const gchar         *word,
+                         gint64               orig_id,
+                         GError             **error)
+{
+  sqlite3_stmt *stmt;
+  GError *inner_error = NULL;
+  gint64 word_id;
+
+  /* look for word */
+  stmt = get_statement (conn, STMT_SELECT_WORD);
+  sqlite3_bind_text (stmt, 1, word, -1, SQLITE_STATIC);
+  word_id = select_integer (conn, stmt, &inner_error);
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return;
+    }
+
+  if (word_id == 0)
+    {
+      stmt = get_statement (conn, STMT_INSERT_WORD);
+      sqlite3_bind_text (stmt, 1, word, -1, SQLITE_STATIC);
+      word_id = insert_row (conn, stmt, &inner_error);
+      if (inner_error)
+        {
+          g_propagate_error (error, inner_error);
+          return;
+        }
+    }
+
+  /* insert link */
+  stmt = get_statement (conn, STMT_INSERT_LINK);
+  sqlite3_bind_int64 (stmt, 1, word_id);
+  sqlite3_bind_int64 (stmt, 2, orig_id);
+  execute (conn, stmt, error);
+}
+
+static gboolean
+gtr_sqlite_store_impl (GtrSqlite   *self,
+                       const gchar *original,
+                       const gchar *translation,
+                       GError     **error)
+{
+  sqlite3_stmt *stmt;
+  gint64 orig_id;
+  gboolean found_translation = FALSE;
+  GError *inner_error = NULL;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  GtrSqliteConnection *conn = priv->writer;
+
+  stmt = get_statement (conn, STMT_FIND_ORIG);
+  sqlite3_bind_text (stmt, 1, original, -1, SQLITE_STATIC);
+  orig_id = select_integer (conn, stmt, &inner_error);
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return FALSE;
+    }
+
+  if (orig_id == 0)
+    {
+      gchar **words;
+      gsize sz, i;
+
+      words = gtr_gda_utils_split_string_in_unique_words (original);
+      sz = g_strv_length (words);
+
+      stmt = get_statement (conn, STMT_INSERT_ORIG);
+      sqlite3_bind_text (stmt, 1, original, -1, SQLITE_STATIC);
+      sqlite3_bind_int (stmt, 2, (gint) sz);
+      orig_id = insert_row (conn, stmt, &inner_error);
+
+      /* The full text index is updated by a trigger, and the words are
+       * added when the database is opened without it */
+      if (!priv->full_text_search)
+        for (i = 0; i < sz && !inner_error; i++)
+          gtr_sqlite_words_append (conn, words[i], orig_id, &inner_error);
+
+      g_free (words);
+    }
+  else
+    {
+      stmt = get_statement (conn, STMT_FIND_TRANS);
+      sqlite3_bind_int64 (stmt, 1, orig_id);
+      sqlite3_bind_text (stmt, 2, translation, -1, SQLITE_STATIC);
+      found_translation = select_integer (conn, stmt, &inner_error) != 0;
+    }
+
+  if (!inner_error && !found_translation)
+    {
+      stmt = get_statement (conn, STMT_INSERT_TRANS);
+      sqlite3_bind_int64 (stmt, 1, orig_id);
+      sqlite3_bind_text (stmt, 2, translation, -1, SQLITE_STATIC);
+      insert_row (conn, stmt, &inner_error);
+    }
+
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtr_sqlite_store (GtrTranslationMemory * tm, GtrMsg * msg)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  gboolean result;
+  GError *error = NULL;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_return_val_if_fail (GTR_IS_SQLITE (self), FALSE);
+
+  if (!lock_writer (self))
+    return FALSE;
+
+  if (!begin_transaction (priv->writer))
+    {
+      g_mutex_unlock (&priv->lock);
+      return FALSE;
+    }
+
+  result = gtr_sqlite_store_impl (self,
+                                  gtr_msg_get_msgid (msg),
+                                  gtr_msg_get_msgstr (msg),
+                                  &error);
+  if (error)
+    {
+      g_warning ("storing message failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  end_transaction (priv->writer, result);
+
+  g_mutex_unlock (&priv->lock);
+
+  return result;
+}
+
+static gboolean
+gtr_sqlite_store_list (GtrTranslationMemory * tm, GList * msgs)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  gboolean result = TRUE;
+  GList *l;
+  GError *error = NULL;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_return_val_if_fail (GTR_IS_SQLITE (self), FALSE);
+
+  if (!lock_writer (self))
+    return FALSE;
+
+  if (!begin_transaction (priv->writer))
+    {
+      g_mutex_unlock (&priv->lock);
+      return FALSE;
+    }
+
+  for (l = msgs; l; l = g_list_next (l))
+    {
+      GtrMsg *msg = GTR_MSG (l->data);
+
+      if (!gtr_msg_is_translated (msg) || gtr_msg_is_fuzzy (msg))
+        continue;
+
+      result = gtr_sqlite_store_impl (self,
+                                      gtr_msg_get_msgid (msg),
+                                      gtr_msg_get_msgstr (msg),
+                                      &error);
+      if (!result)
+        {
+          g_warning ("storing message failed: %s", error->message);
+          g_error_free (error);
+          break;
+        }
+    }
+
+  end_transaction (priv->writer, result);
+
+  g_mutex_unlock (&priv->lock);
+
+  return result;
+}
+
+static void
+gtr_sqlite_remove (GtrTranslationMemory *tm,
+                   gint translation_id)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  sqlite3_stmt *stmt;
+  GError *error = NULL;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  if (!lock_writer (self))
+    return;
+
+  stmt = get_statement (priv->writer, STMT_DELETE_TRANS);
+  sqlite3_bind_int (stmt, 1, translation_id);
+  execute (priv->writer, stmt, &error);
+  g_mutex_unlock (&priv->lock);
+
+  if (error)
+    {
+      g_warning ("removing translation failed: %s", error->message);
+      g_error_free (error);
+    }
+}
+
+static gboolean
+gtr_sqlite_get_file_stamp (GtrTranslationMemory *tm,
+                           const gchar *path,
+                           goffset *size,
+                           gint64 *mtime,
+                           gchar **hash)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GtrSqliteConnection *conn;
+  sqlite3_stmt *stmt;
+  gboolean found = FALSE;
+  gint rc;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  if (!wait_until_open (self))
+    return FALSE;
+
+  conn = acquire_reader (self);
+  if (conn == NULL)
+    return FALSE;
+
+  stmt = get_statement (conn, STMT_SELECT_FILE_STAMP);
+  sqlite3_bind_text (stmt, 1, path, -1, SQLITE_STATIC);
+
+  rc = sqlite3_step (stmt);
+  if (rc == SQLITE_ROW && sqlite3_column_type (stmt, 2) == SQLITE_TEXT)
+    {
+      *size = sqlite3_column_int64 (stmt, 0);
+      *mtime = sqlite3_column_int64 (stmt, 1);
+      *hash = g_strdup ((const gchar *) sqlite3_column_text (stmt, 2));
+      found = TRUE;
+    }
+  else if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+    g_warning ("reading file stamp failed: %s", sqlite3_errmsg (conn->db));
+
+  sqlite3_reset (stmt);
+  sqlite3_clear_bindings (stmt);
+
+  release_reader (self, conn);
+
+  return found;
+}
+
+static gboolean
+gtr_sqlite_update_file_stamp (GtrSqlite *self,
+                              const gchar *path,
+                              goffset size,
+                              gint64 mtime,
+                              const gchar *hash,
+                              GError **error)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  GtrSqliteConnection *conn = priv->writer;
+  sqlite3_stmt *stmt;
+
+  stmt = get_statement (conn, STMT_UPDATE_FILE);
+  sqlite3_bind_text (stmt, 1, path, -1, SQLITE_STATIC);
+  sqlite3_bind_int64 (stmt, 2, size);
+  sqlite3_bind_int64 (stmt, 3, mtime);
+  sqlite3_bind_text (stmt, 4, hash, -1, SQLITE_STATIC);
+
+  return execute (conn, stmt, error);
+}
+
+static gboolean
+gtr_sqlite_set_file_stamp (GtrTranslationMemory *tm,
+                           const gchar *path,
+                           goffset size,
+                           gint64 mtime,
+                           const gchar *hash)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GError *error = NULL;
+  gboolean result;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  if (!lock_writer (self))
+    return FALSE;
+
+  result = gtr_sqlite_update_file_stamp (self, path, size, mtime, hash, &error);
+  g_mutex_unlock (&priv->lock);
+
+  if (error)
+    {
+      g_warning ("updating file stamp failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  return result;
+}
+
+static GHashTable *
+gtr_sqlite_select_file_entries (GtrSqlite *self,
+                                gint64 file_id,
+                                GError **error)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  GtrSqliteConnection *conn = priv->writer;
+  sqlite3_stmt *stmt;
+  GHashTable *entries;
+  gint rc;
+
+  entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  stmt = get_statement (conn, STMT_SELECT_FILE_ENTRIES);
+  sqlite3_bind_int64 (stmt, 1, file_id);
+
+  while ((rc = sqlite3_step (stmt)) == SQLITE_ROW)
+    {
+      const gchar *digest = (const gchar *) sqlite3_column_text (stmt, 0);
+
+      if (digest)
+        g_hash_table_add (entries, g_strdup (digest));
+    }
+
+  if (rc != SQLITE_DONE)
+    set_error (conn, error);
+
+  sqlite3_reset (stmt);
+  sqlite3_clear_bindings (stmt);
+
+  return entries;
+}
+
+static gboolean
+gtr_sqlite_store_file_impl (GtrSqlite *self,
+                            const gchar *path,
+                            goffset size,
+                            gint64 mtime,
+                            const gchar *hash,
+                            GList *msgs,
+                            GError **error)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  GtrSqliteConnection *conn = priv->writer;
+  GHashTable *old_entries;
+  GHashTable *new_entries;
+  GHashTableIter iter;
+  gpointer digest;
+  GError *inner_error = NULL;
+  sqlite3_stmt *stmt;
+  GList *l;
+  gint64 file_id;
+
+  stmt = get_statement (conn, STMT_FIND_FILE);
+  sqlite3_bind_text (stmt, 1, path, -1, SQLITE_STATIC);
+  file_id = select_integer (conn, stmt, &inner_error);
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return FALSE;
+    }
+
+  if (file_id == 0)
+    {
+      old_entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+      stmt = get_statement (conn, STMT_INSERT_FILE);
+      sqlite3_bind_text (stmt, 1, path, -1, SQLITE_STATIC);
+      sqlite3_bind_int64 (stmt, 2, size);
+      sqlite3_bind_int64 (stmt, 3, mtime);
+      sqlite3_bind_text (stmt, 4, hash, -1, SQLITE_STATIC);
+      file_id = insert_row (conn, stmt, &inner_error);
+    }
+  else
+    {
+      old_entries = gtr_sqlite_select_file_entries (self, file_id, &inner_error);
+      if (!inner_error)
+        gtr_sqlite_update_file_stamp (self, path, size, mtime, hash, &inner_error);
+    }
+
+  new_entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* Only the entries that were not in the previous import are stored,
+   * the rest of the translation memory is left untouched */
+  for (l = msgs; l && !inner_error; l = g_list_next (l))
+    {
+      GtrMsg *msg = GTR_MSG (l->data);
+      const gchar *original, *translation;
+      gchar *entry;
+
+      if (!gtr_msg_is_translated (msg) || gtr_msg_is_fuzzy (msg))
+        continue;
+
+      original = gtr_msg_get_msgid (msg);
+      translation = gtr_msg_get_msgstr (msg);
+      entry = gtr_translation_memory_utils_entry_digest (original, translation);
+
+      if (g_hash_table_contains (new_entries, entry))
+        {
+          g_free (entry);
+          continue;
+        }
+
+      if (!g_hash_table_remove (old_entries, entry) &&
+          gtr_sqlite_store_impl (self, original, translation, &inner_error))
+        {
+          stmt = get_statement (conn, STMT_INSERT_FILE_ENTRY);
+          sqlite3_bind_int64 (stmt, 1, file_id);
+          sqlite3_bind_text (stmt, 2, entry, -1, SQLITE_STATIC);
+          execute (conn, stmt, &inner_error);
+        }
+
+      g_hash_table_add (new_entries, entry);
+    }
+
+  /* What is left are the entries that were removed from the file */
+  stmt = get_statement (conn, STMT_DELETE_FILE_ENTRY);
+  g_hash_table_iter_init (&iter, old_entries);
+  while (!inner_error && g_hash_table_iter_next (&iter, &digest, NULL))
+    {
+      sqlite3_bind_int64 (stmt, 1, file_id);
+      sqlite3_bind_text (stmt, 2, digest, -1, SQLITE_STATIC);
+      execute (conn, stmt, &inner_error);
+    }
+
+  g_hash_table_unref (old_entries);
+  g_hash_table_unref (new_entries);
+
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtr_sqlite_store_file (GtrTranslationMemory *tm,
+                       const gchar *path,
+                       goffset size,
+                       gint64 mtime,
+                       const gchar *hash,
+                       GList *msgs)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  gboolean result;
+  GError *error = NULL;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_return_val_if_fail (GTR_IS_SQLITE (self), FALSE);
+
+  if (!lock_writer (self))
+    return FALSE;
+
+  if (!begin_transaction (priv->writer))
+    {
+      g_mutex_unlock (&priv->lock);
+      return FALSE;
+    }
+
+  result = gtr_sqlite_store_file_impl (self, path, size, mtime, hash, msgs, &error);
+  if (error)
+    {
+      g_warning ("storing file failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  end_transaction (priv->writer, result);
+
+  g_mutex_unlock (&priv->lock);
+
+  return result;
+}
+
+static void
+free_match (gpointer data)
+{
+  GtrTranslationMemoryMatch *match = (GtrTranslationMemoryMatch *) data;
+
+  g_free (match->match);
+  g_slice_free (GtrTranslationMemoryMatch, match);
+}
+
+/* Same query as the GDA backend, ?1 is the phrase and ?2.. the words */
+static gchar *
+build_lookup_query (GtrSqliteConnection *conn, guint word_count)
+{
+  GString *query = g_string_sized_new (1024);
+  guint i;
+
+  g_string_append_printf (query,
+                          "select "
+                          "    TRANS.VALUE, "
+                          "    100 SCORE, "
+                          "    TRANS.ID "
+                          "from "
+                          "     TRANS, ORIG "
+                          "where ORIG.ID = TRANS.ORIG_ID "
+                          "  and ORIG.VALUE = ?1 "
+                          "union "
+                          "select "
+                          "    TRANS.VALUE, "
+                          "    SC SCORE, "
+                          "    TRANS.ID "
+                          "from TRANS, "
+                          "     (select "
+                          "          ORIG.ID ORID, "
+                          "          cast(count(1) * count(1) * 100 "
+                          "               / (%d * ORIG.SENTENCE_SIZE + 1) "
+                          "            as integer) SC "
+                          "      from "
+                          "          WORD, WORD_ORIG_LINK, ORIG "
+                          "      where WORD.ID = WORD_ORIG_LINK.WORD_ID "
+                          "        and ORIG.ID = WORD_ORIG_LINK.ORIG_ID "
+                          "        and ORIG.VALUE <> ?1 "
+                          "        and ORIG.SENTENCE_SIZE between %u and %u "
+                          "        and WORD.VALUE in (",
+                          word_count,
+                          word_count,
+                          word_count + conn->max_delta);
+
+  for (i = 0; i < word_count; ++i)
+    {
+      g_string_append_printf (query, "?%u", i + 2);
+      if (i != word_count - 1)
+        g_string_append (query, ", ");
+    }
+
+  g_string_append_printf (query,
+                          ") "
+                          "     group by ORIG.ID "
+                          "     having count(1) >= %d) "
+                          "where ORID = TRANS.ORIG_ID "
+                          "order by SCORE desc "
+                          "limit %d",
+                          word_count - conn->max_omits,
+                          conn->max_items);
+
+  return g_string_free (query, FALSE);
+}
+
+static sqlite3_stmt *
+gtr_sqlite_get_lookup_statement (GtrSqliteConnection *conn,
+                                 guint word_count,
+                                 GError **error)
+{
+  sqlite3_stmt *stmt;
+  gchar *query;
+
+  stmt = g_hash_table_lookup (conn->lookup_query_cache,
+                              GUINT_TO_POINTER (word_count));
+  if (stmt)
+    return stmt;
+
+  query = build_lookup_query (conn, word_count);
+  if (sqlite3_prepare_v2 (conn->db, query, -1, &stmt, NULL) != SQLITE_OK)
+    {
+      set_error (conn, error);
+      g_free (query);
+      return NULL;
+    }
+  g_free (query);
+
+  g_hash_table_insert (conn->lookup_query_cache,
+                       GUINT_TO_POINTER (word_count),
+                       stmt);
+
+  return stmt;
+}
+
+/* Builds an FTS5 query matching any of @words, or %NULL if none of
+ * them is long enough for the trigram tokenizer */
+static gchar *
+build_match_expression (gchar **words)
+{
+  GString *expr = g_string_new (NULL);
+  gint i;
+
+  for (i = 0; words[i] != NULL; i++)
+    {
+      const gchar *p;
+
+      if (g_utf8_strlen (words[i], -1) < FTS_MIN_TERM_LENGTH)
+        continue;
+
+      if (expr->len > 0)
+        g_string_append (expr, " OR ");
+
+      g_string_append_c (expr, '"');
+      for (p = words[i]; *p != '\0'; p++)
+        {
+          if (*p == '"')
+            g_string_append_c (expr, '"');
+          g_string_append_c (expr, *p);
+        }
+      g_string_append_c (expr, '"');
+    }
+
+  if (expr->len == 0)
+    {
+      g_string_free (expr, TRUE);
+      return NULL;
+    }
+
+  return g_string_free (expr, FALSE);
+}
+
+/* Both arrays are sorted and without duplicates */
+static guint
+count_common_words (gchar **a,
+                    gchar **b)
+{
+  guint common = 0;
+  gint cmp;
+
+  while (*a != NULL && *b != NULL)
+    {
+      cmp = strcmp (*a, *b);
+      if (cmp == 0)
+        {
+          common++;
+          a++;
+          b++;
+        }
+      else if (cmp < 0)
+        a++;
+      else
+        b++;
+    }
+
+  return common;
+}
+
+static gint
+compare_matches (gconstpointer a,
+                 gconstpointer b)
+{
+  const GtrTranslationMemoryMatch *ma = a;
+  const GtrTranslationMemoryMatch *mb = b;
+
+  return mb->level - ma->level;
+}
+
+static GList *
+append_translations (GtrSqliteConnection *conn,
+                     sqlite3_stmt        *stmt,
+                     gint                 score,
+                     GList               *matches,
+                     GError             **error)
+{
+  gint rc;
+
+  while ((rc = sqlite3_step (stmt)) == SQLITE_ROW)
+    {
+      GtrTranslationMemoryMatch *match;
+
+      match = g_slice_new (GtrTranslationMemoryMatch);
+      match->match = g_strdup ((const gchar *) sqlite3_column_text (stmt, 0));
+      match->level = score;
+      match->id = sqlite3_column_int (stmt, 1);
+
+      matches = g_list_prepend (matches, match);
+    }
+
+  if (rc != SQLITE_DONE)
+    set_error (conn, error);
+
+  sqlite3_reset (stmt);
+  sqlite3_clear_bindings (stmt);
+
+  return matches;
+}
+
+static GList *
+gtr_sqlite_lookup_full_text (GtrSqliteConnection *conn,
+                             const gchar         *phrase,
+                             gchar              **words,
+                             GError             **error)
+{
+  sqlite3_stmt *stmt;
+  GArray *candidates;
+  GList *matches = NULL;
+  GError *inner_error = NULL;
+  gchar *match_expr;
+  guint cnt;
+  guint i;
+  gint rc;
+
+  cnt = g_strv_length (words);
+
+  /* exact matches */
+  stmt = get_statement (conn, STMT_SELECT_EXACT);
+  sqlite3_bind_text (stmt, 1, phrase, -1, SQLITE_STATIC);
+  matches = append_translations (conn, stmt, 100, matches, &inner_error);
+
+  match_expr = build_match_expression (words);
+  if (inner_error || match_expr == NULL)
+    goto out;
+
+  /* the best ranked candidates are scored like the word tables do */
+  candidates = g_array_new (FALSE, FALSE, sizeof (Candidate));
+
+  stmt = get_statement (conn, STMT_SELECT_CANDIDATES);
+  sqlite3_bind_text (stmt, 1, match_expr, -1, SQLITE_STATIC);
+  sqlite3_bind_text (stmt, 2, phrase, -1, SQLITE_STATIC);
+  sqlite3_bind_int (stmt, 3, cnt);
+  sqlite3_bind_int (stmt, 4, cnt + conn->max_delta);
+  sqlite3_bind_int (stmt, 5, MAX (conn->max_items * FTS_CANDIDATES_PER_ITEM,
+                                  FTS_MIN_CANDIDATES));
+
+  while ((rc = sqlite3_step (stmt)) == SQLITE_ROW)
+    {
+      const gchar *original = (const gchar *) sqlite3_column_text (stmt, 1);
+      gchar **orig_words;
+      guint size, common;
+
+      orig_words = gtr_gda_utils_split_string_in_unique_words (original);
+      size = g_strv_length (orig_words);
+      common = count_common_words (words, orig_words);
+      g_free (orig_words);
+
+      if ((gint) common >= (gint) cnt - (gint) conn->max_omits)
+        {
+          Candidate candidate;
+
+          candidate.orig_id = sqlite3_column_int64 (stmt, 0);
+          candidate.score = common * common * 100 / (cnt * size + 1);
+          g_array_append_val (candidates, candidate);
+        }
+    }
+
+  if (rc != SQLITE_DONE)
+    set_error (conn, &inner_error);
+
+  sqlite3_reset (stmt);
+  sqlite3_clear_bindings (stmt);
+
+  stmt = get_statement (conn, STMT_SELECT_TRANS);
+  for (i = 0; i < candidates->len && !inner_error; i++)
+    {
+      Candidate *candidate = &g_array_index (candidates, Candidate, i);
+
+      sqlite3_bind_int64 (stmt, 1, candidate->orig_id);
+      matches = append_translations (conn, stmt, candidate->score,
+                                     matches, &inner_error);
+    }
+
+  g_array_free (candidates, TRUE);
+
+ out:
+  g_free (match_expr);
+
+  if (inner_error)
+    {
+      g_propagate_error (error, inner_error);
+      return matches;
+    }
+
+  /* g_list_sort() is stable, the exact matches stay first */
+  matches = g_list_sort (g_list_reverse (matches), compare_matches);
+
+  if (conn->max_items > 0 && g_list_length (matches) > (guint) conn->max_items)
+    {
+      GList *rest = g_list_nth (matches, conn->max_items);
+
+      rest->prev->next = NULL;
+      rest->prev = NULL;
+      g_list_free_full (rest, free_match);
+    }
+
+  return matches;
+}
+
+static GList *
+gtr_sqlite_lookup_words (GtrSqliteConnection *conn,
+                         const gchar         *phrase,
+                         gchar              **words,
+                         GError             **error)
+{
+  sqlite3_stmt *stmt;
+  GList *matches = NULL;
+  guint cnt, i;
+  gint rc;
+
+  cnt = g_strv_length (words);
+
+  stmt = gtr_sqlite_get_lookup_statement (conn, cnt, error);
+  if (stmt == NULL)
+    return NULL;
+
+  sqlite3_bind_text (stmt, 1, phrase, -1, SQLITE_STATIC);
+  for (i = 0; i < cnt; i++)
+    sqlite3_bind_text (stmt, i + 2, words[i], -1, SQLITE_STATIC);
+
+  while ((rc = sqlite3_step (stmt)) == SQLITE_ROW)
+    {
+      GtrTranslationMemoryMatch *match;
+
+      match = g_slice_new (GtrTranslationMemoryMatch);
+      match->match = g_strdup ((const gchar *) sqlite3_column_text (stmt, 0));
+      match->level = sqlite3_column_int (stmt, 1);
+      match->id = sqlite3_column_int (stmt, 2);
+
+      matches = g_list_prepend (matches, match);
+    }
+
+  if (rc != SQLITE_DONE)
+    set_error (conn, error);
+
+  sqlite3_reset (stmt);
+  sqlite3_clear_bindings (stmt);
+
+  return g_list_reverse (matches);
+}
+
+static GList *
+gtr_sqlite_lookup (GtrTranslationMemory * tm, const gchar * phrase)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GtrSqliteConnection *conn;
+  gchar **words;
+  GList *matches;
+  GError *error = NULL;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_return_val_if_fail (GTR_IS_SQLITE (self), NULL);
+
+  /* The UI finds nothing until the database is open, rather than
+   * blocking while it is, other threads wait for it */
+  if (!g_atomic_int_get (&priv->opened) &&
+      g_main_context_is_owner (g_main_context_default ()))
+    return NULL;
+
+  if (!wait_until_open (self))
+    return NULL;
+
+  words = gtr_gda_utils_split_string_in_unique_words (phrase);
+
+  conn = acquire_reader (self);
+  if (conn == NULL)
+    {
+      g_free (words);
+      return NULL;
+    }
+
+  if (priv->full_text_search)
+    matches = gtr_sqlite_lookup_full_text (conn, phrase, words, &error);
+  else
+    matches = gtr_sqlite_lookup_words (conn, phrase, words, &error);
+
+  release_reader (self, conn);
+
+  g_free (words);
+
+  if (error)
+    {
+      g_list_free_full (matches, free_match);
+
+      g_warning ("%s\n", error->message);
+
+      g_error_free (error);
+
+      return NULL;
+    }
+
+  return matches;
+}
+
+static void
+gtr_sqlite_set_max_omits (GtrTranslationMemory * tm, gsize omits)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_mutex_lock (&priv->pool_lock);
+  priv->max_omits = omits;
+  priv->generation++;
+  g_mutex_unlock (&priv->pool_lock);
+}
+
+static void
+gtr_sqlite_set_max_delta (GtrTranslationMemory * tm, gsize delta)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_mutex_lock (&priv->pool_lock);
+  priv->max_delta = delta;
+  priv->generation++;
+  g_mutex_unlock (&priv->pool_lock);
+}
+
+static void
+gtr_sqlite_set_max_items (GtrTranslationMemory * tm, gint items)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_mutex_lock (&priv->pool_lock);
+  priv->max_items = items;
+  priv->generation++;
+  g_mutex_unlock (&priv->pool_lock);
+}
+
+/*
+ * The entries are read in pages so no reader is held while @func runs,
+ * the last TRANS.ID seen is the start of the next page.
+ */
+static void
+gtr_sqlite_foreach (GtrTranslationMemory            *tm,
+                    GtrTranslationMemoryForeachFunc  func,
+                    gpointer                         user_data)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  GtrSqliteConnection *conn;
+  GPtrArray *page;
+  sqlite3_stmt *stmt;
+  gint64 last_id = 0;
+  gboolean more = TRUE;
+  GError *error = NULL;
+  gint rc;
+
+  if (!wait_until_open (self))
+    return;
+
+  page = g_ptr_array_new_with_free_func (g_free);
+
+  while (more)
+    {
+      guint i;
+
+      conn = acquire_reader (self);
+      if (conn == NULL)
+        break;
+
+      stmt = get_statement (conn, STMT_SELECT_ENTRIES);
+      sqlite3_bind_int64 (stmt, 1, last_id);
+      sqlite3_bind_int (stmt, 2, FOREACH_PAGE_SIZE);
+
+      while ((rc = sqlite3_step (stmt)) == SQLITE_ROW)
+        {
+          last_id = sqlite3_column_int64 (stmt, 0);
+          g_ptr_array_add (page, g_strdup ((const gchar *) sqlite3_column_text (stmt, 1)));
+          g_ptr_array_add (page, g_strdup ((const gchar *) sqlite3_column_text (stmt, 2)));
+        }
+
+      if (rc != SQLITE_DONE)
+        set_error (conn, &error);
+
+      sqlite3_reset (stmt);
+      sqlite3_clear_bindings (stmt);
+
+      release_reader (self, conn);
+
+      if (error)
+        {
+          g_warning ("reading translations failed: %s", error->message);
+          g_error_free (error);
+          break;
+        }
+
+      /* A short page is the last one */
+      more = page->len == FOREACH_PAGE_SIZE * 2;
+
+      for (i = 0; i < page->len; i += 2)
+        if (!func (g_ptr_array_index (page, i),
+                   g_ptr_array_index (page, i + 1),
+                   user_data))
+          {
+            more = FALSE;
+            break;
+          }
+
+      g_ptr_array_set_size (page, 0);
+    }
+
+  g_ptr_array_unref (page);
+}
+
+static gboolean
+maintenance_exec (sqlite3      *db,
+                  const gchar  *sql,
+                  GError      **error)
+{
+  gchar *message = NULL;
+
+  if (sqlite3_exec (db, sql, NULL, NULL, &message) != SQLITE_OK)
+    {
+      g_set_error (error, GTR_SQLITE_ERROR, sqlite3_extended_errcode (db),
+                   "\"%s\" failed: %s", sql, message);
+      sqlite3_free (message);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Size of the database including the write ahead log */
+static gint64
+get_database_size (const gchar *filename)
+{
+  GStatBuf buf;
+  gchar *wal;
+  gint64 size = 0;
+
+  if (g_stat (filename, &buf) == 0)
+    size += buf.st_size;
+
+  wal = g_strconcat (filename, "-wal", NULL);
+  if (g_stat (wal, &buf) == 0)
+    size += buf.st_size;
+  g_free (wal);
+
+  return size;
+}
+
+/*
+ * The maintenance uses its own connection, so the lookups made by the
+ * readers keep reading the last committed state from the write ahead
+ * log instead of waiting for the vacuum.
+ */
+static gboolean
+gtr_sqlite_maintain (GtrTranslationMemory  *tm,
+                     GCancellable          *cancellable,
+                     gint64                *reclaimed,
+                     GError               **error)
+{
+  GtrSqlite *self = GTR_SQLITE (tm);
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  sqlite3 *db = NULL;
+  gboolean result = TRUE;
+  gint64 size;
+  gint i;
+
+  if (!wait_until_open (self))
+    return TRUE;
+
+  size = get_database_size (priv->filename);
+
+  if (sqlite3_open_v2 (priv->filename, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK)
+    {
+      g_set_error_literal (error, GTR_SQLITE_ERROR,
+                           db ? sqlite3_extended_errcode (db) : SQLITE_CANTOPEN,
+                           db ? sqlite3_errmsg (db) : "cannot open database");
+      sqlite3_close (db);
+      return FALSE;
+    }
+
+  sqlite3_busy_timeout (db, 5000);
+
+  result = maintenance_exec (db, "begin immediate", error);
+
+  for (i = 0; result && maintenance_sql[i] != NULL; i++)
+    result = !g_cancellable_set_error_if_cancelled (cancellable, error) &&
+             maintenance_exec (db, maintenance_sql[i], error);
+
+  /* Merges the segments of the full text index */
+  if (result && priv->full_text_search)
+    result = maintenance_exec (db, "insert into ORIG_FTS (ORIG_FTS) values ('optimize')",
+                               error);
+
+  if (result)
+    result = maintenance_exec (db, "commit", error);
+  else
+    sqlite3_exec (db, "rollback", NULL, NULL, NULL);
+
+  if (result)
+    result = !g_cancellable_set_error_if_cancelled (cancellable, error) &&
+             maintenance_exec (db, "reindex", error) &&
+             !g_cancellable_set_error_if_cancelled (cancellable, error) &&
+             maintenance_exec (db, "vacuum", error) &&
+             maintenance_exec (db, "pragma wal_checkpoint(truncate)", error) &&
+             maintenance_exec (db, "analyze", error);
+
+  sqlite3_close (db);
+
+  if (reclaimed != NULL)
+    *reclaimed = MAX (size - get_database_size (priv->filename), 0);
+
+  return result;
+}
+
+static gboolean
+gtr_sqlite_is_open (GtrTranslationMemory *tm)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (GTR_SQLITE (tm));
+
+  return g_atomic_int_get (&priv->opened);
+}
+
+static void
+gtr_translation_memory_iface_init (GtrTranslationMemoryInterface * iface)
+{
+  iface->store = gtr_sqlite_store;
+  iface->store_list = gtr_sqlite_store_list;
+  iface->remove = gtr_sqlite_remove;
+  iface->lookup = gtr_sqlite_lookup;
+  iface->set_max_omits = gtr_sqlite_set_max_omits;
+  iface->set_max_delta = gtr_sqlite_set_max_delta;
+  iface->set_max_items = gtr_sqlite_set_max_items;
+  iface->get_file_stamp = gtr_sqlite_get_file_stamp;
+  iface->set_file_stamp = gtr_sqlite_set_file_stamp;
+  iface->store_file = gtr_sqlite_store_file;
+  iface->foreach = gtr_sqlite_foreach;
+  iface->maintain = gtr_sqlite_maintain;
+  iface->is_open = gtr_sqlite_is_open;
+}
+
+static void
+exec_sql (sqlite3 *db, const gchar *sql)
+{
+  gchar *message = NULL;
+
+  if (sqlite3_exec (db, sql, NULL, NULL, &message) != SQLITE_OK)
+    {
+      g_warning ("gtr-sqlite.c: \"%s\" failed: %s", sql, message);
+      sqlite3_free (message);
+    }
+}
+
+/* Returns the number of objects of @type in the schema whose name
+ * starts with @prefix */
+static gint
+count_schema_objects (sqlite3     *db,
+                      const gchar *type,
+                      const gchar *prefix)
+{
+  sqlite3_stmt *stmt;
+  gint count = 0;
+
+  if (sqlite3_prepare_v2 (db,
+                          "select count(*) from sqlite_master "
+                          "where type=?1 and substr(name, 1, length(?2))=?2",
+                          -1, &stmt, NULL) != SQLITE_OK)
+    return 0;
+
+  sqlite3_bind_text (stmt, 1, type, -1, SQLITE_STATIC);
+  sqlite3_bind_text (stmt, 2, prefix, -1, SQLITE_STATIC);
+  if (sqlite3_step (stmt) == SQLITE_ROW)
+    count = sqlite3_column_int (stmt, 0);
+  sqlite3_finalize (stmt);
+
+  return count;
+}
+
+static gboolean
+create_full_text_index (sqlite3 *db)
+{
+  gchar *message = NULL;
+  gint i;
+
+  /* The triggers are missing if the database was opened without full
+   * text search since the index was created, so it is stale */
+  if (count_schema_objects (db, "table", "ORIG_FTS") > 0)
+    {
+      if (count_schema_objects (db, "trigger", "ORIG_FTS_") ==
+          (gint) G_N_ELEMENTS (fts_schema_sql) - 1)
+        return TRUE;
+    }
+  /* The trigram tokenizer needs SQLite 3.34 built with FTS5 */
+  else if (sqlite3_exec (db,
+                         "create virtual table ORIG_FTS using fts5 ("
+                         "VALUE, content='ORIG', content_rowid='ID', "
+                         "tokenize='trigram')",
+                         NULL, NULL, &message) != SQLITE_OK)
+    {
+      g_warning ("Full text search is not available, "
+                 "using the word index instead: %s", message);
+      sqlite3_free (message);
+      return FALSE;
+    }
+
+  for (i = 0; fts_schema_sql[i] != NULL; i++)
+    exec_sql (db, fts_schema_sql[i]);
+
+  /* Indexes the originals stored while there were no triggers */
+  exec_sql (db, "insert into ORIG_FTS (ORIG_FTS) values ('rebuild')");
+
+  return TRUE;
+}
+
+static gint
+get_user_version (sqlite3 *db)
+{
+  sqlite3_stmt *stmt;
+  gint version = 0;
+
+  if (sqlite3_prepare_v2 (db, "pragma user_version", -1, &stmt, NULL) != SQLITE_OK)
+    return 0;
+
+  if (sqlite3_step (stmt) == SQLITE_ROW)
+    version = sqlite3_column_int (stmt, 0);
+  sqlite3_finalize (stmt);
+
+  return version;
+}
+
+/*
+ * Adds the words of the originals that have none, the ones stored in full
+ * text search mode. It is done once after every switch, a page of
+ * originals at a time as the links are inserted while reading ORIG.
+ */
+static void
+index_missing_words (GtrSqliteConnection *conn)
+{
+  sqlite3_stmt *stmt;
+  GPtrArray *values;
+  GArray *ids;
+  gint64 last_id = 0;
+  GError *error = NULL;
+  gchar *pragma;
+  guint i;
+
+  if (get_user_version (conn->db) >= GTR_TRANSLATION_MEMORY_WORD_INDEX_VERSION)
+    return;
+
+  if (sqlite3_prepare_v2 (conn->db,
+                          "select ID, VALUE from ORIG where ID>?1 and not exists "
+                          "(select 1 from WORD_ORIG_LINK "
+                          "where WORD_ORIG_LINK.ORIG_ID=ORIG.ID) "
+                          "order by ID limit ?2",
+                          -1, &stmt, NULL) != SQLITE_OK)
+    return;
+
+  if (!begin_transaction (conn))
+    {
+      sqlite3_finalize (stmt);
+      return;
+    }
+
+  values = g_ptr_array_new_with_free_func (g_free);
+  ids = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  do
+    {
+      g_ptr_array_set_size (values, 0);
+      g_array_set_size (ids, 0);
+
+      sqlite3_bind_int64 (stmt, 1, last_id);
+      sqlite3_bind_int (stmt, 2, FOREACH_PAGE_SIZE);
+      while (sqlite3_step (stmt) == SQLITE_ROW)
+        {
+          last_id = sqlite3_column_int64 (stmt, 0);
+          g_array_append_val (ids, last_id);
+          g_ptr_array_add (values,
+                           g_strdup ((const gchar *) sqlite3_column_text (stmt, 1)));
+        }
+      sqlite3_reset (stmt);
+
+      for (i = 0; i < values->len && !error; i++)
+        {
+          gchar **words;
+          gsize j;
+
+          words = gtr_gda_utils_split_string_in_unique_words (g_ptr_array_index (values, i));
+          for (j = 0; words[j] != NULL && !error; j++)
+            gtr_sqlite_words_append (conn, words[j],
+                                     g_array_index (ids, gint64, i), &error);
+          g_free (words);
+        }
+    }
+  while (values->len > 0 && !error);
+
+  sqlite3_finalize (stmt);
+  g_ptr_array_unref (values);
+  g_array_unref (ids);
+
+  if (error)
+    {
+      g_warning ("indexing the words of the originals failed: %s", error->message);
+      g_error_free (error);
+      end_transaction (conn, FALSE);
+      return;
+    }
+
+  pragma = g_strdup_printf ("pragma user_version=%d",
+                            GTR_TRANSLATION_MEMORY_WORD_INDEX_VERSION);
+  exec_sql (conn->db, pragma);
+  g_free (pragma);
+
+  end_transaction (conn, TRUE);
+}
+
+/*
+ * Opens a connection to the database and prepares its statements. Only the
+ * writer creates the schema, it is opened first, and the readers are kept
+ * from writing by query_only.
+ */
+static GtrSqliteConnection *
+connection_open (GtrSqlite *self,
+                 gboolean   reader)
+{
+  GtrSqliteConnection *conn;
+  gchar *pragma;
+  gint rc;
+  gint i;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  conn = g_slice_new0 (GtrSqliteConnection);
+
+  /* Each connection is used by one thread at a time */
+  rc = sqlite3_open_v2 (priv->filename, &conn->db,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE |
+                        SQLITE_OPEN_NOMUTEX,
+                        NULL);
+
+  if (rc != SQLITE_OK)
+    {
+      g_warning ("Error opening database: %s",
+                 conn->db ? sqlite3_errmsg (conn->db) : sqlite3_errstr (rc));
+      sqlite3_close (conn->db);
+      g_slice_free (GtrSqliteConnection, conn);
+      return NULL;
+    }
+
+  sqlite3_busy_timeout (conn->db, 5000);
+
+  if (reader)
+    {
+      exec_sql (conn->db, "pragma query_only=1");
+    }
+  else
+    {
+      /* The write ahead log lets readers go on while an import commits,
+       * and synchronous=normal is safe with it: only the last transactions
+       * can be lost on power failure, never the database */
+      exec_sql (conn->db, "pragma journal_mode=wal");
+      exec_sql (conn->db, "pragma synchronous=normal");
+    }
+
+  exec_sql (conn->db, "pragma temp_store=memory");
+  exec_sql (conn->db, "pragma cache_size=-16384");
+
+  pragma = g_strdup_printf ("pragma mmap_size=%d", MMAP_SIZE);
+  exec_sql (conn->db, pragma);
+  g_free (pragma);
+
+  if (!reader)
+    {
+      for (i = 0; schema_sql[i] != NULL; i++)
+        exec_sql (conn->db, schema_sql[i]);
+
+      if (priv->full_text_search && !create_full_text_index (conn->db))
+        priv->full_text_search = FALSE;
+
+      /* Inserting into ORIG must not need FTS5, nor pay for an index that
+       * is not searched */
+      if (!priv->full_text_search)
+        for (i = 0; fts_drop_sql[i] != NULL; i++)
+          exec_sql (conn->db, fts_drop_sql[i]);
+    }
+
+  for (i = 0; i < N_STATEMENTS; i++)
+    {
+      if (i == STMT_SELECT_CANDIDATES && !priv->full_text_search)
+        continue;
+
+      if (sqlite3_prepare_v2 (conn->db, statements_sql[i], -1,
+                              &conn->statements[i], NULL) != SQLITE_OK)
+        g_error ("gtr-sqlite.c: connection_open: "
+                 "sqlite3_prepare_v2 failed.\n"
+                 "query: %s\n"
+                 "error message: %s\n",
+                 statements_sql[i],
+                 sqlite3_errmsg (conn->db));
+    }
+
+  conn->lookup_query_cache = g_hash_table_new_full (g_direct_hash,
+                                                    g_direct_equal,
+                                                    NULL,
+                                                    (GDestroyNotify) sqlite3_finalize);
+
+  return conn;
+}
+
+static void
+connection_close (GtrSqliteConnection *conn)
+{
+  gint i;
+
+  g_hash_table_unref (conn->lookup_query_cache);
+
+  for (i = 0; i < N_STATEMENTS; i++)
+    if (conn->statements[i] != NULL)
+      sqlite3_finalize (conn->statements[i]);
+
+  sqlite3_close (conn->db);
+  g_slice_free (GtrSqliteConnection, conn);
+}
+
+/*
+ * Creating the schema, and the full text index the first time, can take a
+ * while, so the writer is opened on a thread of its own instead of when
+ * the object is constructed. Stores wait for it, lookups find nothing
+ * until it is done.
+ */
+static gpointer
+open_thread (gpointer data)
+{
+  GtrSqlite *self = GTR_SQLITE (data);
+  GtrSqliteConnection *writer;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  writer = connection_open (self, FALSE);
+  if (writer != NULL && priv->full_text_search)
+    exec_sql (writer->db, "pragma user_version=0");
+  else if (writer != NULL)
+    index_missing_words (writer);
+
+  g_mutex_lock (&priv->lock);
+  priv->writer = writer;
+  g_atomic_int_set (&priv->opened, TRUE);
+  g_cond_broadcast (&priv->opened_cond);
+  g_mutex_unlock (&priv->lock);
+
+  DEBUG_PRINT ("Opened %s", priv->filename);
+
+  g_object_unref (self);
+
+  return NULL;
+}
+
+static void
+open_database (GtrSqlite *self)
+{
+  gchar *name;
+  gchar *basename;
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  name = gtr_translation_memory_utils_database_name (priv->language);
+  basename = g_strconcat (name, ".db", NULL);
+  priv->filename = g_build_filename (gtr_dirs_get_user_config_dir (),
+                                     basename, NULL);
+  g_free (basename);
+  g_free (name);
+
+  g_thread_unref (g_thread_new ("gtr-sqlite-open", open_thread,
+                                g_object_ref (self)));
+}
+
+static void
+gtr_sqlite_init (GtrSqlite * self)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  priv->max_omits = 0;
+  priv->max_delta = 0;
+  priv->max_items = 0;
+  priv->generation = 1;
+
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->opened_cond);
+  g_mutex_init (&priv->pool_lock);
+  g_cond_init (&priv->pool_cond);
+  g_queue_init (&priv->readers);
+}
+
+static void
+gtr_sqlite_constructed (GObject * object)
+{
+  open_database (GTR_SQLITE (object));
+
+  G_OBJECT_CLASS (gtr_sqlite_parent_class)->constructed (object);
+}
+
+static void
+gtr_sqlite_set_property (GObject * object,
+                         guint prop_id,
+                         const GValue * value,
+                         GParamSpec * pspec)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (GTR_SQLITE (object));
+
+  switch (prop_id)
+    {
+    case PROP_FULL_TEXT_SEARCH:
+      priv->full_text_search = g_value_get_boolean (value);
+      break;
+    case PROP_LANGUAGE:
+      priv->language = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gtr_sqlite_get_property (GObject * object,
+                         guint prop_id,
+                         GValue * value,
+                         GParamSpec * pspec)
+{
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (GTR_SQLITE (object));
+
+  switch (prop_id)
+    {
+    case PROP_FULL_TEXT_SEARCH:
+      g_value_set_boolean (value, priv->full_text_search);
+      break;
+    case PROP_LANGUAGE:
+      g_value_set_string (value, priv->language);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gtr_sqlite_dispose (GObject * object)
+{
+  GtrSqlite *self = GTR_SQLITE (object);
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+  GtrSqliteConnection *conn;
+
+  /* Nobody else holds a reference, so every reader is idle */
+  while ((conn = g_queue_pop_head (&priv->readers)) != NULL)
+    connection_close (conn);
+  priv->n_readers = 0;
+
+  if (priv->writer != NULL)
+    {
+      /* Refreshes the planner statistics of the tables that changed */
+      exec_sql (priv->writer->db, "pragma optimize");
+      connection_close (priv->writer);
+      priv->writer = NULL;
+    }
+
+  G_OBJECT_CLASS (gtr_sqlite_parent_class)->dispose (object);
+}
+
+static void
+gtr_sqlite_finalize (GObject * object)
+{
+  GtrSqlite *self = GTR_SQLITE (object);
+  GtrSqlitePrivate *priv = gtr_sqlite_get_instance_private (self);
+
+  g_free (priv->filename);
+  g_free (priv->language);
+  g_mutex_clear (&priv->lock);
+  g_cond_clear (&priv->opened_cond);
+  g_mutex_clear (&priv->pool_lock);
+  g_cond_clear (&priv->pool_cond);
+
+  G_OBJECT_CLASS (gtr_sqlite_parent_class)->finalize (object);
+}
+
+static void
+gtr_sqlite_class_init (GtrSqliteClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->constructed = gtr_sqlite_constructed;
+  object_class->set_property = gtr_sqlite_set_property;
+  object_class->get_property = gtr_sqlite_get_property;
+  object_class->dispose = gtr_sqlite_dispose;
+  object_class->finalize = gtr_sqlite_finalize;
+
+  g_object_class_install_property (object_class,
+                                   PROP_FULL_TEXT_SEARCH,
+                                   g_param_spec_boolean ("full-text-search",
+                                                         "Full text search",
+                                                         "Whether matches are searched with the FTS5 index",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT_ONLY |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class,
+                                   PROP_LANGUAGE,
+                                   g_param_spec_string ("language",
+                                                        "Language",
+                                                        "Language code of the translations stored",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+}
+
+/**
+ * gtr_sqlite_new:
+ * @full_text_search: whether to search the matches with the FTS5 index
+ * @language: (nullable): language code of the translations stored
+ *
+ * Creates a new #GtrSqlite object, using the database of @language. If
+ * @full_text_search is %TRUE but the SQLite library lacks the FTS5 trigram
+ * tokenizer, the word index is used.
+ *
+ * Returns: a new #GtrSqlite object
+ */
+GtrSqlite *
+gtr_sqlite_new (gboolean     full_text_search,
+                const gchar *language)
+{
+  GtrSqlite *sqlite;
+
+  sqlite = g_object_new (GTR_TYPE_SQLITE,
+                         "full-text-search", full_text_search,
+                         "language", language,
+                         NULL);
+
+  return sqlite;
+}
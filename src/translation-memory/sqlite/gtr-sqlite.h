@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026  GNOME Translation Editor contributors
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SQLITE_BACKEND_H__
+#define __SQLITE_BACKEND_H__
+
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GTR_TYPE_SQLITE		(gtr_sqlite_get_type ())
+#define GTR_SQLITE(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GTR_TYPE_SQLITE, GtrSqlite))
+#define GTR_SQLITE_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), GTR_TYPE_SQLITE, GtrSqliteClass))
+#define GTR_IS_SQLITE(o)	(G_TYPE_CHECK_INSTANCE_TYPE ((o), GTR_TYPE_SQLITE))
+#define GTR_IS_SQLITE_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GTR_TYPE_SQLITE))
+#define GTR_SQLITE_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GTR_TYPE_SQLITE, GtrSqliteClass))
+
+typedef struct _GtrSqlite        GtrSqlite;
+typedef struct _GtrSqliteClass   GtrSqliteClass;
+
+struct _GtrSqlite
+{
+  GObject parent_instance;
+};
+
+struct _GtrSqliteClass
+{
+  GObjectClass parent_class;
+};
+
+GType                   gtr_sqlite_get_type             (void) G_GNUC_CONST;
+
+GtrSqlite              *gtr_sqlite_new                  (gboolean     full_text_search,
+                                                         const gchar *language);
+
+G_END_DECLS
+#endif /* __SQLITE_BACKEND_H__ */